@@ -1,10 +1,32 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_nonuniform_qualifier : require
 
 layout(location = 0) in vec3 fragColor;
+layout(location = 1) flat in uint fragMaterialID;
+layout(location = 2) in vec2 fragTexCoord;
 
 layout(location = 0) out vec4 outColor;
 
+struct Material {
+    vec4 Color;
+    uint TextureIndex;
+};
+
+// Bindless heap, indexed instead of bound per draw
+layout(set = 0, binding = 0) uniform sampler2D u_Textures[];
+layout(std430, set = 0, binding = 1) readonly buffer Materials {
+    Material b_Materials[];
+} u_Buffers[];
+
+layout(set = 1, binding = 0) uniform Frame {
+    vec4 u_View;
+    uint u_MaterialBuffer;
+    float u_DepthScale;
+};
+
 void main() {
-    outColor = vec4(fragColor, 1.0);
+    Material material = u_Buffers[u_MaterialBuffer].b_Materials[fragMaterialID];
+    vec3 texel = texture(u_Textures[nonuniformEXT(material.TextureIndex)], fragTexCoord).rgb;
+    outColor = vec4(fragColor * material.Color.rgb * texel, 1.0);
 }
\ No newline at end of file
@@ -1,12 +1,58 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
-layout(location = 0) in vec2 a_Position;
+layout(location = 0) in vec3 a_Position;
 layout(location = 1) in vec3 a_Color;
+// Octahedral in xy when c_OctahedralNormals is set
+layout(location = 5) in vec3 a_Normal;
+
+// Per instance
+layout(location = 2) in vec4 a_Transform;
+layout(location = 3) in vec4 a_InstanceColor;
+layout(location = 4) in uint a_MaterialID;
 
 layout(location = 0) out vec3 fragColor;
+layout(location = 1) flat out uint fragMaterialID;
+layout(location = 2) out vec2 fragTexCoord;
+
+// The depth pre-pass and the color pass are separate pipelines, the EQUAL test needs them to agree bit for bit
+invariant gl_Position;
+
+// Quantized vertex encodings store normals octahedral encoded
+layout(constant_id = 0) const bool c_OctahedralNormals = false;
+
+// Uniform ring, rewritten every frame at a new dynamic offset
+layout(set = 1, binding = 0) uniform Frame {
+    // xy pan, z zoom
+    vec4 u_View;
+    uint u_MaterialBuffer;
+    float u_DepthScale;
+};
+
+// Per draw, xy offset, z scale, w depth offset
+layout(push_constant) uniform Draw {
+    vec4 u_DrawTransform;
+};
+
+vec3 DecodeOctahedral(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
 
 void main() {
-    gl_Position = vec4(a_Position, 0.0, 1.0);
-    fragColor = a_Color;
+    float s = sin(a_Transform.w);
+    float c = cos(a_Transform.w);
+    vec2 position = mat2(c, s, -s, c) * a_Position.xy * a_Transform.z + a_Transform.xy;
+    position = position * u_DrawTransform.z + u_DrawTransform.xy;
+
+    // Mesh depth spans [0.25, 0.75], the draw's depth offset moves it forward or back
+    float depth = clamp(0.5 - 0.25 * a_Position.z * u_DepthScale + u_DrawTransform.w, 0.0, 1.0);
+
+    gl_Position = vec4((position - u_View.xy) * u_View.z, depth, 1.0);
+    vec3 normal = c_OctahedralNormals ? DecodeOctahedral(a_Normal.xy) : a_Normal;
+    fragColor = a_Color * a_InstanceColor.rgb * (0.5 + 0.5 * abs(normal.z));
+    fragMaterialID = a_MaterialID;
+    fragTexCoord = a_Position.xy + 0.5;
 }
\ No newline at end of file
@@ -0,0 +1,334 @@
+#include "AssetPack.h"
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <filesystem>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#include <Windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+namespace Vulkan {
+
+	static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Asset Pack
+	//////////////////////////////////////////////////////////////////////////////////
+
+	AssetPack::AssetPack(const std::string& path)
+		: m_Path(path)
+	{
+#ifdef _WIN32
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			std::cout << "Failed to open asset pack: " << path << std::endl;
+			return;
+		}
+		m_File = file;
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < (LONGLONG)sizeof(AssetPackHeader))
+		{
+			std::cout << "Asset pack " << path << " is truncated!" << std::endl;
+			Close();
+			return;
+		}
+
+		m_Mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (m_Mapping)
+			m_Data = static_cast<const char*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+
+		m_Size = static_cast<size_t>(fileSize.QuadPart);
+#else
+		m_File = open(path.c_str(), O_RDONLY);
+		if (m_File < 0)
+		{
+			std::cout << "Failed to open asset pack: " << path << std::endl;
+			return;
+		}
+
+		struct stat fileStat;
+		if (fstat(m_File, &fileStat) != 0 || fileStat.st_size < (off_t)sizeof(AssetPackHeader))
+		{
+			std::cout << "Asset pack " << path << " is truncated!" << std::endl;
+			Close();
+			return;
+		}
+
+		m_Size = static_cast<size_t>(fileStat.st_size);
+
+		void* data = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, m_File, 0);
+		if (data != MAP_FAILED)
+			m_Data = static_cast<const char*>(data);
+#endif
+
+		if (!m_Data)
+		{
+			std::cout << "Failed to map asset pack: " << path << std::endl;
+			Close();
+			return;
+		}
+
+		if (!Validate())
+			Close();
+	}
+
+	AssetPack::~AssetPack()
+	{
+		Close();
+	}
+
+	bool AssetPack::Validate()
+	{
+		AssetPackHeader header;
+		std::memcpy(&header, m_Data, sizeof(header));
+
+		if (header.Magic != ASSET_PACK_MAGIC || header.Version != ASSET_PACK_VERSION)
+		{
+			std::cout << m_Path << " is not a version " << ASSET_PACK_VERSION << " asset pack!" << std::endl;
+			return false;
+		}
+
+		uint64_t tocSize = static_cast<uint64_t>(header.AssetCount) * sizeof(AssetPackEntry);
+		if (header.FileSize != m_Size || header.TocOffset % alignof(AssetPackEntry) != 0 || header.TocOffset > m_Size || tocSize > m_Size - header.TocOffset)
+		{
+			std::cout << "Asset pack " << m_Path << " is truncated!" << std::endl;
+			return false;
+		}
+
+		const AssetPackEntry* entries = reinterpret_cast<const AssetPackEntry*>(m_Data + header.TocOffset);
+		for (uint32_t i = 0; i < header.AssetCount; i++)
+		{
+			const AssetPackEntry& entry = entries[i];
+			if (entry.Offset > m_Size || entry.Size > m_Size - entry.Offset || entry.Name[ASSET_NAME_SIZE - 1] != '\0')
+			{
+				std::cout << "Asset pack " << m_Path << " has a corrupt entry [" << i << "]" << std::endl;
+				return false;
+			}
+
+			m_Entries[entry.Name] = &entry;
+		}
+
+		return true;
+	}
+
+	void AssetPack::Close()
+	{
+		m_Entries.clear();
+
+#ifdef _WIN32
+		if (m_Data)
+			UnmapViewOfFile(m_Data);
+		if (m_Mapping)
+			CloseHandle(m_Mapping);
+		if (m_File)
+			CloseHandle(m_File);
+
+		m_Mapping = nullptr;
+		m_File = nullptr;
+#else
+		if (m_Data)
+			munmap(const_cast<char*>(m_Data), m_Size);
+		if (m_File >= 0)
+			close(m_File);
+
+		m_File = -1;
+#endif
+
+		m_Data = nullptr;
+		m_Size = 0;
+	}
+
+	bool AssetPack::Find(const std::string& name, AssetType type, const char*& data, size_t& size) const
+	{
+		auto it = m_Entries.find(name);
+		if (it == m_Entries.end() || it->second->Type != type)
+			return false;
+
+		data = m_Data + it->second->Offset;
+		size = static_cast<size_t>(it->second->Size);
+		return true;
+	}
+
+	bool AssetPack::FindMesh(const std::string& name, MeshAssetView& mesh) const
+	{
+		const char* data;
+		size_t size;
+		if (!Find(name, AssetType::Mesh, data, size))
+			return false;
+
+		MeshAssetHeader header;
+		if (size < sizeof(header))
+			return false;
+		std::memcpy(&header, data, sizeof(header));
+
+		uint64_t vertexBytes = static_cast<uint64_t>(header.VertexCount) * header.VertexStride;
+		uint64_t indexBytes = static_cast<uint64_t>(header.IndexCount) * header.IndexSize;
+
+		if (header.VertexOffset > size || vertexBytes > size - header.VertexOffset || header.IndexOffset > size || indexBytes > size - header.IndexOffset
+			|| (header.IndexSize != sizeof(uint16_t) && header.IndexSize != sizeof(uint32_t)))
+		{
+			std::cout << "Mesh " << name << " in " << m_Path << " is corrupt!" << std::endl;
+			return false;
+		}
+
+		mesh.Vertices = data + header.VertexOffset;
+		mesh.VertexCount = header.VertexCount;
+		mesh.VertexStride = header.VertexStride;
+		mesh.Indices = data + header.IndexOffset;
+		mesh.IndexCount = header.IndexCount;
+		mesh.IndexSize = header.IndexSize;
+
+		return true;
+	}
+
+	bool LoadAsset(const AssetPack* pack, const std::string& path, AssetType type, AssetData& asset)
+	{
+		if (pack && pack->Find(path, type, asset.Data, asset.Size))
+			return true;
+
+		std::ifstream file(path, std::ios::ate | std::ios::binary);
+		if (!file.is_open())
+		{
+			std::cout << "Failed to open file: " << path << std::endl;
+			return false;
+		}
+
+		asset.Storage.resize(static_cast<size_t>(file.tellg()));
+
+		file.seekg(0);
+		file.read(asset.Storage.data(), asset.Storage.size());
+
+		asset.Data = asset.Storage.data();
+		asset.Size = asset.Storage.size();
+		return true;
+	}
+
+	bool IsOlderThanSource(const std::string& path, const std::string& sourcePath)
+	{
+		std::error_code error;
+		auto sourceTime = std::filesystem::last_write_time(sourcePath, error);
+		if (error)
+			return false;
+
+		auto time = std::filesystem::last_write_time(path, error);
+		return !error && time < sourceTime;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Asset Pack Writer
+	//////////////////////////////////////////////////////////////////////////////////
+
+	bool AssetPackWriter::AddFile(const std::string& path, AssetType type)
+	{
+		AssetData asset;
+		if (!LoadAsset(nullptr, path, type, asset))
+			return false;
+
+		m_Assets.push_back({ path, type, std::move(asset.Storage) });
+		return true;
+	}
+
+	void AssetPackWriter::AddAsset(const std::string& name, AssetType type, const void* data, size_t size)
+	{
+		const char* bytes = static_cast<const char*>(data);
+		m_Assets.push_back({ name, type, std::vector<char>(bytes, bytes + size) });
+	}
+
+	void AssetPackWriter::AddMesh(const std::string& name, const void* vertices, uint32_t vertexCount, uint32_t vertexStride, const void* indices, uint32_t indexCount, uint32_t indexSize)
+	{
+		MeshAssetHeader header;
+		header.VertexCount = vertexCount;
+		header.VertexStride = vertexStride;
+		header.IndexCount = indexCount;
+		header.IndexSize = indexSize;
+		header.VertexOffset = AlignUp(sizeof(MeshAssetHeader), ASSET_PACK_ALIGNMENT);
+		header.IndexOffset = AlignUp(header.VertexOffset + static_cast<uint64_t>(vertexCount) * vertexStride, ASSET_PACK_ALIGNMENT);
+
+		std::vector<char> data(static_cast<size_t>(header.IndexOffset + static_cast<uint64_t>(indexCount) * indexSize));
+		std::memcpy(data.data(), &header, sizeof(header));
+		std::memcpy(data.data() + header.VertexOffset, vertices, static_cast<size_t>(vertexCount) * vertexStride);
+		std::memcpy(data.data() + header.IndexOffset, indices, static_cast<size_t>(indexCount) * indexSize);
+
+		m_Assets.push_back({ name, AssetType::Mesh, std::move(data) });
+	}
+
+	bool AssetPackWriter::Write(const std::string& path) const
+	{
+		AssetPackHeader header{};
+		header.Magic = ASSET_PACK_MAGIC;
+		header.Version = ASSET_PACK_VERSION;
+		header.AssetCount = static_cast<uint32_t>(m_Assets.size());
+		header.Alignment = ASSET_PACK_ALIGNMENT;
+
+		std::vector<AssetPackEntry> entries(m_Assets.size());
+
+		uint64_t offset = AlignUp(sizeof(AssetPackHeader), ASSET_PACK_ALIGNMENT);
+		for (size_t i = 0; i < m_Assets.size(); i++)
+		{
+			if (m_Assets[i].Name.size() >= ASSET_NAME_SIZE)
+			{
+				std::cout << "Asset name is too long: " << m_Assets[i].Name << std::endl;
+				return false;
+			}
+
+			std::memset(&entries[i], 0, sizeof(AssetPackEntry));
+			std::memcpy(entries[i].Name, m_Assets[i].Name.c_str(), m_Assets[i].Name.size());
+			entries[i].Type = m_Assets[i].Type;
+			entries[i].Offset = offset;
+			entries[i].Size = m_Assets[i].Data.size();
+
+			offset = AlignUp(offset + m_Assets[i].Data.size(), ASSET_PACK_ALIGNMENT);
+		}
+
+		header.TocOffset = offset;
+		header.FileSize = offset + entries.size() * sizeof(AssetPackEntry);
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			std::cout << "Failed to create asset pack: " << path << std::endl;
+			return false;
+		}
+
+		// Padding is written as zeros up to the next payload
+		auto padTo = [&](uint64_t position)
+		{
+			static const char zeros[ASSET_PACK_ALIGNMENT] = {};
+			uint64_t current = static_cast<uint64_t>(file.tellp());
+			file.write(zeros, static_cast<std::streamsize>(position - current));
+		};
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		for (size_t i = 0; i < m_Assets.size(); i++)
+		{
+			padTo(entries[i].Offset);
+			file.write(m_Assets[i].Data.data(), m_Assets[i].Data.size());
+		}
+
+		padTo(header.TocOffset);
+		file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(AssetPackEntry));
+
+		if (!file.good())
+		{
+			std::cout << "Failed to write asset pack: " << path << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+}
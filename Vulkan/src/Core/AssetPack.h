@@ -0,0 +1,159 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+#define ASSET_PACK_MAGIC 0x4B415056 // "VPAK"
+#define ASSET_PACK_VERSION 1
+// Every payload starts on this boundary, so it can be copied into staging memory or used as
+// SPIR-V code without realigning it
+#define ASSET_PACK_ALIGNMENT 256
+#define ASSET_NAME_SIZE 112
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Pack Format
+	//////////////////////////////////////////////////////////////////////////////////
+
+	enum class AssetType : uint32_t
+	{
+		Blob = 0,
+		Shader,
+		Mesh,
+		Texture
+	};
+
+	// Header, aligned payloads, then the table of contents
+	struct AssetPackHeader
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		uint32_t AssetCount;
+		uint32_t Alignment;
+		uint64_t TocOffset;
+		uint64_t FileSize;
+	};
+
+	struct AssetPackEntry
+	{
+		char Name[ASSET_NAME_SIZE];
+		AssetType Type;
+		uint32_t Reserved;
+		uint64_t Offset;
+		uint64_t Size;
+	};
+
+	// Start of a mesh payload, offsets are relative to it and aligned like the payload
+	struct MeshAssetHeader
+	{
+		uint32_t VertexCount;
+		uint32_t VertexStride;
+		uint32_t IndexCount;
+		uint32_t IndexSize;
+		uint64_t VertexOffset;
+		uint64_t IndexOffset;
+	};
+
+	struct MeshAssetView
+	{
+		const void* Vertices = nullptr;
+		uint32_t VertexCount = 0;
+		uint32_t VertexStride = 0;
+
+		const void* Indices = nullptr;
+		uint32_t IndexCount = 0;
+		uint32_t IndexSize = 0;
+	};
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Asset Pack
+	//////////////////////////////////////////////////////////////////////////////////
+
+	// A baked pack mapped read-only into memory. Lookups return pointers into the mapping,
+	// so assets are copied straight into staging memory and pages are only read when touched
+	class AssetPack
+	{
+	public:
+		AssetPack(const std::string& path);
+		~AssetPack();
+
+		AssetPack(const AssetPack&) = delete;
+		AssetPack& operator=(const AssetPack&) = delete;
+
+		bool IsOpen() const { return m_Data != nullptr; }
+
+		// Valid for as long as the pack is open
+		bool Find(const std::string& name, AssetType type, const char*& data, size_t& size) const;
+		bool FindMesh(const std::string& name, MeshAssetView& mesh) const;
+
+		uint32_t GetAssetCount() const { return static_cast<uint32_t>(m_Entries.size()); }
+		size_t GetSize() const { return m_Size; }
+
+	private:
+		bool Validate();
+		void Close();
+
+	private:
+		std::string m_Path;
+
+		const char* m_Data = nullptr;
+		size_t m_Size = 0;
+
+#ifdef _WIN32
+		void* m_File = nullptr;
+		void* m_Mapping = nullptr;
+#else
+		int m_File = -1;
+#endif
+
+		std::unordered_map<std::string, const AssetPackEntry*> m_Entries;
+	};
+
+	// Bytes of one asset, viewed in a pack when it has the asset and read from the loose file otherwise
+	struct AssetData
+	{
+		const char* Data = nullptr;
+		size_t Size = 0;
+
+		std::vector<char> Storage;
+
+		explicit operator bool() const { return Data != nullptr; }
+	};
+
+	// Pack entries are named by their path relative to the working directory, pack may be null
+	bool LoadAsset(const AssetPack* pack, const std::string& path, AssetType type, AssetData& asset);
+
+	// True when a loose file was built before its source last changed, a missing source never is
+	bool IsOlderThanSource(const std::string& path, const std::string& sourcePath);
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Asset Pack Writer
+	//////////////////////////////////////////////////////////////////////////////////
+
+	// Offline side, collects assets in memory and lays them out once
+	class AssetPackWriter
+	{
+	public:
+		bool AddFile(const std::string& path, AssetType type);
+		void AddAsset(const std::string& name, AssetType type, const void* data, size_t size);
+		void AddMesh(const std::string& name, const void* vertices, uint32_t vertexCount, uint32_t vertexStride, const void* indices, uint32_t indexCount, uint32_t indexSize);
+
+		bool Write(const std::string& path) const;
+
+		uint32_t GetAssetCount() const { return static_cast<uint32_t>(m_Assets.size()); }
+
+	private:
+		struct PendingAsset
+		{
+			std::string Name;
+			AssetType Type;
+			std::vector<char> Data;
+		};
+
+		std::vector<PendingAsset> m_Assets;
+	};
+
+}
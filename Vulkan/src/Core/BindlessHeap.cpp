@@ -0,0 +1,192 @@
+#include "BindlessHeap.h"
+
+#include <iostream>
+#include <algorithm>
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Bindless Heap
+	//////////////////////////////////////////////////////////////////////////////////
+
+	BindlessHeap::BindlessHeap(VkPhysicalDevice physicalDevice, VkDevice device, QueueTimeline& graphicsTimeline)
+		: m_Device(device), m_GraphicsTimeline(graphicsTimeline)
+	{
+		VkPhysicalDeviceVulkan12Properties properties12{};
+		properties12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+
+		VkPhysicalDeviceProperties2 properties2{};
+		properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties2.pNext = &properties12;
+		vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+
+		m_Textures.Capacity = std::min<uint32_t>(BINDLESS_MAX_TEXTURES, std::min(properties12.maxPerStageDescriptorUpdateAfterBindSampledImages, properties12.maxDescriptorSetUpdateAfterBindSampledImages));
+		m_Buffers.Capacity = std::min<uint32_t>(BINDLESS_MAX_BUFFERS, std::min(properties12.maxPerStageDescriptorUpdateAfterBindStorageBuffers, properties12.maxDescriptorSetUpdateAfterBindStorageBuffers));
+
+		VkDescriptorSetLayoutBinding bindings[2]{};
+		bindings[0].binding = BINDLESS_TEXTURE_BINDING;
+		bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		bindings[0].descriptorCount = m_Textures.Capacity;
+		bindings[0].stageFlags = VK_SHADER_STAGE_ALL_GRAPHICS | VK_SHADER_STAGE_COMPUTE_BIT;
+
+		bindings[1].binding = BINDLESS_BUFFER_BINDING;
+		bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[1].descriptorCount = m_Buffers.Capacity;
+		bindings[1].stageFlags = VK_SHADER_STAGE_ALL_GRAPHICS | VK_SHADER_STAGE_COMPUTE_BIT;
+
+		// Unwritten slots are fine as long as no shader reads them
+		VkDescriptorBindingFlags bindingFlags[2];
+		bindingFlags[0] = bindingFlags[1] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+		bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+		bindingFlagsInfo.bindingCount = 2;
+		bindingFlagsInfo.pBindingFlags = bindingFlags;
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo{};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.pNext = &bindingFlagsInfo;
+		layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+		layoutInfo.bindingCount = 2;
+		layoutInfo.pBindings = bindings;
+
+		if (vkCreateDescriptorSetLayout(m_Device, &layoutInfo, nullptr, &m_SetLayout) != VK_SUCCESS)
+			std::cout << "Failed to create bindless descriptor set layout!" << std::endl;
+
+		VkDescriptorPoolSize poolSizes[2];
+		poolSizes[0] = { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_Textures.Capacity };
+		poolSizes[1] = { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, m_Buffers.Capacity };
+
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+		poolInfo.maxSets = 1;
+		poolInfo.poolSizeCount = 2;
+		poolInfo.pPoolSizes = poolSizes;
+
+		if (vkCreateDescriptorPool(m_Device, &poolInfo, nullptr, &m_Pool) != VK_SUCCESS)
+			std::cout << "Failed to create bindless descriptor pool!" << std::endl;
+
+		VkDescriptorSetAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = m_Pool;
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts = &m_SetLayout;
+
+		if (vkAllocateDescriptorSets(m_Device, &allocInfo, &m_Set) != VK_SUCCESS)
+			std::cout << "Failed to allocate bindless descriptor set!" << std::endl;
+	}
+
+	BindlessHeap::~BindlessHeap()
+	{
+		vkDestroyDescriptorPool(m_Device, m_Pool, nullptr);
+		vkDestroyDescriptorSetLayout(m_Device, m_SetLayout, nullptr);
+	}
+
+	uint32_t BindlessHeap::AddTexture(VkImageView view, VkSampler sampler)
+	{
+		uint32_t index = Allocate(m_Textures);
+		if (index == INVALID_BINDLESS_INDEX)
+		{
+			std::cout << "Bindless heap is out of texture slots!" << std::endl;
+			return index;
+		}
+
+		VkDescriptorImageInfo imageInfo{};
+		imageInfo.sampler = sampler;
+		imageInfo.imageView = view;
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+		VkWriteDescriptorSet write{};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = m_Set;
+		write.dstBinding = BINDLESS_TEXTURE_BINDING;
+		write.dstArrayElement = index;
+		write.descriptorCount = 1;
+		write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		write.pImageInfo = &imageInfo;
+
+		vkUpdateDescriptorSets(m_Device, 1, &write, 0, nullptr);
+		return index;
+	}
+
+	uint32_t BindlessHeap::AddBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+	{
+		uint32_t index = Allocate(m_Buffers);
+		if (index == INVALID_BINDLESS_INDEX)
+		{
+			std::cout << "Bindless heap is out of buffer slots!" << std::endl;
+			return index;
+		}
+
+		VkDescriptorBufferInfo bufferInfo{};
+		bufferInfo.buffer = buffer;
+		bufferInfo.offset = offset;
+		bufferInfo.range = range;
+
+		VkWriteDescriptorSet write{};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = m_Set;
+		write.dstBinding = BINDLESS_BUFFER_BINDING;
+		write.dstArrayElement = index;
+		write.descriptorCount = 1;
+		write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		write.pBufferInfo = &bufferInfo;
+
+		vkUpdateDescriptorSets(m_Device, 1, &write, 0, nullptr);
+		return index;
+	}
+
+	void BindlessHeap::Update()
+	{
+		uint64_t completedValue = m_GraphicsTimeline.GetCompletedValue();
+		Recycle(m_Textures, completedValue);
+		Recycle(m_Buffers, completedValue);
+	}
+
+	void BindlessHeap::CmdBind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout layout) const
+	{
+		vkCmdBindDescriptorSets(commandBuffer, bindPoint, layout, BINDLESS_SET, 1, &m_Set, 0, nullptr);
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Slots
+	//////////////////////////////////////////////////////////////////////////////////
+
+	uint32_t BindlessHeap::Allocate(SlotAllocator& slots)
+	{
+		if (!slots.FreeSlots.empty())
+		{
+			uint32_t index = slots.FreeSlots.back();
+			slots.FreeSlots.pop_back();
+			return index;
+		}
+
+		return slots.Next < slots.Capacity ? slots.Next++ : INVALID_BINDLESS_INDEX;
+	}
+
+	void BindlessHeap::Retire(SlotAllocator& slots, uint32_t index)
+	{
+		// Frames recorded up to now may still read the slot
+		if (index != INVALID_BINDLESS_INDEX)
+			slots.RetiredSlots.push_back({ index, m_GraphicsTimeline.GetSubmittedValue() });
+	}
+
+	void BindlessHeap::Recycle(SlotAllocator& slots, uint64_t completedValue)
+	{
+		for (size_t i = 0; i < slots.RetiredSlots.size();)
+		{
+			if (slots.RetiredSlots[i].RetireValue <= completedValue)
+			{
+				slots.FreeSlots.push_back(slots.RetiredSlots[i].Index);
+				slots.RetiredSlots[i] = slots.RetiredSlots.back();
+				slots.RetiredSlots.pop_back();
+			}
+			else
+			{
+				i++;
+			}
+		}
+	}
+
+}
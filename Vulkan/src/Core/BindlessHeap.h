@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+
+#include "QueueTimeline.h"
+
+#define BINDLESS_MAX_TEXTURES 16384
+#define BINDLESS_MAX_BUFFERS 1024
+
+// Set 0 of every pipeline that uses the heap
+#define BINDLESS_SET 0
+#define BINDLESS_TEXTURE_BINDING 0
+#define BINDLESS_BUFFER_BINDING 1
+
+#define INVALID_BINDLESS_INDEX UINT32_MAX
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Bindless Heap
+	//////////////////////////////////////////////////////////////////////////////////
+
+	// One global descriptor set holding every sampled texture and storage buffer, bound once per
+	// command buffer and indexed by the shaders. Slots are written while frames using other slots
+	// are in flight, a removed slot is only reused once the frames submitted before its removal completed
+	class BindlessHeap
+	{
+	public:
+		BindlessHeap(VkPhysicalDevice physicalDevice, VkDevice device, QueueTimeline& graphicsTimeline);
+		~BindlessHeap();
+
+		// INVALID_BINDLESS_INDEX when the heap is full
+		uint32_t AddTexture(VkImageView view, VkSampler sampler);
+		uint32_t AddBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range);
+
+		void RemoveTexture(uint32_t index) { Retire(m_Textures, index); }
+		void RemoveBuffer(uint32_t index) { Retire(m_Buffers, index); }
+
+		// Recycles slots whose frames completed, call once per frame
+		void Update();
+
+		void CmdBind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout layout) const;
+
+		VkDescriptorSetLayout GetSetLayout() const { return m_SetLayout; }
+		uint32_t GetTextureCapacity() const { return m_Textures.Capacity; }
+		uint32_t GetBufferCapacity() const { return m_Buffers.Capacity; }
+
+	private:
+		struct RetiredSlot
+		{
+			uint32_t Index;
+			uint64_t RetireValue;
+		};
+
+		struct SlotAllocator
+		{
+			uint32_t Capacity = 0;
+			uint32_t Next = 0;
+
+			std::vector<uint32_t> FreeSlots;
+			std::vector<RetiredSlot> RetiredSlots;
+		};
+
+		uint32_t Allocate(SlotAllocator& slots);
+		void Retire(SlotAllocator& slots, uint32_t index);
+		void Recycle(SlotAllocator& slots, uint64_t completedValue);
+
+	private:
+		VkDevice m_Device;
+		QueueTimeline& m_GraphicsTimeline;
+
+		VkDescriptorSetLayout m_SetLayout = VK_NULL_HANDLE;
+		VkDescriptorPool m_Pool = VK_NULL_HANDLE;
+		VkDescriptorSet m_Set = VK_NULL_HANDLE;
+
+		SlotAllocator m_Textures;
+		SlotAllocator m_Buffers;
+	};
+
+}
@@ -0,0 +1,114 @@
+#include "CacheFile.h"
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#include <Windows.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Helpers
+	//////////////////////////////////////////////////////////////////////////////////
+
+	// Closing a stream only hands the data to the OS, it has to reach the disk before the
+	// rename does or a power loss can leave the new name pointing at an empty file
+	static bool SyncFile(const std::string& path)
+	{
+#ifdef _WIN32
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		bool synced = FlushFileBuffers(file) != 0;
+		CloseHandle(file);
+		return synced;
+#else
+		int file = open(path.c_str(), O_WRONLY);
+		if (file < 0)
+			return false;
+
+		bool synced = fsync(file) == 0;
+		close(file);
+		return synced;
+#endif
+	}
+
+	// rename replaces atomically on POSIX, Windows needs MoveFileEx to replace an existing file at all
+	static bool MoveOverFile(const std::string& source, const std::string& destination)
+	{
+#ifdef _WIN32
+		return MoveFileExA(source.c_str(), destination.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+		return std::rename(source.c_str(), destination.c_str()) == 0;
+#endif
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Cache Files
+	//////////////////////////////////////////////////////////////////////////////////
+
+	uint64_t ChecksumData(const void* data, size_t size)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+		uint64_t hash = 14695981039346656037ull;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+
+	bool WriteFileAtomic(const std::string& path, std::initializer_list<FileBlock> blocks)
+	{
+		std::string tempPath = path + ".tmp";
+		{
+			std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+			if (!file.is_open())
+			{
+				std::cout << "Failed to write " << tempPath << "!" << std::endl;
+				return false;
+			}
+
+			for (const FileBlock& block : blocks)
+				file.write(static_cast<const char*>(block.Data), block.Size);
+
+			file.flush();
+			file.close();
+
+			if (file.fail())
+			{
+				std::cout << "Failed to write " << tempPath << "!" << std::endl;
+				std::remove(tempPath.c_str());
+				return false;
+			}
+		}
+
+		if (!SyncFile(tempPath))
+		{
+			std::cout << "Failed to flush " << tempPath << " to disk!" << std::endl;
+			std::remove(tempPath.c_str());
+			return false;
+		}
+
+		if (!MoveOverFile(tempPath, path))
+		{
+			std::cout << "Failed to replace " << path << "!" << std::endl;
+			std::remove(tempPath.c_str());
+			return false;
+		}
+
+		return true;
+	}
+
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+#include <initializer_list>
+#include <cstdint>
+#include <cstddef>
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Cache Files
+	//////////////////////////////////////////////////////////////////////////////////
+
+	struct FileBlock
+	{
+		const void* Data;
+		size_t Size;
+	};
+
+	// FNV-1a, guards cache payloads against truncation and corruption
+	uint64_t ChecksumData(const void* data, size_t size);
+
+	// Writes the blocks to a temporary file next to path, flushes it to disk and then moves it
+	// over path in one step. A crash leaves either the old file or the complete new one
+	bool WriteFileAtomic(const std::string& path, std::initializer_list<FileBlock> blocks);
+
+}
@@ -0,0 +1,332 @@
+#include "DeviceSelector.h"
+#include "CacheFile.h"
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <chrono>
+
+#define DEVICE_PROFILE_MAGIC 0x50445656 // "VVDP"
+#define DEVICE_PROFILE_VERSION 1
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Helpers
+	//////////////////////////////////////////////////////////////////////////////////
+
+	static DeviceProfile IdentifyDevice(const VkPhysicalDeviceProperties& properties)
+	{
+		DeviceProfile profile;
+		memset(&profile, 0, sizeof(profile));
+
+		profile.VendorID = properties.vendorID;
+		profile.DeviceID = properties.deviceID;
+		profile.DriverVersion = properties.driverVersion;
+		profile.ApiVersion = properties.apiVersion;
+		memcpy(profile.PipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+		memcpy(profile.DeviceName, properties.deviceName, VK_MAX_PHYSICAL_DEVICE_NAME_SIZE);
+		profile.DeviceType = properties.deviceType;
+
+		return profile;
+	}
+
+	static bool IsSameDevice(const DeviceProfile& a, const DeviceProfile& b)
+	{
+		return a.VendorID == b.VendorID && a.DeviceID == b.DeviceID && a.DriverVersion == b.DriverVersion && a.ApiVersion == b.ApiVersion
+			&& memcmp(a.PipelineCacheUUID, b.PipelineCacheUUID, VK_UUID_SIZE) == 0;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Initialization
+	//////////////////////////////////////////////////////////////////////////////////
+
+	DeviceSelector::DeviceSelector(VkInstance instance, const std::vector<const char*>& extensions, const std::string& cachePath)
+		: m_Instance(instance), m_Extensions(extensions), m_Path(cachePath)
+	{
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Selection
+	//////////////////////////////////////////////////////////////////////////////////
+
+	VkPhysicalDevice DeviceSelector::Select(VkSurfaceKHR surface, DeviceProfile& profile, uint32_t& presentFamily)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+
+		std::vector<DeviceProfile> cached;
+		if (!m_Path.empty())
+			LoadCache(cached);
+
+		uint32_t deviceCount = 0;
+		vkEnumeratePhysicalDevices(m_Instance, &deviceCount, nullptr);
+
+		if (deviceCount == 0)
+		{
+			std::cout << "Failed to find GPUs with Vulkan support!" << std::endl;
+			return VK_NULL_HANDLE;
+		}
+
+		std::vector<VkPhysicalDevice> devices(deviceCount);
+		vkEnumeratePhysicalDevices(m_Instance, &deviceCount, devices.data());
+
+		// Device properties are all a warm start reads, they identify the cached profile
+		std::vector<DeviceProfile> profiles(deviceCount);
+		uint32_t cachedCount = 0;
+
+		for (uint32_t i = 0; i < deviceCount; i++)
+		{
+			VkPhysicalDeviceProperties properties;
+			vkGetPhysicalDeviceProperties(devices[i], &properties);
+
+			DeviceProfile identity = IdentifyDevice(properties);
+			auto it = std::find_if(cached.begin(), cached.end(), [&](const DeviceProfile& entry) { return IsSameDevice(entry, identity); });
+
+			if (it != cached.end())
+			{
+				profiles[i] = *it;
+				cachedCount++;
+			}
+			else
+			{
+				profiles[i] = Probe(devices[i], properties);
+			}
+		}
+
+		// Use an ordered map to automatically sort candidates by increasing score
+		std::multimap<int, uint32_t> candidates;
+		for (uint32_t i = 0; i < deviceCount; i++)
+		{
+			int score = Score(profiles[i]);
+			if (score > 0)
+				candidates.insert(std::make_pair(score, i));
+			else
+				std::cout << profiles[i].DeviceName << " is missing required features or extensions, skipping it" << std::endl;
+		}
+
+		// Present support depends on the surface, so it is never cached
+		VkPhysicalDevice selected = VK_NULL_HANDLE;
+		for (auto it = candidates.rbegin(); it != candidates.rend(); it++)
+		{
+			uint32_t family = FindPresentFamily(devices[it->second], profiles[it->second], surface);
+			if (family == INVALID_QUEUE_FAMILY)
+				continue;
+
+			selected = devices[it->second];
+			profile = profiles[it->second];
+			presentFamily = family;
+			break;
+		}
+
+		if (!m_Path.empty() && (cachedCount != deviceCount || cached.size() != deviceCount))
+			SaveCache(profiles);
+
+		double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		if (selected != VK_NULL_HANDLE)
+			std::cout << "Device selection: " << profile.DeviceName << ", " << cachedCount << " of " << deviceCount << " profile(s) cached, " << milliseconds << " ms" << std::endl;
+
+		return selected;
+	}
+
+	DeviceProfile DeviceSelector::Probe(VkPhysicalDevice device, const VkPhysicalDeviceProperties& properties) const
+	{
+		DeviceProfile profile = IdentifyDevice(properties);
+
+		// Features, the 1.2 structure may only be chained on devices that support 1.2
+		VkPhysicalDeviceVulkan12Features features12{};
+		features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+		VkPhysicalDeviceFeatures2 features2{};
+		features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features2.pNext = properties.apiVersion >= VK_API_VERSION_1_2 ? &features12 : nullptr;
+		vkGetPhysicalDeviceFeatures2(device, &features2);
+
+		// Frame pacing is built on timeline semaphores, textures and materials live in one update-after-bind set indexed by the shaders
+		profile.TimelineSemaphore = features12.timelineSemaphore;
+		profile.DescriptorIndexing = features12.runtimeDescriptorArray && features12.descriptorBindingPartiallyBound && features12.descriptorBindingUpdateUnusedWhilePending
+			&& features12.descriptorBindingSampledImageUpdateAfterBind && features12.descriptorBindingStorageBufferUpdateAfterBind
+			&& features12.shaderSampledImageArrayNonUniformIndexing;
+
+		profile.DrawIndirectCount = features12.drawIndirectCount;
+		profile.DrawIndirectFirstInstance = features2.features.drawIndirectFirstInstance;
+		profile.TextureCompressionBC = features2.features.textureCompressionBC;
+		profile.PipelineStatistics = features2.features.pipelineStatisticsQuery && features2.features.inheritedQueries;
+
+		// Queue Families
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
+
+		profile.QueueFamilyCount = queueFamilyCount;
+		profile.GraphicsFamily = INVALID_QUEUE_FAMILY;
+		profile.TransferFamily = INVALID_QUEUE_FAMILY;
+		profile.ComputeFamily = INVALID_QUEUE_FAMILY;
+
+		for (uint32_t i = 0; i < queueFamilyCount; i++)
+		{
+			VkQueueFlags flags = queueFamilies[i].queueFlags;
+
+			if (profile.GraphicsFamily == INVALID_QUEUE_FAMILY && (flags & VK_QUEUE_GRAPHICS_BIT))
+				profile.GraphicsFamily = i;
+
+			// Transfer-only families map to the copy engines on discrete GPUs
+			if (profile.TransferFamily == INVALID_QUEUE_FAMILY && (flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+				profile.TransferFamily = i;
+
+			if (profile.ComputeFamily == INVALID_QUEUE_FAMILY && (flags & VK_QUEUE_COMPUTE_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT))
+				profile.ComputeFamily = i;
+		}
+
+		// Memory
+		VkPhysicalDeviceMemoryProperties memoryProperties;
+		vkGetPhysicalDeviceMemoryProperties(device, &memoryProperties);
+
+		for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+		{
+			if (memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+				profile.DeviceLocalBytes = std::max(profile.DeviceLocalBytes, memoryProperties.memoryHeaps[i].size);
+		}
+
+		// Extensions
+		uint32_t extensionCount = 0;
+		vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+		std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+		vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+		std::set<std::string> requiredExtensions(m_Extensions.begin(), m_Extensions.end());
+		for (const auto& extension : availableExtensions)
+			requiredExtensions.erase(extension.extensionName);
+
+		profile.ExtensionsSupported = requiredExtensions.empty();
+
+		return profile;
+	}
+
+	uint32_t DeviceSelector::FindPresentFamily(VkPhysicalDevice device, const DeviceProfile& profile, VkSurfaceKHR surface) const
+	{
+		// Offscreen targets are "presented" by the graphics queue itself
+		if (surface == VK_NULL_HANDLE)
+			return profile.GraphicsFamily;
+
+		// Presenting from the graphics family keeps the swapchain images exclusive
+		VkBool32 presentSupport = VK_FALSE;
+		vkGetPhysicalDeviceSurfaceSupportKHR(device, profile.GraphicsFamily, surface, &presentSupport);
+		if (presentSupport)
+			return profile.GraphicsFamily;
+
+		for (uint32_t i = 0; i < profile.QueueFamilyCount; i++)
+		{
+			vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+			if (presentSupport)
+				return i;
+		}
+
+		return INVALID_QUEUE_FAMILY;
+	}
+
+	int DeviceSelector::Score(const DeviceProfile& profile)
+	{
+		if (profile.ApiVersion < VK_API_VERSION_1_2 || !profile.ExtensionsSupported || !profile.TimelineSemaphore || !profile.DescriptorIndexing
+			|| profile.GraphicsFamily == INVALID_QUEUE_FAMILY)
+			return 0;
+
+		int score = 1;
+
+		// Discrete GPUs have a significant performance advantage
+		if (profile.DeviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
+			score += 1000;
+
+		// Uploads overlap rendering on a copy engine, a compute-only family can run alongside it
+		if (profile.TransferFamily != INVALID_QUEUE_FAMILY)
+			score += 200;
+		if (profile.ComputeFamily != INVALID_QUEUE_FAMILY)
+			score += 100;
+
+		// GPU culling and sampling BC blocks directly
+		if (profile.DrawIndirectCount && profile.DrawIndirectFirstInstance)
+			score += 200;
+		if (profile.TextureCompressionBC)
+			score += 100;
+
+		// A point per 64 MiB of device local memory, the texture budget defaults to half of it
+		score += static_cast<int>(std::min<VkDeviceSize>(profile.DeviceLocalBytes >> 26, 1000));
+
+		return score;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Serialization
+	//////////////////////////////////////////////////////////////////////////////////
+
+	bool DeviceSelector::LoadCache(std::vector<DeviceProfile>& profiles) const
+	{
+		std::ifstream file(m_Path, std::ios::ate | std::ios::binary);
+		if (!file.is_open())
+			return false;
+
+		size_t fileSize = (size_t)file.tellg();
+		if (fileSize < sizeof(FileHeader))
+		{
+			std::cout << "Device profile cache " << m_Path << " is truncated, ignoring it" << std::endl;
+			return false;
+		}
+
+		FileHeader header;
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+		if (header.Magic != DEVICE_PROFILE_MAGIC || header.Version != DEVICE_PROFILE_VERSION || header.ProfileSize != sizeof(DeviceProfile)
+			|| (size_t)header.ProfileCount * sizeof(DeviceProfile) != fileSize - sizeof(FileHeader))
+		{
+			std::cout << "Device profile cache " << m_Path << " has an unknown format, ignoring it" << std::endl;
+			return false;
+		}
+
+		profiles.resize(header.ProfileCount);
+		file.read(reinterpret_cast<char*>(profiles.data()), profiles.size() * sizeof(DeviceProfile));
+
+		if (!file || ChecksumData(profiles.data(), profiles.size() * sizeof(DeviceProfile)) != header.Checksum)
+		{
+			std::cout << "Device profile cache " << m_Path << " is corrupt, ignoring it" << std::endl;
+			profiles.clear();
+			return false;
+		}
+
+		// Extension support was probed for another list
+		if (header.ExtensionsHash != ExtensionsHash())
+		{
+			profiles.clear();
+			return false;
+		}
+
+		return true;
+	}
+
+	bool DeviceSelector::SaveCache(const std::vector<DeviceProfile>& profiles) const
+	{
+		FileHeader header;
+		header.Magic = DEVICE_PROFILE_MAGIC;
+		header.Version = DEVICE_PROFILE_VERSION;
+		header.ProfileCount = static_cast<uint32_t>(profiles.size());
+		header.ProfileSize = sizeof(DeviceProfile);
+		header.ExtensionsHash = ExtensionsHash();
+		header.Checksum = ChecksumData(profiles.data(), profiles.size() * sizeof(DeviceProfile));
+
+		return WriteFileAtomic(m_Path, { { &header, sizeof(header) }, { profiles.data(), profiles.size() * sizeof(DeviceProfile) } });
+	}
+
+	uint64_t DeviceSelector::ExtensionsHash() const
+	{
+		std::string names;
+		for (const char* extension : m_Extensions)
+			names.append(extension).push_back('\0');
+
+		return ChecksumData(names.data(), names.size());
+	}
+
+}
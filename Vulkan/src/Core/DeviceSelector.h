@@ -0,0 +1,94 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <string>
+#include <vector>
+
+#define INVALID_QUEUE_FAMILY UINT32_MAX
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Device Profile
+	//////////////////////////////////////////////////////////////////////////////////
+
+	// What selection and device creation need to know about a physical device. Plain data,
+	// the profile cache stores it as is
+	struct DeviceProfile
+	{
+		// A cached profile is only used while all of the identity matches
+		uint32_t VendorID;
+		uint32_t DeviceID;
+		uint32_t DriverVersion;
+		uint32_t ApiVersion;
+		uint8_t PipelineCacheUUID[VK_UUID_SIZE];
+		char DeviceName[VK_MAX_PHYSICAL_DEVICE_NAME_SIZE];
+		VkPhysicalDeviceType DeviceType;
+
+		// Transfer-only and compute-only families are INVALID_QUEUE_FAMILY when the device has none
+		uint32_t QueueFamilyCount;
+		uint32_t GraphicsFamily;
+		uint32_t TransferFamily;
+		uint32_t ComputeFamily;
+
+		// Required
+		bool ExtensionsSupported;
+		bool TimelineSemaphore;
+		bool DescriptorIndexing;
+
+		// Enabled when supported
+		bool DrawIndirectCount;
+		bool DrawIndirectFirstInstance;
+		bool TextureCompressionBC;
+		bool PipelineStatistics;
+
+		// Largest device local heap
+		VkDeviceSize DeviceLocalBytes;
+	};
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Device Selector
+	//////////////////////////////////////////////////////////////////////////////////
+
+	// Scores every physical device by the features, queues and memory the renderer uses. Probed
+	// profiles are cached on disk, so a warm start only reads the device properties to find them
+	class DeviceSelector
+	{
+	public:
+		// An empty path probes every device on every start
+		DeviceSelector(VkInstance instance, const std::vector<const char*>& extensions, const std::string& cachePath);
+
+		// Highest scoring device that can present to the surface, VK_NULL_HANDLE when none qualifies.
+		// Without a surface the graphics family presents
+		VkPhysicalDevice Select(VkSurfaceKHR surface, DeviceProfile& profile, uint32_t& presentFamily);
+
+	private:
+		struct FileHeader
+		{
+			uint32_t Magic;
+			uint32_t Version;
+			uint32_t ProfileCount;
+			uint32_t ProfileSize;
+			uint64_t ExtensionsHash;
+			uint64_t Checksum;
+		};
+
+		DeviceProfile Probe(VkPhysicalDevice device, const VkPhysicalDeviceProperties& properties) const;
+		uint32_t FindPresentFamily(VkPhysicalDevice device, const DeviceProfile& profile, VkSurfaceKHR surface) const;
+
+		// 0 when a requirement is missing
+		static int Score(const DeviceProfile& profile);
+
+		bool LoadCache(std::vector<DeviceProfile>& profiles) const;
+		bool SaveCache(const std::vector<DeviceProfile>& profiles) const;
+
+		uint64_t ExtensionsHash() const;
+
+	private:
+		VkInstance m_Instance;
+		std::vector<const char*> m_Extensions;
+		std::string m_Path;
+	};
+
+}
@@ -0,0 +1,158 @@
+#include "FramePacer.h"
+
+#include <iostream>
+#include <algorithm>
+#include <thread>
+#include <cmath>
+
+#define MAX_INTERVAL_SAMPLES 8192
+
+// OS sleeps overshoot by up to a scheduler tick, the rest of the wait is spun
+#define SPIN_THRESHOLD std::chrono::microseconds(1500)
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Present Policy
+	//////////////////////////////////////////////////////////////////////////////////
+
+	VkPresentModeKHR ChoosePresentMode(PresentGoal goal, const std::vector<VkPresentModeKHR>& availableModes)
+	{
+		std::vector<VkPresentModeKHR> preferred;
+
+		switch (goal)
+		{
+		case PresentGoal::LowLatency:
+			preferred = { VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR };
+			break;
+		case PresentGoal::Throughput:
+			preferred = { VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR };
+			break;
+		case PresentGoal::AdaptiveVSync:
+			preferred = { VK_PRESENT_MODE_FIFO_RELAXED_KHR };
+			break;
+		case PresentGoal::VSync:
+			break;
+		}
+
+		for (VkPresentModeKHR mode : preferred)
+		{
+			if (std::find(availableModes.begin(), availableModes.end(), mode) != availableModes.end())
+				return mode;
+		}
+
+		return VK_PRESENT_MODE_FIFO_KHR;
+	}
+
+	const char* GetPresentGoalName(PresentGoal goal)
+	{
+		switch (goal)
+		{
+		case PresentGoal::LowLatency:		return "low-latency";
+		case PresentGoal::Throughput:		return "throughput";
+		case PresentGoal::VSync:			return "vsync";
+		case PresentGoal::AdaptiveVSync:	return "adaptive";
+		}
+
+		return "unknown";
+	}
+
+	const char* GetPresentModeName(VkPresentModeKHR mode)
+	{
+		switch (mode)
+		{
+		case VK_PRESENT_MODE_IMMEDIATE_KHR:		return "IMMEDIATE";
+		case VK_PRESENT_MODE_MAILBOX_KHR:		return "MAILBOX";
+		case VK_PRESENT_MODE_FIFO_KHR:			return "FIFO";
+		case VK_PRESENT_MODE_FIFO_RELAXED_KHR:	return "FIFO_RELAXED";
+		default:								return "UNKNOWN";
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Frame Pacer
+	//////////////////////////////////////////////////////////////////////////////////
+
+	FramePacer::FramePacer(double targetFrameRate)
+	{
+		SetTargetFrameRate(targetFrameRate);
+		m_Intervals.reserve(MAX_INTERVAL_SAMPLES);
+	}
+
+	void FramePacer::SetTargetFrameRate(double targetFrameRate)
+	{
+		m_FrameInterval = targetFrameRate > 0.0 ? std::chrono::nanoseconds((int64_t)(1e9 / targetFrameRate)) : std::chrono::nanoseconds(0);
+		m_NextFrameValid = false;
+	}
+
+	void FramePacer::WaitForNextFrame()
+	{
+		if (m_FrameInterval.count() == 0)
+			return;
+
+		Clock::time_point now = Clock::now();
+
+		if (m_NextFrameValid && now < m_NextFrame)
+		{
+			if (m_NextFrame - now > SPIN_THRESHOLD)
+				std::this_thread::sleep_for(m_NextFrame - now - SPIN_THRESHOLD);
+
+			while (Clock::now() < m_NextFrame)
+				std::this_thread::yield();
+		}
+
+		// Deadlines advance on a fixed grid so sleep overshoot doesn't accumulate. After a
+		// long stall the grid restarts instead of running frames back to back to catch up.
+		now = Clock::now();
+		if (!m_NextFrameValid || now - m_NextFrame > m_FrameInterval)
+			m_NextFrame = now;
+
+		m_NextFrame += m_FrameInterval;
+		m_NextFrameValid = true;
+	}
+
+	void FramePacer::OnPresent()
+	{
+		Clock::time_point now = Clock::now();
+
+		if (m_LastPresentValid)
+		{
+			double interval = std::chrono::duration<double, std::milli>(now - m_LastPresent).count();
+
+			if (m_Intervals.size() < MAX_INTERVAL_SAMPLES)
+				m_Intervals.push_back(interval);
+			else
+				m_Intervals[m_IntervalHead] = interval;
+
+			m_IntervalHead = (m_IntervalHead + 1) % MAX_INTERVAL_SAMPLES;
+		}
+
+		m_LastPresent = now;
+		m_LastPresentValid = true;
+	}
+
+	void FramePacer::PrintStats() const
+	{
+		if (m_Intervals.empty())
+			return;
+
+		std::vector<double> sorted = m_Intervals;
+		std::sort(sorted.begin(), sorted.end());
+
+		double mean = 0.0;
+		for (double interval : sorted)
+			mean += interval;
+		mean /= sorted.size();
+
+		double variance = 0.0;
+		for (double interval : sorted)
+			variance += (interval - mean) * (interval - mean);
+		variance /= sorted.size();
+
+		std::cout << "Present-to-present (" << sorted.size() << " frames)" << std::endl;
+		std::cout << "  Interval: avg " << mean << " ms, p50 " << sorted[sorted.size() / 2] << " ms, p99 " << sorted[sorted.size() * 99 / 100]
+			<< " ms, max " << sorted.back() << " ms" << std::endl;
+		std::cout << "  Jitter:   " << std::sqrt(variance) << " ms std dev" << std::endl;
+	}
+
+}
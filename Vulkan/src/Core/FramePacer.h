@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <chrono>
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Present Policy
+	//////////////////////////////////////////////////////////////////////////////////
+
+	enum class PresentGoal
+	{
+		// Newest frame on screen as soon as possible, tearing allowed
+		LowLatency = 0,
+		// Uncapped frame rate without tearing
+		Throughput,
+		// Vertical sync, lowest power
+		VSync,
+		// Vertical sync that tears instead of stuttering when a frame is late
+		AdaptiveVSync
+	};
+
+	// First supported mode of the goal's preference list, FIFO is always available
+	VkPresentModeKHR ChoosePresentMode(PresentGoal goal, const std::vector<VkPresentModeKHR>& availableModes);
+
+	const char* GetPresentGoalName(PresentGoal goal);
+	const char* GetPresentModeName(VkPresentModeKHR mode);
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Frame Pacer
+	//////////////////////////////////////////////////////////////////////////////////
+
+	// CPU frame limiter and present-to-present jitter measurement. The limiter sleeps
+	// before input is sampled, so a capped frame starts with fresh input instead of
+	// sampling early and then blocking in vkAcquireNextImageKHR.
+	class FramePacer
+	{
+	public:
+		// 0 disables the limiter
+		FramePacer(double targetFrameRate = 0.0);
+
+		void SetTargetFrameRate(double targetFrameRate);
+
+		// Sleeps until the next frame is due
+		void WaitForNextFrame();
+
+		// Call right after presenting
+		void OnPresent();
+
+		void PrintStats() const;
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		std::chrono::nanoseconds m_FrameInterval{ 0 };
+		Clock::time_point m_NextFrame;
+		bool m_NextFrameValid = false;
+
+		Clock::time_point m_LastPresent;
+		bool m_LastPresentValid = false;
+
+		// Present-to-present intervals in ms, bounded ring of the latest samples
+		std::vector<double> m_Intervals;
+		size_t m_IntervalHead = 0;
+	};
+
+}
@@ -0,0 +1,234 @@
+#include "GpuCuller.h"
+
+#include <iostream>
+#include <array>
+#include <algorithm>
+
+namespace Vulkan {
+
+	GpuCuller::GpuCuller(VkDevice device, MemoryAllocator& allocator, VkPipelineCache pipelineCache, const void* shaderCode, size_t shaderSize, uint32_t frameCount)
+		: m_Device(device), m_Allocator(allocator)
+	{
+		// Descriptors
+		std::array<VkDescriptorSetLayoutBinding, 3> bindings{};
+		for (uint32_t i = 0; i < bindings.size(); i++)
+		{
+			bindings[i].binding = i;
+			bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			bindings[i].descriptorCount = 1;
+			bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		}
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo{};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+		layoutInfo.pBindings = bindings.data();
+
+		if (vkCreateDescriptorSetLayout(m_Device, &layoutInfo, nullptr, &m_DescriptorSetLayout) != VK_SUCCESS)
+			std::cout << "Failed to create cull descriptor set layout!" << std::endl;
+
+		VkDescriptorPoolSize poolSize{};
+		poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		poolSize.descriptorCount = static_cast<uint32_t>(bindings.size()) * frameCount;
+
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.maxSets = frameCount;
+		poolInfo.poolSizeCount = 1;
+		poolInfo.pPoolSizes = &poolSize;
+
+		if (vkCreateDescriptorPool(m_Device, &poolInfo, nullptr, &m_DescriptorPool) != VK_SUCCESS)
+			std::cout << "Failed to create cull descriptor pool!" << std::endl;
+
+		CreatePipeline(pipelineCache, shaderCode, shaderSize);
+
+		// Per Frame Buffers
+		m_Frames.resize(frameCount);
+		for (auto& frame : m_Frames)
+		{
+			VkDescriptorSetAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+			allocInfo.descriptorPool = m_DescriptorPool;
+			allocInfo.descriptorSetCount = 1;
+			allocInfo.pSetLayouts = &m_DescriptorSetLayout;
+
+			if (vkAllocateDescriptorSets(m_Device, &allocInfo, &frame.DescriptorSet) != VK_SUCCESS)
+				std::cout << "Failed to allocate cull descriptor set!" << std::endl;
+
+			VkBufferCreateInfo bufferInfo{};
+			bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			bufferInfo.size = sizeof(uint32_t);
+			bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+			bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+			if (!m_Allocator.CreateBuffer(bufferInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frame.CountBuffer, frame.CountAllocation))
+				std::cout << "Failed to create draw count buffer!" << std::endl;
+
+			Reserve(frame, CULL_WORKGROUP_SIZE);
+		}
+	}
+
+	GpuCuller::~GpuCuller()
+	{
+		for (auto& frame : m_Frames)
+		{
+			m_Allocator.DestroyBuffer(frame.BoundsBuffer, frame.BoundsAllocation);
+			m_Allocator.DestroyBuffer(frame.DrawBuffer, frame.DrawAllocation);
+			m_Allocator.DestroyBuffer(frame.CountBuffer, frame.CountAllocation);
+		}
+
+		vkDestroyPipeline(m_Device, m_Pipeline, nullptr);
+		vkDestroyPipelineLayout(m_Device, m_PipelineLayout, nullptr);
+		vkDestroyDescriptorPool(m_Device, m_DescriptorPool, nullptr);
+		vkDestroyDescriptorSetLayout(m_Device, m_DescriptorSetLayout, nullptr);
+	}
+
+	void GpuCuller::CreatePipeline(VkPipelineCache pipelineCache, const void* shaderCode, size_t shaderSize)
+	{
+		VkShaderModuleCreateInfo moduleInfo{};
+		moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		moduleInfo.codeSize = shaderSize;
+		moduleInfo.pCode = static_cast<const uint32_t*>(shaderCode);
+
+		VkShaderModule shaderModule;
+		if (vkCreateShaderModule(m_Device, &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS)
+			std::cout << "Failed to create cull shader module!" << std::endl;
+
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(CullParams);
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &m_DescriptorSetLayout;
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+		if (vkCreatePipelineLayout(m_Device, &pipelineLayoutInfo, nullptr, &m_PipelineLayout) != VK_SUCCESS)
+			std::cout << "Failed to create cull pipeline layout!" << std::endl;
+
+		VkComputePipelineCreateInfo pipelineInfo{};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		pipelineInfo.stage.module = shaderModule;
+		pipelineInfo.stage.pName = "main";
+		pipelineInfo.layout = m_PipelineLayout;
+
+		if (vkCreateComputePipelines(m_Device, pipelineCache, 1, &pipelineInfo, nullptr, &m_Pipeline) != VK_SUCCESS)
+			std::cout << "Failed to create cull pipeline!" << std::endl;
+
+		vkDestroyShaderModule(m_Device, shaderModule, nullptr);
+	}
+
+	void GpuCuller::Reserve(FrameBuffers& frame, uint32_t objectCount)
+	{
+		if (frame.Capacity >= objectCount)
+			return;
+
+		if (frame.BoundsBuffer != VK_NULL_HANDLE)
+		{
+			m_Allocator.DestroyBuffer(frame.BoundsBuffer, frame.BoundsAllocation);
+			m_Allocator.DestroyBuffer(frame.DrawBuffer, frame.DrawAllocation);
+		}
+
+		// Bounds are rewritten by the host every frame, the draws never leave the GPU
+		VkBufferCreateInfo bufferInfo{};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = sizeof(ObjectBounds) * objectCount;
+		bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		if (!m_Allocator.CreateBuffer(bufferInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frame.BoundsBuffer, frame.BoundsAllocation))
+			std::cout << "Failed to create bounds buffer!" << std::endl;
+
+		bufferInfo.size = sizeof(VkDrawIndexedIndirectCommand) * objectCount;
+		bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+
+		if (!m_Allocator.CreateBuffer(bufferInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, frame.DrawBuffer, frame.DrawAllocation))
+			std::cout << "Failed to create indirect draw buffer!" << std::endl;
+
+		frame.Capacity = objectCount;
+		WriteDescriptorSet(frame);
+	}
+
+	void GpuCuller::WriteDescriptorSet(FrameBuffers& frame)
+	{
+		VkDescriptorBufferInfo bufferInfos[] = {
+			{ frame.BoundsBuffer, 0, VK_WHOLE_SIZE },
+			{ frame.DrawBuffer, 0, VK_WHOLE_SIZE },
+			{ frame.CountBuffer, 0, VK_WHOLE_SIZE }
+		};
+
+		std::array<VkWriteDescriptorSet, 3> writes{};
+		for (uint32_t i = 0; i < writes.size(); i++)
+		{
+			writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[i].dstSet = frame.DescriptorSet;
+			writes[i].dstBinding = i;
+			writes[i].descriptorCount = 1;
+			writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			writes[i].pBufferInfo = &bufferInfos[i];
+		}
+
+		vkUpdateDescriptorSets(m_Device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+	}
+
+	ObjectBounds* GpuCuller::MapBounds(uint32_t frame, uint32_t objectCount)
+	{
+		FrameBuffers& buffers = m_Frames[frame];
+
+		Reserve(buffers, objectCount);
+		buffers.ObjectCount = objectCount;
+
+		return static_cast<ObjectBounds*>(buffers.BoundsAllocation.MappedData);
+	}
+
+	void GpuCuller::CmdCull(VkCommandBuffer commandBuffer, uint32_t frame, const CullParams& params)
+	{
+		FrameBuffers& buffers = m_Frames[frame];
+
+		// Host writes are made visible to the device by the submission itself
+		m_Allocator.FlushAllocation(buffers.BoundsAllocation, 0, sizeof(ObjectBounds) * buffers.ObjectCount);
+
+		vkCmdFillBuffer(commandBuffer, buffers.CountBuffer, 0, sizeof(uint32_t), 0);
+
+		VkBufferMemoryBarrier clearBarrier{};
+		clearBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		clearBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		clearBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		clearBarrier.buffer = buffers.CountBuffer;
+		clearBarrier.offset = 0;
+		clearBarrier.size = VK_WHOLE_SIZE;
+
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 1, &clearBarrier, 0, nullptr);
+
+		CullParams pushConstants = params;
+		pushConstants.ObjectCount = std::min(params.ObjectCount, buffers.ObjectCount);
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipeline);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout, 0, 1, &buffers.DescriptorSet, 0, nullptr);
+		vkCmdPushConstants(commandBuffer, m_PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullParams), &pushConstants);
+		vkCmdDispatch(commandBuffer, (pushConstants.ObjectCount + CULL_WORKGROUP_SIZE - 1) / CULL_WORKGROUP_SIZE, 1, 1);
+	}
+
+	void GpuCuller::CmdDraw(VkCommandBuffer commandBuffer, uint32_t frame)
+	{
+		const FrameBuffers& buffers = m_Frames[frame];
+
+		vkCmdDrawIndexedIndirectCount(commandBuffer, buffers.DrawBuffer, 0, buffers.CountBuffer, 0, buffers.ObjectCount, sizeof(VkDrawIndexedIndirectCommand));
+	}
+
+	uint32_t GpuCuller::GetVisibleCount(uint32_t frame) const
+	{
+		const FrameBuffers& buffers = m_Frames[frame];
+
+		m_Allocator.InvalidateAllocation(buffers.CountAllocation, 0, sizeof(uint32_t));
+		return *static_cast<const uint32_t*>(buffers.CountAllocation.MappedData);
+	}
+
+}
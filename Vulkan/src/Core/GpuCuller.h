@@ -0,0 +1,93 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "MemoryAllocator.h"
+
+#define CULL_WORKGROUP_SIZE 64
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// GPU Culler
+	//////////////////////////////////////////////////////////////////////////////////
+
+	// Bounding sphere, xyz center and w radius
+	using ObjectBounds = glm::vec4;
+
+	// Matches the push constant block of cull.comp
+	struct CullParams
+	{
+		// Planes face inwards, a point p is inside when dot(plane.xyz, p) + plane.w >= 0
+		glm::vec4 FrustumPlanes[4];
+		uint32_t ObjectCount;
+
+		// Mesh every surviving object is drawn with, object i becomes instance i
+		uint32_t IndexCount;
+		uint32_t FirstIndex;
+		int32_t VertexOffset;
+	};
+
+	// GPU-driven draws. A compute pass tests every object's bounds against the frustum and
+	// appends a VkDrawIndexedIndirectCommand for each survivor, the graphics pass consumes
+	// them with a single vkCmdDrawIndexedIndirectCount. CPU cost is independent of the
+	// object count. Every frame in flight has its own buffers.
+	class GpuCuller
+	{
+	public:
+		GpuCuller(VkDevice device, MemoryAllocator& allocator, VkPipelineCache pipelineCache, const void* shaderCode, size_t shaderSize, uint32_t frameCount);
+		~GpuCuller();
+
+		// Host visible bounds of the frame's objects, valid once the frame's previous submission has completed
+		ObjectBounds* MapBounds(uint32_t frame, uint32_t objectCount);
+
+		// Outside a render pass, before the draw. The caller makes the compute shader's writes visible
+		// to the indirect draw and to the host
+		void CmdCull(VkCommandBuffer commandBuffer, uint32_t frame, const CullParams& params);
+
+		// Inside the render pass, with the mesh's vertex and index buffers bound
+		void CmdDraw(VkCommandBuffer commandBuffer, uint32_t frame);
+
+		// Survivors of the frame's last cull, only meaningful once that frame has completed
+		uint32_t GetVisibleCount(uint32_t frame) const;
+
+	private:
+		struct FrameBuffers
+		{
+			VkBuffer BoundsBuffer = VK_NULL_HANDLE;
+			Allocation BoundsAllocation;
+
+			VkBuffer DrawBuffer = VK_NULL_HANDLE;
+			Allocation DrawAllocation;
+
+			// Host visible, so the visible count can be read back without a copy
+			VkBuffer CountBuffer = VK_NULL_HANDLE;
+			Allocation CountAllocation;
+
+			VkDescriptorSet DescriptorSet = VK_NULL_HANDLE;
+
+			uint32_t Capacity = 0;
+			uint32_t ObjectCount = 0;
+		};
+
+		void CreatePipeline(VkPipelineCache pipelineCache, const void* shaderCode, size_t shaderSize);
+		void Reserve(FrameBuffers& frame, uint32_t objectCount);
+		void WriteDescriptorSet(FrameBuffers& frame);
+
+	private:
+		VkDevice m_Device;
+		MemoryAllocator& m_Allocator;
+
+		VkDescriptorSetLayout m_DescriptorSetLayout = VK_NULL_HANDLE;
+		VkDescriptorPool m_DescriptorPool = VK_NULL_HANDLE;
+		VkPipelineLayout m_PipelineLayout = VK_NULL_HANDLE;
+		VkPipeline m_Pipeline = VK_NULL_HANDLE;
+
+		std::vector<FrameBuffers> m_Frames;
+	};
+
+}
@@ -0,0 +1,751 @@
+#include "MemoryAllocator.h"
+
+#include <iostream>
+#include <algorithm>
+
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////
+// Helpers
+//////////////////////////////////////////////////////////////////////////////////
+
+#define DEFAULT_BLOCK_SIZE (64ull * 1024 * 1024)
+#define SMALL_HEAP_MAX_SIZE (1024ull * 1024 * 1024)
+
+static uint32_t FindLowestBit(uint32_t value)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, value);
+	return index;
+#else
+	return __builtin_ctz(value);
+#endif
+}
+
+static uint32_t FindHighestBit(uint64_t value)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanReverse64(&index, value);
+	return index;
+#else
+	return 63 - __builtin_clzll(value);
+#endif
+}
+
+static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static VkDeviceSize AlignDown(VkDeviceSize value, VkDeviceSize alignment)
+{
+	return value & ~(alignment - 1);
+}
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Memory Block (TLSF)
+	//////////////////////////////////////////////////////////////////////////////////
+
+	MemoryBlock::MemoryBlock(VkDeviceMemory memory, VkDeviceSize size, uint32_t memoryType, void* mappedData)
+		: m_Memory(memory), m_Size(size), m_MemoryType(memoryType), m_MappedData(mappedData)
+	{
+		for (uint32_t fl = 0; fl < FL_COUNT; fl++)
+		{
+			for (uint32_t sl = 0; sl < SL_COUNT; sl++)
+				m_FreeHeads[fl][sl] = INVALID_NODE;
+		}
+
+		uint32_t node = CreateNode();
+		m_Nodes[node].Offset = 0;
+		m_Nodes[node].Size = AlignDown(size, MIN_ALIGNMENT);
+		InsertFree(node);
+	}
+
+	bool MemoryBlock::Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset, uint32_t& node)
+	{
+		size = AlignUp(std::max(size, MIN_ALIGNMENT), MIN_ALIGNMENT);
+		alignment = std::max(alignment, MIN_ALIGNMENT);
+
+		// Free nodes are MIN_ALIGNMENT aligned, so this is the worst case padding
+		VkDeviceSize searchSize = size + alignment - MIN_ALIGNMENT;
+		if (searchSize > m_Size - m_UsedBytes)
+			return false;
+
+		uint32_t index = FindFreeNode(searchSize);
+		if (index == INVALID_NODE)
+			return false;
+
+		RemoveFree(index);
+
+		// Leading padding goes back to the free lists
+		VkDeviceSize alignedOffset = AlignUp(m_Nodes[index].Offset, alignment);
+		VkDeviceSize padding = alignedOffset - m_Nodes[index].Offset;
+
+		if (padding > 0)
+		{
+			uint32_t paddingNode = CreateNode();
+			uint32_t prev = m_Nodes[index].PrevPhysical;
+
+			m_Nodes[paddingNode].Offset = m_Nodes[index].Offset;
+			m_Nodes[paddingNode].Size = padding;
+			m_Nodes[paddingNode].PrevPhysical = prev;
+			m_Nodes[paddingNode].NextPhysical = index;
+
+			if (prev != INVALID_NODE)
+				m_Nodes[prev].NextPhysical = paddingNode;
+
+			m_Nodes[index].PrevPhysical = paddingNode;
+			m_Nodes[index].Offset = alignedOffset;
+			m_Nodes[index].Size -= padding;
+
+			InsertFree(paddingNode);
+		}
+
+		// Split off the remainder
+		VkDeviceSize remainder = m_Nodes[index].Size - size;
+
+		if (remainder >= MIN_ALIGNMENT)
+		{
+			uint32_t remainderNode = CreateNode();
+			uint32_t next = m_Nodes[index].NextPhysical;
+
+			m_Nodes[remainderNode].Offset = m_Nodes[index].Offset + size;
+			m_Nodes[remainderNode].Size = remainder;
+			m_Nodes[remainderNode].PrevPhysical = index;
+			m_Nodes[remainderNode].NextPhysical = next;
+
+			if (next != INVALID_NODE)
+				m_Nodes[next].PrevPhysical = remainderNode;
+
+			m_Nodes[index].NextPhysical = remainderNode;
+			m_Nodes[index].Size = size;
+
+			InsertFree(remainderNode);
+		}
+
+		m_UsedBytes += m_Nodes[index].Size;
+		m_AllocationCount++;
+
+		offset = m_Nodes[index].Offset;
+		node = index;
+
+		return true;
+	}
+
+	void MemoryBlock::Free(uint32_t node)
+	{
+		m_UsedBytes -= m_Nodes[node].Size;
+		m_AllocationCount--;
+
+		// Merge with the previous node
+		uint32_t prev = m_Nodes[node].PrevPhysical;
+		if (prev != INVALID_NODE && m_Nodes[prev].Free)
+		{
+			RemoveFree(prev);
+
+			uint32_t next = m_Nodes[node].NextPhysical;
+			m_Nodes[prev].Size += m_Nodes[node].Size;
+			m_Nodes[prev].NextPhysical = next;
+
+			if (next != INVALID_NODE)
+				m_Nodes[next].PrevPhysical = prev;
+
+			ReleaseNode(node);
+			node = prev;
+		}
+
+		// Merge with the next node
+		uint32_t next = m_Nodes[node].NextPhysical;
+		if (next != INVALID_NODE && m_Nodes[next].Free)
+		{
+			RemoveFree(next);
+
+			uint32_t nextNext = m_Nodes[next].NextPhysical;
+			m_Nodes[node].Size += m_Nodes[next].Size;
+			m_Nodes[node].NextPhysical = nextNext;
+
+			if (nextNext != INVALID_NODE)
+				m_Nodes[nextNext].PrevPhysical = node;
+
+			ReleaseNode(next);
+		}
+
+		InsertFree(node);
+	}
+
+	void MemoryBlock::MappingInsert(VkDeviceSize size, uint32_t& fl, uint32_t& sl) const
+	{
+		if (size < SMALL_BLOCK_SIZE)
+		{
+			fl = 0;
+			sl = static_cast<uint32_t>(size / (SMALL_BLOCK_SIZE / SL_COUNT));
+		}
+		else
+		{
+			uint32_t msb = FindHighestBit(size);
+			sl = static_cast<uint32_t>(size >> (msb - SL_BITS)) ^ SL_COUNT;
+			fl = msb - (SL_BITS + ALIGN_SHIFT) + 1;
+		}
+	}
+
+	uint32_t MemoryBlock::FindFreeNode(VkDeviceSize size) const
+	{
+		// Round up to the next class so any node found there is large enough
+		VkDeviceSize searchSize = size;
+		if (searchSize >= SMALL_BLOCK_SIZE)
+			searchSize += (VkDeviceSize(1) << (FindHighestBit(searchSize) - SL_BITS)) - 1;
+
+		uint32_t fl, sl;
+		MappingInsert(searchSize, fl, sl);
+
+		if (fl < FL_COUNT)
+		{
+			uint32_t slMap = m_SecondLevelBitmap[fl] & (~0u << sl);
+
+			if (!slMap)
+			{
+				uint32_t flMap = fl + 1 < FL_COUNT ? m_FirstLevelBitmap & (~0u << (fl + 1)) : 0;
+
+				if (flMap)
+				{
+					fl = FindLowestBit(flMap);
+					slMap = m_SecondLevelBitmap[fl];
+				}
+			}
+
+			if (slMap)
+				return m_FreeHeads[fl][FindLowestBit(slMap)];
+		}
+
+		// Fall back to walking the exact class, which may still hold a large enough node
+		MappingInsert(size, fl, sl);
+		if (fl >= FL_COUNT)
+			return INVALID_NODE;
+
+		for (uint32_t node = m_FreeHeads[fl][sl]; node != INVALID_NODE; node = m_Nodes[node].NextFree)
+		{
+			if (m_Nodes[node].Size >= size)
+				return node;
+		}
+
+		return INVALID_NODE;
+	}
+
+	void MemoryBlock::InsertFree(uint32_t node)
+	{
+		uint32_t fl, sl;
+		MappingInsert(m_Nodes[node].Size, fl, sl);
+
+		uint32_t head = m_FreeHeads[fl][sl];
+
+		m_Nodes[node].Free = true;
+		m_Nodes[node].PrevFree = INVALID_NODE;
+		m_Nodes[node].NextFree = head;
+
+		if (head != INVALID_NODE)
+			m_Nodes[head].PrevFree = node;
+
+		m_FreeHeads[fl][sl] = node;
+		m_FirstLevelBitmap |= 1u << fl;
+		m_SecondLevelBitmap[fl] |= 1u << sl;
+	}
+
+	void MemoryBlock::RemoveFree(uint32_t node)
+	{
+		uint32_t fl, sl;
+		MappingInsert(m_Nodes[node].Size, fl, sl);
+
+		uint32_t prev = m_Nodes[node].PrevFree;
+		uint32_t next = m_Nodes[node].NextFree;
+
+		if (prev != INVALID_NODE)
+			m_Nodes[prev].NextFree = next;
+		if (next != INVALID_NODE)
+			m_Nodes[next].PrevFree = prev;
+
+		if (m_FreeHeads[fl][sl] == node)
+		{
+			m_FreeHeads[fl][sl] = next;
+
+			if (next == INVALID_NODE)
+			{
+				m_SecondLevelBitmap[fl] &= ~(1u << sl);
+				if (!m_SecondLevelBitmap[fl])
+					m_FirstLevelBitmap &= ~(1u << fl);
+			}
+		}
+
+		m_Nodes[node].Free = false;
+		m_Nodes[node].PrevFree = INVALID_NODE;
+		m_Nodes[node].NextFree = INVALID_NODE;
+	}
+
+	uint32_t MemoryBlock::CreateNode()
+	{
+		if (!m_UnusedNodes.empty())
+		{
+			uint32_t node = m_UnusedNodes.back();
+			m_UnusedNodes.pop_back();
+			m_Nodes[node] = Node();
+			return node;
+		}
+
+		m_Nodes.emplace_back();
+		return static_cast<uint32_t>(m_Nodes.size() - 1);
+	}
+
+	void MemoryBlock::ReleaseNode(uint32_t node)
+	{
+		m_UnusedNodes.push_back(node);
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Initialization and Destruction
+	//////////////////////////////////////////////////////////////////////////////////
+
+	MemoryAllocator::MemoryAllocator(VkPhysicalDevice physicalDevice, VkDevice device)
+		: m_PhysicalDevice(physicalDevice), m_Device(device)
+	{
+		vkGetPhysicalDeviceMemoryProperties(m_PhysicalDevice, &m_MemoryProperties);
+
+		VkPhysicalDeviceProperties deviceProperties;
+		vkGetPhysicalDeviceProperties(m_PhysicalDevice, &deviceProperties);
+
+		m_BufferImageGranularity = deviceProperties.limits.bufferImageGranularity;
+		m_NonCoherentAtomSize = deviceProperties.limits.nonCoherentAtomSize;
+		m_MaxAllocationCount = deviceProperties.limits.maxMemoryAllocationCount;
+	}
+
+	MemoryAllocator::~MemoryAllocator()
+	{
+		if (m_Stats.AllocationCount > 0)
+			std::cout << "Memory allocator destroyed with " << m_Stats.AllocationCount << " live allocations!" << std::endl;
+
+		for (uint32_t type = 0; type < VK_MAX_MEMORY_TYPES; type++)
+		{
+			for (auto& pool : m_Blocks[type])
+			{
+				for (auto& block : pool)
+					FreeDeviceMemory(block->GetMemory(), block->GetMappedData() != nullptr);
+
+				pool.clear();
+			}
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Memory Types
+	//////////////////////////////////////////////////////////////////////////////////
+
+	uint32_t MemoryAllocator::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return LookupMemoryType(typeFilter, required, preferred);
+	}
+
+	uint32_t MemoryAllocator::LookupMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred)
+	{
+		uint64_t key = (uint64_t)typeFilter | ((uint64_t)(required & 0xFFFF) << 32) | ((uint64_t)(preferred & 0xFFFF) << 48);
+
+		auto it = m_MemoryTypeCache.find(key);
+		if (it != m_MemoryTypeCache.end())
+			return it->second;
+
+		// Pick the type matching the most preferred flags
+		uint32_t bestType = UINT32_MAX;
+		int bestScore = -1;
+
+		for (uint32_t i = 0; i < m_MemoryProperties.memoryTypeCount; i++)
+		{
+			VkMemoryPropertyFlags flags = m_MemoryProperties.memoryTypes[i].propertyFlags;
+
+			if (!(typeFilter & (1u << i)) || (flags & required) != required)
+				continue;
+
+			VkMemoryPropertyFlags matched = flags & preferred;
+			int score = 0;
+			for (; matched; matched &= matched - 1)
+				score++;
+
+			if (score > bestScore)
+			{
+				bestScore = score;
+				bestType = i;
+			}
+		}
+
+		m_MemoryTypeCache[key] = bestType;
+		return bestType;
+	}
+
+	VkDeviceSize MemoryAllocator::GetPreferredBlockSize(uint32_t memoryType) const
+	{
+		uint32_t heapIndex = m_MemoryProperties.memoryTypes[memoryType].heapIndex;
+		VkDeviceSize heapSize = m_MemoryProperties.memoryHeaps[heapIndex].size;
+
+		return heapSize <= SMALL_HEAP_MAX_SIZE ? AlignUp(heapSize / 8, 1024) : DEFAULT_BLOCK_SIZE;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Allocation
+	//////////////////////////////////////////////////////////////////////////////////
+
+	Allocation MemoryAllocator::Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred, ResourceKind kind)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		// Without a granularity constraint every resource can share the same blocks
+		if (m_BufferImageGranularity <= 1)
+			kind = ResourceKind::Linear;
+
+		Allocation allocation;
+		uint32_t typeFilter = requirements.memoryTypeBits;
+
+		// Fall back to the next best memory type when one runs out
+		while (true)
+		{
+			uint32_t memoryType = LookupMemoryType(typeFilter, required, preferred);
+			if (memoryType == UINT32_MAX)
+				break;
+
+			// Lazily allocated memory is committed per allocation, a shared block would commit it for every transient attachment in it
+			bool dedicated = requirements.size > GetPreferredBlockSize(memoryType) / 2 || (m_MemoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+
+			if ((!dedicated && AllocateFromBlocks(memoryType, kind, requirements, allocation)) || AllocateDedicated(memoryType, requirements, allocation))
+			{
+				m_Stats.AllocationCount++;
+				m_Stats.TotalAllocations++;
+				return allocation;
+			}
+
+			typeFilter &= ~(1u << memoryType);
+		}
+
+		std::cout << "Failed to allocate device memory! [" << requirements.size << " bytes]" << std::endl;
+		return allocation;
+	}
+
+	void MemoryAllocator::Free(Allocation& allocation)
+	{
+		if (!allocation.IsValid())
+			return;
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		if (allocation.Block)
+		{
+			MemoryBlock* block = allocation.Block;
+			block->Free(allocation.Node);
+
+			// Keep at most one empty block per pool around to avoid thrashing vkAllocateMemory
+			if (block->IsEmpty())
+			{
+				for (auto& pool : m_Blocks[allocation.MemoryType])
+				{
+					auto it = std::find_if(pool.begin(), pool.end(), [block](const std::unique_ptr<MemoryBlock>& b) { return b.get() == block; });
+					if (it == pool.end())
+						continue;
+
+					bool hasOtherEmpty = std::any_of(pool.begin(), pool.end(), [block](const std::unique_ptr<MemoryBlock>& b) { return b.get() != block && b->IsEmpty(); });
+					if (hasOtherEmpty)
+					{
+						FreeDeviceMemory(block->GetMemory(), block->GetMappedData() != nullptr);
+						pool.erase(it);
+					}
+
+					break;
+				}
+			}
+		}
+		else
+		{
+			FreeDeviceMemory(allocation.Memory, allocation.MappedData != nullptr);
+			m_Stats.DedicatedCount--;
+			m_Stats.DedicatedBytes -= allocation.Size;
+		}
+
+		m_Stats.AllocationCount--;
+		m_Stats.TotalFrees++;
+
+		allocation = Allocation();
+	}
+
+	bool MemoryAllocator::AllocateFromBlocks(uint32_t memoryType, ResourceKind kind, const VkMemoryRequirements& requirements, Allocation& allocation)
+	{
+		auto& pool = m_Blocks[memoryType][(int)kind];
+
+		VkDeviceSize offset;
+		uint32_t node;
+		MemoryBlock* target = nullptr;
+
+		// Most recently created blocks are the least fragmented
+		for (auto it = pool.rbegin(); it != pool.rend(); ++it)
+		{
+			if ((*it)->Allocate(requirements.size, requirements.alignment, offset, node))
+			{
+				target = it->get();
+				break;
+			}
+		}
+
+		// New block, shrinking it when the heap is close to full
+		if (!target)
+		{
+			VkDeviceSize blockSize = GetPreferredBlockSize(memoryType);
+
+			for (int attempt = 0; attempt < 4 && blockSize >= requirements.size * 2; attempt++, blockSize /= 2)
+			{
+				VkDeviceMemory memory;
+				void* mappedData;
+
+				if (!AllocateDeviceMemory(blockSize, memoryType, memory, mappedData))
+					continue;
+
+				pool.push_back(std::make_unique<MemoryBlock>(memory, blockSize, memoryType, mappedData));
+				target = pool.back().get();
+
+				// Alignment can still rule out a block twice the size, it would only sit there empty
+				if (!target->Allocate(requirements.size, requirements.alignment, offset, node))
+				{
+					FreeDeviceMemory(memory, mappedData != nullptr);
+					pool.pop_back();
+					target = nullptr;
+				}
+
+				break;
+			}
+		}
+
+		if (!target)
+			return false;
+
+		allocation.Memory = target->GetMemory();
+		allocation.Offset = offset;
+		allocation.Size = requirements.size;
+		allocation.MappedData = target->GetMappedData() ? static_cast<char*>(target->GetMappedData()) + offset : nullptr;
+		allocation.MemoryType = memoryType;
+		allocation.MemoryFlags = m_MemoryProperties.memoryTypes[memoryType].propertyFlags;
+		allocation.Block = target;
+		allocation.Node = node;
+
+		return true;
+	}
+
+	bool MemoryAllocator::AllocateDedicated(uint32_t memoryType, const VkMemoryRequirements& requirements, Allocation& allocation)
+	{
+		VkDeviceMemory memory;
+		void* mappedData;
+
+		if (!AllocateDeviceMemory(requirements.size, memoryType, memory, mappedData))
+			return false;
+
+		allocation.Memory = memory;
+		allocation.Offset = 0;
+		allocation.Size = requirements.size;
+		allocation.MappedData = mappedData;
+		allocation.MemoryType = memoryType;
+		allocation.MemoryFlags = m_MemoryProperties.memoryTypes[memoryType].propertyFlags;
+		allocation.Block = nullptr;
+		allocation.Node = 0;
+
+		m_Stats.DedicatedCount++;
+		m_Stats.DedicatedBytes += requirements.size;
+
+		return true;
+	}
+
+	bool MemoryAllocator::AllocateDeviceMemory(VkDeviceSize size, uint32_t memoryType, VkDeviceMemory& memory, void*& mappedData)
+	{
+		uint32_t liveCount = m_Stats.DedicatedCount;
+		for (auto& pools : m_Blocks)
+			liveCount += static_cast<uint32_t>(pools[0].size() + pools[1].size());
+
+		if (liveCount >= m_MaxAllocationCount)
+		{
+			std::cout << "Reached maxMemoryAllocationCount (" << m_MaxAllocationCount << ")!" << std::endl;
+			return false;
+		}
+
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = size;
+		allocInfo.memoryTypeIndex = memoryType;
+
+		if (vkAllocateMemory(m_Device, &allocInfo, nullptr, &memory) != VK_SUCCESS)
+			return false;
+
+		m_Stats.DeviceMemoryAllocations++;
+
+		// Host visible memory stays mapped for its whole lifetime
+		mappedData = nullptr;
+		if (m_MemoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+		{
+			if (vkMapMemory(m_Device, memory, 0, VK_WHOLE_SIZE, 0, &mappedData) != VK_SUCCESS)
+				std::cout << "Failed to map device memory!" << std::endl;
+		}
+
+		return true;
+	}
+
+	void MemoryAllocator::FreeDeviceMemory(VkDeviceMemory memory, bool mapped)
+	{
+		if (mapped)
+			vkUnmapMemory(m_Device, memory);
+
+		vkFreeMemory(m_Device, memory, nullptr);
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Resources
+	//////////////////////////////////////////////////////////////////////////////////
+
+	bool MemoryAllocator::CreateBuffer(const VkBufferCreateInfo& createInfo, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred, VkBuffer& buffer, Allocation& allocation)
+	{
+		if (vkCreateBuffer(m_Device, &createInfo, nullptr, &buffer) != VK_SUCCESS)
+		{
+			std::cout << "Failed to create buffer!" << std::endl;
+			return false;
+		}
+
+		VkMemoryRequirements memReq;
+		vkGetBufferMemoryRequirements(m_Device, buffer, &memReq);
+
+		allocation = Allocate(memReq, required, preferred, ResourceKind::Linear);
+		if (!allocation.IsValid())
+		{
+			vkDestroyBuffer(m_Device, buffer, nullptr);
+			buffer = VK_NULL_HANDLE;
+			return false;
+		}
+
+		vkBindBufferMemory(m_Device, buffer, allocation.Memory, allocation.Offset);
+		return true;
+	}
+
+	void MemoryAllocator::DestroyBuffer(VkBuffer buffer, Allocation& allocation)
+	{
+		vkDestroyBuffer(m_Device, buffer, nullptr);
+		Free(allocation);
+	}
+
+	bool MemoryAllocator::CreateImage(const VkImageCreateInfo& createInfo, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred, VkImage& image, Allocation& allocation)
+	{
+		if (vkCreateImage(m_Device, &createInfo, nullptr, &image) != VK_SUCCESS)
+		{
+			std::cout << "Failed to create image!" << std::endl;
+			return false;
+		}
+
+		VkMemoryRequirements memReq;
+		vkGetImageMemoryRequirements(m_Device, image, &memReq);
+
+		ResourceKind kind = createInfo.tiling == VK_IMAGE_TILING_OPTIMAL ? ResourceKind::Optimal : ResourceKind::Linear;
+
+		allocation = Allocate(memReq, required, preferred, kind);
+		if (!allocation.IsValid())
+		{
+			vkDestroyImage(m_Device, image, nullptr);
+			image = VK_NULL_HANDLE;
+			return false;
+		}
+
+		vkBindImageMemory(m_Device, image, allocation.Memory, allocation.Offset);
+		return true;
+	}
+
+	void MemoryAllocator::DestroyImage(VkImage image, Allocation& allocation)
+	{
+		vkDestroyImage(m_Device, image, nullptr);
+		Free(allocation);
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Host Access
+	//////////////////////////////////////////////////////////////////////////////////
+
+	VkMappedMemoryRange MemoryAllocator::GetMappedRange(const Allocation& allocation, VkDeviceSize offset, VkDeviceSize size) const
+	{
+		if (size == VK_WHOLE_SIZE)
+			size = allocation.Size - offset;
+
+		VkDeviceSize memorySize = allocation.Block ? allocation.Block->GetSize() : allocation.Size;
+		VkDeviceSize begin = AlignDown(allocation.Offset + offset, m_NonCoherentAtomSize);
+		VkDeviceSize end = AlignUp(allocation.Offset + offset + size, m_NonCoherentAtomSize);
+
+		VkMappedMemoryRange range{};
+		range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+		range.memory = allocation.Memory;
+		range.offset = begin;
+		range.size = end >= memorySize ? VK_WHOLE_SIZE : end - begin;
+
+		return range;
+	}
+
+	void MemoryAllocator::FlushAllocation(const Allocation& allocation, VkDeviceSize offset, VkDeviceSize size)
+	{
+		if (allocation.MemoryFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
+			return;
+
+		VkMappedMemoryRange range = GetMappedRange(allocation, offset, size);
+		vkFlushMappedMemoryRanges(m_Device, 1, &range);
+	}
+
+	void MemoryAllocator::InvalidateAllocation(const Allocation& allocation, VkDeviceSize offset, VkDeviceSize size)
+	{
+		if (allocation.MemoryFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
+			return;
+
+		VkMappedMemoryRange range = GetMappedRange(allocation, offset, size);
+		vkInvalidateMappedMemoryRanges(m_Device, 1, &range);
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Statistics
+	//////////////////////////////////////////////////////////////////////////////////
+
+	AllocatorStats MemoryAllocator::GetStats()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		AllocatorStats stats = m_Stats;
+		stats.BlockCount = 0;
+		stats.BlockBytes = 0;
+		stats.UsedBytes = m_Stats.DedicatedBytes;
+
+		for (auto& pools : m_Blocks)
+		{
+			for (auto& pool : pools)
+			{
+				for (auto& block : pool)
+				{
+					stats.BlockCount++;
+					stats.BlockBytes += block->GetSize();
+					stats.UsedBytes += block->GetUsedBytes();
+				}
+			}
+		}
+
+		return stats;
+	}
+
+	void MemoryAllocator::PrintStats()
+	{
+		AllocatorStats stats = GetStats();
+
+		const double mb = 1024.0 * 1024.0;
+
+		std::cout << "Memory allocator" << std::endl;
+		std::cout << "  Allocations:    " << stats.AllocationCount << " live, " << stats.TotalAllocations << " total, " << stats.TotalFrees << " freed" << std::endl;
+		std::cout << "  Blocks:         " << stats.BlockCount << " (" << stats.BlockBytes / mb << " MB)" << std::endl;
+		std::cout << "  Dedicated:      " << stats.DedicatedCount << " (" << stats.DedicatedBytes / mb << " MB)" << std::endl;
+		std::cout << "  Used:           " << stats.UsedBytes / mb << " MB" << std::endl;
+		std::cout << "  vkAllocateMemory calls: " << stats.DeviceMemoryAllocations << std::endl;
+	}
+
+}
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Allocations
+	//////////////////////////////////////////////////////////////////////////////////
+
+	// Linear and optimal resources live in separate blocks so they never share a
+	// bufferImageGranularity page
+	enum class ResourceKind
+	{
+		Linear = 0,
+		Optimal = 1
+	};
+
+	class MemoryBlock;
+
+	struct Allocation
+	{
+		VkDeviceMemory Memory = VK_NULL_HANDLE;
+		VkDeviceSize Offset = 0;
+		VkDeviceSize Size = 0;
+		void* MappedData = nullptr;
+
+		uint32_t MemoryType = 0;
+		VkMemoryPropertyFlags MemoryFlags = 0;
+
+		// Owning block, nullptr for dedicated allocations
+		MemoryBlock* Block = nullptr;
+		uint32_t Node = 0;
+
+		bool IsValid() const { return Memory != VK_NULL_HANDLE; }
+	};
+
+	struct AllocatorStats
+	{
+		uint32_t BlockCount = 0;
+		uint32_t DedicatedCount = 0;
+		uint32_t AllocationCount = 0;
+
+		VkDeviceSize BlockBytes = 0;
+		VkDeviceSize UsedBytes = 0;
+		VkDeviceSize DedicatedBytes = 0;
+
+		uint64_t TotalAllocations = 0;
+		uint64_t TotalFrees = 0;
+		uint64_t DeviceMemoryAllocations = 0;
+	};
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Memory Block (TLSF)
+	//////////////////////////////////////////////////////////////////////////////////
+
+	class MemoryBlock
+	{
+	public:
+		static constexpr VkDeviceSize MIN_ALIGNMENT = 16;
+		static constexpr uint32_t INVALID_NODE = UINT32_MAX;
+
+	public:
+		MemoryBlock(VkDeviceMemory memory, VkDeviceSize size, uint32_t memoryType, void* mappedData);
+
+		bool Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset, uint32_t& node);
+		void Free(uint32_t node);
+
+		bool IsEmpty() const { return m_AllocationCount == 0; }
+
+		VkDeviceMemory GetMemory() const { return m_Memory; }
+		VkDeviceSize GetSize() const { return m_Size; }
+		VkDeviceSize GetUsedBytes() const { return m_UsedBytes; }
+		uint32_t GetAllocationCount() const { return m_AllocationCount; }
+		uint32_t GetMemoryType() const { return m_MemoryType; }
+		void* GetMappedData() const { return m_MappedData; }
+
+	private:
+		static constexpr uint32_t SL_BITS = 5;
+		static constexpr uint32_t SL_COUNT = 1 << SL_BITS;
+		static constexpr uint32_t ALIGN_SHIFT = 4;
+		static constexpr uint32_t FL_COUNT = 32;
+		static constexpr VkDeviceSize SMALL_BLOCK_SIZE = VkDeviceSize(1) << (SL_BITS + ALIGN_SHIFT);
+
+		struct Node
+		{
+			VkDeviceSize Offset = 0;
+			VkDeviceSize Size = 0;
+
+			uint32_t PrevPhysical = INVALID_NODE;
+			uint32_t NextPhysical = INVALID_NODE;
+			uint32_t PrevFree = INVALID_NODE;
+			uint32_t NextFree = INVALID_NODE;
+
+			bool Free = false;
+		};
+
+		void MappingInsert(VkDeviceSize size, uint32_t& fl, uint32_t& sl) const;
+		uint32_t FindFreeNode(VkDeviceSize size) const;
+
+		void InsertFree(uint32_t node);
+		void RemoveFree(uint32_t node);
+
+		uint32_t CreateNode();
+		void ReleaseNode(uint32_t node);
+
+	private:
+		VkDeviceMemory m_Memory;
+		VkDeviceSize m_Size;
+		uint32_t m_MemoryType;
+		void* m_MappedData;
+
+		VkDeviceSize m_UsedBytes = 0;
+		uint32_t m_AllocationCount = 0;
+
+		uint32_t m_FirstLevelBitmap = 0;
+		uint32_t m_SecondLevelBitmap[FL_COUNT] = {};
+		uint32_t m_FreeHeads[FL_COUNT][SL_COUNT];
+
+		std::vector<Node> m_Nodes;
+		std::vector<uint32_t> m_UnusedNodes;
+	};
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Memory Allocator
+	//////////////////////////////////////////////////////////////////////////////////
+
+	class MemoryAllocator
+	{
+	public:
+		MemoryAllocator(VkPhysicalDevice physicalDevice, VkDevice device);
+		~MemoryAllocator();
+
+		// Returns UINT32_MAX when no memory type satisfies the required flags
+		uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred = 0);
+
+		Allocation Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred = 0, ResourceKind kind = ResourceKind::Linear);
+		void Free(Allocation& allocation);
+
+		bool CreateBuffer(const VkBufferCreateInfo& createInfo, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred, VkBuffer& buffer, Allocation& allocation);
+		void DestroyBuffer(VkBuffer buffer, Allocation& allocation);
+
+		bool CreateImage(const VkImageCreateInfo& createInfo, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred, VkImage& image, Allocation& allocation);
+		void DestroyImage(VkImage image, Allocation& allocation);
+
+		// No-ops for HOST_COHERENT memory
+		void FlushAllocation(const Allocation& allocation, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+		void InvalidateAllocation(const Allocation& allocation, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+
+		AllocatorStats GetStats();
+		void PrintStats();
+
+		const VkPhysicalDeviceMemoryProperties& GetMemoryProperties() const { return m_MemoryProperties; }
+
+	private:
+		uint32_t LookupMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred);
+		VkDeviceSize GetPreferredBlockSize(uint32_t memoryType) const;
+
+		bool AllocateDeviceMemory(VkDeviceSize size, uint32_t memoryType, VkDeviceMemory& memory, void*& mappedData);
+		void FreeDeviceMemory(VkDeviceMemory memory, bool mapped);
+
+		bool AllocateFromBlocks(uint32_t memoryType, ResourceKind kind, const VkMemoryRequirements& requirements, Allocation& allocation);
+		bool AllocateDedicated(uint32_t memoryType, const VkMemoryRequirements& requirements, Allocation& allocation);
+
+		VkMappedMemoryRange GetMappedRange(const Allocation& allocation, VkDeviceSize offset, VkDeviceSize size) const;
+
+	private:
+		VkPhysicalDevice m_PhysicalDevice;
+		VkDevice m_Device;
+
+		VkPhysicalDeviceMemoryProperties m_MemoryProperties;
+		VkDeviceSize m_BufferImageGranularity;
+		VkDeviceSize m_NonCoherentAtomSize;
+		uint32_t m_MaxAllocationCount;
+
+		std::mutex m_Mutex;
+
+		std::vector<std::unique_ptr<MemoryBlock>> m_Blocks[VK_MAX_MEMORY_TYPES][2];
+		std::unordered_map<uint64_t, uint32_t> m_MemoryTypeCache;
+
+		AllocatorStats m_Stats;
+	};
+
+}
@@ -0,0 +1,460 @@
+#include "Mesh.h"
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Mesh Loading
+	//////////////////////////////////////////////////////////////////////////////////
+
+	static const char* SkipSpaces(const char* cursor)
+	{
+		while (*cursor == ' ' || *cursor == '\t')
+			cursor++;
+		return cursor;
+	}
+
+	static glm::vec3 ParseVec3(const char* cursor)
+	{
+		glm::vec3 result(0.0f);
+		char* end;
+
+		for (int i = 0; i < 3; i++)
+		{
+			result[i] = std::strtof(cursor, &end);
+			cursor = end;
+		}
+
+		return result;
+	}
+
+	// OBJ indices are 1-based, negative ones count back from the end. Returns -1 when missing or invalid
+	static int ResolveIndex(long index, size_t count)
+	{
+		long resolved = index > 0 ? index - 1 : (long)count + index;
+		return index != 0 && resolved >= 0 && resolved < (long)count ? (int)resolved : -1;
+	}
+
+	bool LoadObj(const std::string& path, std::vector<ObjVertex>& vertices)
+	{
+		std::ifstream file(path);
+		if (!file.is_open())
+		{
+			std::cout << "Failed to open mesh: " << path << std::endl;
+			return false;
+		}
+
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec3> normals;
+
+		// Position and normal index of every corner of the current face
+		std::vector<std::pair<int, int>> face;
+
+		std::string line;
+		while (std::getline(file, line))
+		{
+			const char* cursor = SkipSpaces(line.c_str());
+
+			if (cursor[0] == 'v' && (cursor[1] == ' ' || cursor[1] == '\t'))
+			{
+				positions.push_back(ParseVec3(cursor + 2));
+			}
+			else if (cursor[0] == 'v' && cursor[1] == 'n' && (cursor[2] == ' ' || cursor[2] == '\t'))
+			{
+				normals.push_back(ParseVec3(cursor + 3));
+			}
+			else if (cursor[0] == 'f' && (cursor[1] == ' ' || cursor[1] == '\t'))
+			{
+				face.clear();
+				cursor += 2;
+
+				// v, v/vt, v//vn or v/vt/vn
+				while (*(cursor = SkipSpaces(cursor)))
+				{
+					char* end;
+					long position = std::strtol(cursor, &end, 10);
+					if (end == cursor)
+						break;
+					cursor = end;
+
+					long normal = 0;
+					if (*cursor == '/')
+					{
+						std::strtol(cursor + 1, &end, 10);
+						cursor = end;
+
+						if (*cursor == '/')
+						{
+							normal = std::strtol(cursor + 1, &end, 10);
+							cursor = end;
+						}
+					}
+
+					face.push_back({ ResolveIndex(position, positions.size()), ResolveIndex(normal, normals.size()) });
+
+					while (*cursor && *cursor != ' ' && *cursor != '\t')
+						cursor++;
+				}
+
+				for (size_t i = 1; i + 1 < face.size(); i++)
+				{
+					const std::pair<int, int> corners[] = { face[0], face[i], face[i + 1] };
+					if (corners[0].first < 0 || corners[1].first < 0 || corners[2].first < 0)
+						continue;
+
+					glm::vec3 p0 = positions[corners[0].first], p1 = positions[corners[1].first], p2 = positions[corners[2].first];
+
+					glm::vec3 faceNormal = glm::cross(p1 - p0, p2 - p0);
+					float length = glm::length(faceNormal);
+					faceNormal = length > 0.0f ? faceNormal / length : glm::vec3(0.0f, 0.0f, 1.0f);
+
+					for (const auto& corner : corners)
+						vertices.push_back({ positions[corner.first], corner.second >= 0 ? normals[corner.second] : faceNormal });
+				}
+			}
+		}
+
+		if (vertices.empty())
+		{
+			std::cout << "Mesh has no triangles: " << path << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Vertex Cache Analysis
+	//////////////////////////////////////////////////////////////////////////////////
+
+	VertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+	{
+		// FIFO cache, a vertex is still cached while fewer than cacheSize vertices were transformed after it
+		std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+		uint32_t timestamp = cacheSize + 1;
+
+		std::vector<bool> used(vertexCount, false);
+		uint32_t uniqueCount = 0;
+
+		VertexCacheStats stats{};
+		for (uint32_t index : indices)
+		{
+			if (timestamp - cacheTimestamps[index] > cacheSize)
+			{
+				cacheTimestamps[index] = timestamp++;
+				stats.Transforms++;
+			}
+
+			if (!used[index])
+			{
+				used[index] = true;
+				uniqueCount++;
+			}
+		}
+
+		size_t triangleCount = indices.size() / 3;
+		stats.ACMR = triangleCount ? (float)stats.Transforms / triangleCount : 0.0f;
+		stats.ATVR = uniqueCount ? (float)stats.Transforms / uniqueCount : 0.0f;
+
+		return stats;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Vertex Cache Optimization
+	//////////////////////////////////////////////////////////////////////////////////
+
+	static float VertexScore(int cachePosition, uint32_t valence)
+	{
+		// No triangles left to emit
+		if (valence == 0)
+			return -1.0f;
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			// The last triangle's vertices score the same, whichever order they were emitted in
+			if (cachePosition < 3)
+				score = 0.75f;
+			else
+				score = std::pow(1.0f - (cachePosition - 3) / (float)(VERTEX_CACHE_SIZE - 3), 1.5f);
+		}
+
+		// Prefers vertices with few triangles left, so they don't get stranded
+		return score + 2.0f / std::sqrt((float)valence);
+	}
+
+	void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount)
+	{
+		uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+		if (triangleCount == 0)
+			return;
+
+		// Triangles using each vertex, the first Valence entries are the ones not emitted yet
+		std::vector<uint32_t> valence(vertexCount, 0);
+		for (uint32_t index : indices)
+			valence[index]++;
+
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+		for (size_t i = 0; i < vertexCount; i++)
+			adjacencyOffsets[i + 1] = adjacencyOffsets[i] + valence[i];
+
+		std::vector<uint32_t> adjacency(indices.size());
+		std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (uint32_t i = 0; i < triangleCount * 3; i++)
+			adjacency[fill[indices[i]]++] = i / 3;
+
+		// Scores
+		std::vector<int> cachePositions(vertexCount, -1);
+		std::vector<float> vertexScores(vertexCount);
+		for (size_t i = 0; i < vertexCount; i++)
+			vertexScores[i] = VertexScore(-1, valence[i]);
+
+		std::vector<float> triangleScores(triangleCount);
+		std::vector<bool> emitted(triangleCount, false);
+		for (uint32_t i = 0; i < triangleCount; i++)
+			triangleScores[i] = vertexScores[indices[i * 3 + 0]] + vertexScores[indices[i * 3 + 1]] + vertexScores[indices[i * 3 + 2]];
+
+		uint32_t best = static_cast<uint32_t>(std::max_element(triangleScores.begin(), triangleScores.end()) - triangleScores.begin());
+		uint32_t scanCursor = 0;
+
+		std::vector<uint32_t> cache, newCache;
+		cache.reserve(VERTEX_CACHE_SIZE + 3);
+		newCache.reserve(VERTEX_CACHE_SIZE + 3);
+
+		std::vector<uint32_t> result;
+		result.reserve(indices.size());
+
+		while (best != UINT32_MAX)
+		{
+			emitted[best] = true;
+			const uint32_t* triangle = &indices[best * 3];
+			result.insert(result.end(), triangle, triangle + 3);
+
+			// Retire the triangle from its vertices' adjacency
+			for (int k = 0; k < 3; k++)
+			{
+				uint32_t* list = &adjacency[adjacencyOffsets[triangle[k]]];
+				uint32_t& count = valence[triangle[k]];
+
+				for (uint32_t i = 0; i < count; i++)
+				{
+					if (list[i] == best)
+					{
+						std::swap(list[i], list[count - 1]);
+						count--;
+						break;
+					}
+				}
+			}
+
+			// The triangle's vertices move to the front, whatever falls past the end is evicted
+			newCache.assign(triangle, triangle + 3);
+			for (uint32_t vertex : cache)
+			{
+				if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+					newCache.push_back(vertex);
+			}
+
+			for (size_t i = 0; i < newCache.size(); i++)
+			{
+				uint32_t vertex = newCache[i];
+				cachePositions[vertex] = i < VERTEX_CACHE_SIZE ? (int)i : -1;
+				vertexScores[vertex] = VertexScore(cachePositions[vertex], valence[vertex]);
+			}
+
+			// Only triangles touching the cache changed score
+			best = UINT32_MAX;
+			float bestScore = -1.0f;
+
+			for (uint32_t vertex : newCache)
+			{
+				const uint32_t* list = &adjacency[adjacencyOffsets[vertex]];
+				for (uint32_t i = 0; i < valence[vertex]; i++)
+				{
+					uint32_t candidate = list[i];
+					float score = vertexScores[indices[candidate * 3 + 0]] + vertexScores[indices[candidate * 3 + 1]] + vertexScores[indices[candidate * 3 + 2]];
+					triangleScores[candidate] = score;
+
+					if (score > bestScore)
+					{
+						bestScore = score;
+						best = candidate;
+					}
+				}
+			}
+
+			if (newCache.size() > VERTEX_CACHE_SIZE)
+				newCache.resize(VERTEX_CACHE_SIZE);
+			cache.swap(newCache);
+
+			// Nothing left around the cache, continue with the next triangle in input order
+			if (best == UINT32_MAX)
+			{
+				while (scanCursor < triangleCount && emitted[scanCursor])
+					scanCursor++;
+
+				if (scanCursor < triangleCount)
+					best = scanCursor;
+			}
+		}
+
+		indices.swap(result);
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Overdraw Optimization
+	//////////////////////////////////////////////////////////////////////////////////
+
+	void OptimizeOverdraw(std::vector<uint32_t>& indices, const void* positions, size_t vertexCount, size_t stride, float threshold)
+	{
+		uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+		if (triangleCount == 0)
+			return;
+
+		auto position = [&](uint32_t vertex)
+		{
+			const float* data = reinterpret_cast<const float*>(static_cast<const char*>(positions) + vertex * stride);
+			return glm::vec3(data[0], data[1], data[2]);
+		};
+
+		// Same FIFO model as AnalyzeVertexCache, advancing the timestamp past the cache size flushes it
+		std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+		uint32_t timestamp = VERTEX_CACHE_ANALYSIS_SIZE + 1;
+
+		auto transformTriangle = [&](uint32_t triangle)
+		{
+			uint32_t misses = 0;
+			for (int k = 0; k < 3; k++)
+			{
+				uint32_t vertex = indices[triangle * 3 + k];
+				if (timestamp - cacheTimestamps[vertex] > VERTEX_CACHE_ANALYSIS_SIZE)
+				{
+					cacheTimestamps[vertex] = timestamp++;
+					misses++;
+				}
+			}
+			return misses;
+		};
+
+		auto flushCache = [&]() { timestamp += VERTEX_CACHE_ANALYSIS_SIZE + 1; };
+
+		// Hard boundaries, where the cache optimizer had to start over anyway
+		std::vector<uint32_t> hardClusters;
+		for (uint32_t i = 0; i < triangleCount; i++)
+		{
+			if (transformTriangle(i) == 3)
+				hardClusters.push_back(i);
+		}
+		hardClusters.push_back(triangleCount);
+
+		// Soft boundaries, split wherever the piece so far is within the threshold of its cluster's ACMR
+		std::vector<uint32_t> clusters;
+		for (size_t c = 0; c + 1 < hardClusters.size(); c++)
+		{
+			uint32_t start = hardClusters[c], end = hardClusters[c + 1];
+
+			flushCache();
+			uint32_t clusterMisses = 0;
+			for (uint32_t i = start; i < end; i++)
+				clusterMisses += transformTriangle(i);
+			float clusterACMR = (float)clusterMisses / (end - start);
+
+			flushCache();
+			clusters.push_back(start);
+
+			uint32_t pieceStart = start, pieceMisses = 0;
+			for (uint32_t i = start; i < end; i++)
+			{
+				pieceMisses += transformTriangle(i);
+
+				if (i + 1 < end && (float)pieceMisses / (i + 1 - pieceStart) <= clusterACMR * threshold)
+				{
+					clusters.push_back(i + 1);
+					pieceStart = i + 1;
+					pieceMisses = 0;
+					flushCache();
+				}
+			}
+		}
+		clusters.push_back(triangleCount);
+
+		// Area weighted centroid and normal per cluster
+		size_t clusterCount = clusters.size() - 1;
+		std::vector<glm::vec3> centroids(clusterCount, glm::vec3(0.0f));
+		std::vector<glm::vec3> normals(clusterCount, glm::vec3(0.0f));
+		std::vector<float> areas(clusterCount, 0.0f);
+
+		glm::vec3 meshCentroid(0.0f);
+		float meshArea = 0.0f;
+
+		for (size_t c = 0; c < clusterCount; c++)
+		{
+			for (uint32_t i = clusters[c]; i < clusters[c + 1]; i++)
+			{
+				glm::vec3 p0 = position(indices[i * 3 + 0]), p1 = position(indices[i * 3 + 1]), p2 = position(indices[i * 3 + 2]);
+
+				glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+				float area = glm::length(normal);
+
+				centroids[c] += (p0 + p1 + p2) * (area / 3.0f);
+				normals[c] += normal;
+				areas[c] += area;
+			}
+
+			meshCentroid += centroids[c];
+			meshArea += areas[c];
+
+			if (areas[c] > 0.0f)
+				centroids[c] /= areas[c];
+		}
+
+		if (meshArea > 0.0f)
+			meshCentroid /= meshArea;
+
+		// Clusters facing away from the center occlude the rest, so they are drawn first
+		std::vector<float> sortKeys(clusterCount);
+		for (size_t c = 0; c < clusterCount; c++)
+		{
+			float length = glm::length(normals[c]);
+			sortKeys[c] = length > 0.0f ? glm::dot(centroids[c] - meshCentroid, normals[c] / length) : 0.0f;
+		}
+
+		std::vector<uint32_t> order(clusterCount);
+		for (size_t c = 0; c < clusterCount; c++)
+			order[c] = static_cast<uint32_t>(c);
+
+		std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+		std::vector<uint32_t> result;
+		result.reserve(indices.size());
+
+		for (uint32_t c : order)
+			result.insert(result.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+
+		indices.swap(result);
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Vertex Fetch Optimization
+	//////////////////////////////////////////////////////////////////////////////////
+
+	size_t GenerateFetchRemap(std::vector<uint32_t>& remap, const std::vector<uint32_t>& indices, size_t vertexCount)
+	{
+		remap.assign(vertexCount, UINT32_MAX);
+
+		uint32_t nextVertex = 0;
+		for (uint32_t index : indices)
+		{
+			if (remap[index] == UINT32_MAX)
+				remap[index] = nextVertex++;
+		}
+
+		return nextVertex;
+	}
+
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstring>
+
+#include <glm/glm.hpp>
+
+// Vertex cache size the triangle order is optimized for, and the FIFO size statistics are reported with
+#define VERTEX_CACHE_SIZE 32
+#define VERTEX_CACHE_ANALYSIS_SIZE 16
+
+// How much the overdraw pass may worsen ACMR while splitting the mesh into sortable clusters
+#define OVERDRAW_THRESHOLD 1.05f
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Mesh Loading
+	//////////////////////////////////////////////////////////////////////////////////
+
+	struct ObjVertex
+	{
+		glm::vec3 Position;
+		glm::vec3 Normal;
+	};
+
+	// Unindexed triangle list, polygons are fanned. Faces without normals get their face normal
+	bool LoadObj(const std::string& path, std::vector<ObjVertex>& vertices);
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Mesh Optimization
+	//////////////////////////////////////////////////////////////////////////////////
+
+	struct VertexCacheStats
+	{
+		// Transformed vertices per triangle, 0.5 is the ideal for a regular grid and 3 the worst case
+		float ACMR;
+		// Transformed vertices per unique vertex, 1 is ideal
+		float ATVR;
+		uint32_t Transforms;
+	};
+
+	VertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = VERTEX_CACHE_ANALYSIS_SIZE);
+
+	// Reorders triangles for the post-transform vertex cache (Forsyth, linear speed vertex cache optimisation)
+	void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+
+	// Splits a cache optimized list into clusters at cache boundaries and draws outward facing clusters
+	// first (Sander et al., fast triangle reordering). Positions are read with the given stride in bytes
+	void OptimizeOverdraw(std::vector<uint32_t>& indices, const void* positions, size_t vertexCount, size_t stride, float threshold = OVERDRAW_THRESHOLD);
+
+	// Fills remap with the new location of every vertex, in order of first use. Returns the used vertex count
+	size_t GenerateFetchRemap(std::vector<uint32_t>& remap, const std::vector<uint32_t>& indices, size_t vertexCount);
+
+	// Merges bitwise identical vertices of an unindexed list and returns the index buffer
+	template<typename T>
+	std::vector<uint32_t> DeduplicateVertices(std::vector<T>& vertices)
+	{
+		struct BytesHash
+		{
+			size_t operator()(const T& vertex) const
+			{
+				// FNV-1a
+				const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&vertex);
+				size_t hash = 14695981039346656037ull;
+				for (size_t i = 0; i < sizeof(T); i++)
+					hash = (hash ^ bytes[i]) * 1099511628211ull;
+				return hash;
+			}
+		};
+
+		struct BytesEqual
+		{
+			bool operator()(const T& a, const T& b) const { return std::memcmp(&a, &b, sizeof(T)) == 0; }
+		};
+
+		std::unordered_map<T, uint32_t, BytesHash, BytesEqual> unique;
+		unique.reserve(vertices.size());
+
+		std::vector<uint32_t> indices(vertices.size());
+		std::vector<T> uniqueVertices;
+
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			auto result = unique.emplace(vertices[i], static_cast<uint32_t>(uniqueVertices.size()));
+			if (result.second)
+				uniqueVertices.push_back(vertices[i]);
+
+			indices[i] = result.first->second;
+		}
+
+		vertices.swap(uniqueVertices);
+		return indices;
+	}
+
+	// Reorders vertices by first use so the input assembler fetches memory mostly sequentially
+	template<typename T>
+	void OptimizeVertexFetch(std::vector<T>& vertices, std::vector<uint32_t>& indices)
+	{
+		std::vector<uint32_t> remap;
+		size_t usedCount = GenerateFetchRemap(remap, indices, vertices.size());
+
+		std::vector<T> reordered(usedCount);
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			if (remap[i] != UINT32_MAX)
+				reordered[remap[i]] = vertices[i];
+		}
+
+		for (auto& index : indices)
+			index = remap[index];
+
+		vertices.swap(reordered);
+	}
+
+}
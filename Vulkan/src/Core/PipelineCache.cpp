@@ -0,0 +1,153 @@
+#include "PipelineCache.h"
+#include "CacheFile.h"
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+
+#define PIPELINE_CACHE_MAGIC 0x43505656 // "VVPC"
+#define PIPELINE_CACHE_VERSION 1
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Initialization and Destruction
+	//////////////////////////////////////////////////////////////////////////////////
+
+	PipelineCache::PipelineCache(VkPhysicalDevice physicalDevice, VkDevice device, const std::string& path)
+		: m_Device(device), m_Path(path)
+	{
+		vkGetPhysicalDeviceProperties(physicalDevice, &m_DeviceProperties);
+
+		std::vector<char> data;
+		m_Warm = !m_Path.empty() && Load(data);
+
+		VkPipelineCacheCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		createInfo.initialDataSize = m_Warm ? data.size() : 0;
+		createInfo.pInitialData = m_Warm ? data.data() : nullptr;
+
+		if (vkCreatePipelineCache(m_Device, &createInfo, nullptr, &m_Cache) != VK_SUCCESS)
+		{
+			std::cout << "Failed to create pipeline cache!" << std::endl;
+			m_Warm = false;
+		}
+	}
+
+	PipelineCache::~PipelineCache()
+	{
+		if (!m_Path.empty())
+			Save();
+
+		vkDestroyPipelineCache(m_Device, m_Cache, nullptr);
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Metrics
+	//////////////////////////////////////////////////////////////////////////////////
+
+	void PipelineCache::RecordCreation(double milliseconds)
+	{
+		m_PipelineCount++;
+		m_CreationMs += milliseconds;
+	}
+
+	void PipelineCache::ReportStartup()
+	{
+		m_StartupMs = m_CreationMs;
+
+		std::cout << "Pipeline cache: " << (m_Warm ? "warm" : "cold") << " start, " << m_PipelineCount << " pipeline(s) in " << m_StartupMs << " ms";
+
+		if (m_Warm && m_ColdStartupMs > 0.0)
+			std::cout << " (cold start took " << m_ColdStartupMs << " ms, " << 100.0 * (1.0 - m_StartupMs / m_ColdStartupMs) << "% saved)";
+
+		std::cout << std::endl;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Serialization
+	//////////////////////////////////////////////////////////////////////////////////
+
+	bool PipelineCache::Load(std::vector<char>& data)
+	{
+		std::ifstream file(m_Path, std::ios::ate | std::ios::binary);
+		if (!file.is_open())
+			return false;
+
+		size_t fileSize = (size_t)file.tellg();
+		if (fileSize < sizeof(FileHeader))
+		{
+			std::cout << "Pipeline cache " << m_Path << " is truncated, ignoring it" << std::endl;
+			return false;
+		}
+
+		FileHeader header;
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+		if (header.Magic != PIPELINE_CACHE_MAGIC || header.Version != PIPELINE_CACHE_VERSION || header.DataSize != fileSize - sizeof(FileHeader))
+		{
+			std::cout << "Pipeline cache " << m_Path << " has an unknown format, ignoring it" << std::endl;
+			return false;
+		}
+
+		data.resize((size_t)header.DataSize);
+		file.read(data.data(), data.size());
+
+		if (!file || ChecksumData(data.data(), data.size()) != header.Checksum)
+		{
+			std::cout << "Pipeline cache " << m_Path << " is corrupt, ignoring it" << std::endl;
+			return false;
+		}
+
+		if (!IsCompatible(data))
+		{
+			std::cout << "Pipeline cache " << m_Path << " was built for another device or driver, ignoring it" << std::endl;
+			return false;
+		}
+
+		m_ColdStartupMs = header.ColdStartupMs;
+		return true;
+	}
+
+	bool PipelineCache::IsCompatible(const std::vector<char>& data) const
+	{
+		VkPipelineCacheHeaderVersionOne header;
+		if (data.size() < sizeof(header))
+			return false;
+
+		memcpy(&header, data.data(), sizeof(header));
+
+		return header.headerSize >= sizeof(header)
+			&& header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+			&& header.vendorID == m_DeviceProperties.vendorID
+			&& header.deviceID == m_DeviceProperties.deviceID
+			&& memcmp(header.pipelineCacheUUID, m_DeviceProperties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+	}
+
+	bool PipelineCache::Save()
+	{
+		size_t dataSize = 0;
+		if (vkGetPipelineCacheData(m_Device, m_Cache, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0)
+			return false;
+
+		std::vector<char> data(dataSize);
+		if (vkGetPipelineCacheData(m_Device, m_Cache, &dataSize, data.data()) != VK_SUCCESS)
+		{
+			std::cout << "Failed to retrieve pipeline cache data!" << std::endl;
+			return false;
+		}
+		data.resize(dataSize);
+
+		// A cold start becomes the reference that later warm starts are measured against
+		FileHeader header;
+		header.Magic = PIPELINE_CACHE_MAGIC;
+		header.Version = PIPELINE_CACHE_VERSION;
+		header.DataSize = data.size();
+		header.Checksum = ChecksumData(data.data(), data.size());
+		header.ColdStartupMs = m_Warm ? m_ColdStartupMs : (m_StartupMs >= 0.0 ? m_StartupMs : m_CreationMs);
+
+		return WriteFileAtomic(m_Path, { { &header, sizeof(header) }, { data.data(), data.size() } });
+	}
+
+}
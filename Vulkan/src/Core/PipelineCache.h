@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <string>
+#include <vector>
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Pipeline Cache
+	//////////////////////////////////////////////////////////////////////////////////
+
+	// VkPipelineCache that is loaded from disk at startup and written back on destruction.
+	// The driver blob is wrapped in a small header with a checksum and the pipeline
+	// creation time of the last cold start, which warm starts are compared against.
+	class PipelineCache
+	{
+	public:
+		// An empty path keeps the cache in memory only
+		PipelineCache(VkPhysicalDevice physicalDevice, VkDevice device, const std::string& path);
+		~PipelineCache();
+
+		VkPipelineCache GetHandle() const { return m_Cache; }
+
+		// True when a valid blob for this device was loaded
+		bool IsWarm() const { return m_Warm; }
+
+		void RecordCreation(double milliseconds);
+
+		// Prints the pipeline creation time spent so far and latches it as the startup time
+		void ReportStartup();
+
+		bool Save();
+
+	private:
+		struct FileHeader
+		{
+			uint32_t Magic;
+			uint32_t Version;
+			uint64_t DataSize;
+			uint64_t Checksum;
+			double ColdStartupMs;
+		};
+
+		bool Load(std::vector<char>& data);
+		bool IsCompatible(const std::vector<char>& data) const;
+
+	private:
+		VkDevice m_Device;
+		VkPhysicalDeviceProperties m_DeviceProperties;
+
+		std::string m_Path;
+		VkPipelineCache m_Cache = VK_NULL_HANDLE;
+		bool m_Warm = false;
+
+		// Metrics
+		uint32_t m_PipelineCount = 0;
+		double m_CreationMs = 0.0;
+		double m_StartupMs = -1.0;
+		double m_ColdStartupMs = 0.0;
+	};
+
+}
@@ -0,0 +1,398 @@
+#include "PipelineCompiler.h"
+#include "ShaderReflection.h"
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+
+namespace Vulkan {
+
+	void DestroyCompiledPipeline(VkDevice device, CompiledPipeline& pipeline)
+	{
+		vkDestroyPipeline(device, pipeline.Pipeline, nullptr);
+		vkDestroyPipelineLayout(device, pipeline.Layout, nullptr);
+
+		for (auto setLayout : pipeline.SetLayouts)
+			vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+
+		pipeline = CompiledPipeline();
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Pipeline Compiler
+	//////////////////////////////////////////////////////////////////////////////////
+
+	PipelineCompiler::PipelineCompiler(VkDevice device, VkPipelineCache cache, const AssetPack* assets, uint32_t threadCount)
+		: m_Device(device), m_Cache(cache), m_Assets(assets)
+	{
+		if (threadCount == 0)
+			threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+		for (uint32_t i = 0; i < threadCount; i++)
+			m_Workers.emplace_back(&PipelineCompiler::WorkerLoop, this);
+	}
+
+	PipelineCompiler::~PipelineCompiler()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Stop = true;
+		}
+
+		m_WorkAvailable.notify_all();
+
+		for (auto& worker : m_Workers)
+			worker.join();
+
+		// Queued jobs never started, finished ones were never collected
+		for (auto& job : m_Jobs)
+			DestroyCompiledPipeline(m_Device, job.second->Pipeline);
+	}
+
+	PipelineHandle PipelineCompiler::Submit(const GraphicsPipelineDesc& desc)
+	{
+		PipelineHandle handle;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			handle = m_NextHandle++;
+			m_Jobs[handle] = std::make_unique<Job>();
+			m_Jobs[handle]->Desc = desc;
+			m_Queue.push_back(handle);
+		}
+
+		m_WorkAvailable.notify_one();
+		return handle;
+	}
+
+	PipelineStatus PipelineCompiler::Collect(PipelineHandle handle, CompiledPipeline& pipeline)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		auto it = m_Jobs.find(handle);
+		if (it == m_Jobs.end())
+			return PipelineStatus::Failed;
+
+		PipelineStatus status = it->second->Status;
+		if (status == PipelineStatus::Pending)
+			return status;
+
+		if (status == PipelineStatus::Ready)
+			pipeline = std::move(it->second->Pipeline);
+
+		m_Jobs.erase(it);
+		return status;
+	}
+
+	PipelineStatus PipelineCompiler::GetStatus(PipelineHandle handle)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		auto it = m_Jobs.find(handle);
+		return it == m_Jobs.end() ? PipelineStatus::Failed : it->second->Status;
+	}
+
+	void PipelineCompiler::Cancel(PipelineHandle handle)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		auto it = m_Jobs.find(handle);
+		if (it == m_Jobs.end())
+			return;
+
+		// The worker owns a pending job until it finishes or dequeues it
+		if (it->second->Status == PipelineStatus::Pending)
+		{
+			it->second->Cancelled = true;
+			return;
+		}
+
+		DestroyCompiledPipeline(m_Device, it->second->Pipeline);
+		m_Jobs.erase(it);
+	}
+
+	void PipelineCompiler::Wait(PipelineHandle handle)
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_WorkDone.wait(lock, [&]()
+		{
+			auto it = m_Jobs.find(handle);
+			return it == m_Jobs.end() || it->second->Status != PipelineStatus::Pending;
+		});
+	}
+
+	void PipelineCompiler::WaitIdle()
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_WorkDone.wait(lock, [&]() { return m_Queue.empty() && m_Compiling == 0; });
+	}
+
+	void PipelineCompiler::WorkerLoop()
+	{
+		for (;;)
+		{
+			PipelineHandle handle;
+			Job* job;
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_WorkAvailable.wait(lock, [&]() { return m_Stop || !m_Queue.empty(); });
+
+				if (m_Stop)
+					return;
+
+				handle = m_Queue.front();
+				m_Queue.pop_front();
+
+				auto it = m_Jobs.find(handle);
+				if (it->second->Cancelled)
+				{
+					m_Jobs.erase(it);
+					m_WorkDone.notify_all();
+					continue;
+				}
+
+				job = it->second.get();
+				m_Compiling++;
+			}
+
+			bool compiled = Compile(job->Desc, job->Pipeline);
+
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				m_Compiling--;
+
+				if (job->Cancelled)
+				{
+					DestroyCompiledPipeline(m_Device, job->Pipeline);
+					m_Jobs.erase(handle);
+				}
+				else
+				{
+					job->Status = compiled ? PipelineStatus::Ready : PipelineStatus::Failed;
+				}
+			}
+
+			m_WorkDone.notify_all();
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Compilation
+	//////////////////////////////////////////////////////////////////////////////////
+
+	bool PipelineCompiler::Compile(const GraphicsPipelineDesc& desc, CompiledPipeline& pipeline) const
+	{
+		// Shader Reflection, depth-only pipelines have no fragment stage
+		uint32_t stageCount = desc.FragmentShader.empty() ? 1 : 2;
+
+		AssetData vertexShader, fragmentShader;
+		if (!LoadAsset(m_Assets, desc.VertexShader, AssetType::Shader, vertexShader) || (stageCount == 2 && !LoadAsset(m_Assets, desc.FragmentShader, AssetType::Shader, fragmentShader)))
+			return false;
+
+		// Packed shaders are mapped rather than read, only loose ones can be out of date
+		auto isStale = [](const AssetData& shader, const std::string& path, const std::string& source)
+		{
+			if (shader.Storage.empty() || !IsOlderThanSource(path, source))
+				return false;
+
+			std::cout << path << " is older than " << source << ", rebuild the shaders!" << std::endl;
+			return true;
+		};
+
+		if (isStale(vertexShader, desc.VertexShader, desc.VertexSource) || (stageCount == 2 && isStale(fragmentShader, desc.FragmentShader, desc.FragmentSource)))
+			return false;
+
+		std::vector<ShaderReflection> reflections(stageCount);
+		if (!ReflectShader(vertexShader.Data, vertexShader.Size, reflections[0]) || (stageCount == 2 && !ReflectShader(fragmentShader.Data, fragmentShader.Size, reflections[1])))
+			return false;
+
+		if (reflections[0].Stage != VK_SHADER_STAGE_VERTEX_BIT || (stageCount == 2 && reflections[1].Stage != VK_SHADER_STAGE_FRAGMENT_BIT))
+		{
+			std::cout << "Shaders are not a vertex and a fragment shader!" << std::endl;
+			return false;
+		}
+
+		if (!ValidateVertexInputs(reflections[0], desc.VertexInput))
+			return false;
+
+		uint32_t pushConstantSize = 0;
+		for (const auto& reflection : reflections)
+			pushConstantSize = std::max(pushConstantSize, reflection.PushConstantSize);
+
+		if (pushConstantSize != desc.PushConstantSize)
+		{
+			std::cout << "Shaders declare " << pushConstantSize << " bytes of push constants, the pipeline pushes " << desc.PushConstantSize << "!" << std::endl;
+			return false;
+		}
+
+		// Pipeline Layout
+		if (!CreateReflectedPipelineLayout(m_Device, reflections, desc.SharedSetLayouts, pipeline.Layout, pipeline.SetLayouts))
+			return false;
+
+		pipeline.PushConstantSize = 0;
+		pipeline.PushConstantStages = 0;
+		for (const auto& reflection : reflections)
+		{
+			if (reflection.PushConstantSize)
+			{
+				pipeline.PushConstantSize = std::max(pipeline.PushConstantSize, reflection.PushConstantSize);
+				pipeline.PushConstantStages |= reflection.Stage;
+			}
+		}
+
+		// Shader Modules
+		VkShaderModule shaderModules[2] = { VK_NULL_HANDLE, VK_NULL_HANDLE };
+		const AssetData* shaderCode[2] = { &vertexShader, &fragmentShader };
+
+		for (uint32_t i = 0; i < stageCount; i++)
+		{
+			VkShaderModuleCreateInfo createInfo{};
+			createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+			createInfo.codeSize = shaderCode[i]->Size;
+			createInfo.pCode = reinterpret_cast<const uint32_t*>(shaderCode[i]->Data);
+
+			if (vkCreateShaderModule(m_Device, &createInfo, nullptr, &shaderModules[i]) != VK_SUCCESS)
+				std::cout << "Failed to create shader module!" << std::endl;
+		}
+
+		// Specialization constants are numbered in order, ids a stage doesn't declare are ignored
+		std::vector<VkSpecializationMapEntry> specializationEntries(desc.Specialization.size());
+		for (uint32_t i = 0; i < desc.Specialization.size(); i++)
+		{
+			specializationEntries[i].constantID = i;
+			specializationEntries[i].offset = i * sizeof(uint32_t);
+			specializationEntries[i].size = sizeof(uint32_t);
+		}
+
+		VkSpecializationInfo specializationInfo{};
+		specializationInfo.mapEntryCount = static_cast<uint32_t>(specializationEntries.size());
+		specializationInfo.pMapEntries = specializationEntries.data();
+		specializationInfo.dataSize = desc.Specialization.size() * sizeof(uint32_t);
+		specializationInfo.pData = desc.Specialization.data();
+
+		VkPipelineShaderStageCreateInfo shaderStages[2]{};
+		for (uint32_t i = 0; i < stageCount; i++)
+		{
+			shaderStages[i].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+			shaderStages[i].stage = reflections[i].Stage;
+			shaderStages[i].module = shaderModules[i];
+			shaderStages[i].pName = reflections[i].EntryPoint.c_str();
+			shaderStages[i].pSpecializationInfo = desc.Specialization.empty() ? nullptr : &specializationInfo;
+		}
+
+		// Input Assembly
+		VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+		inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+		inputAssembly.topology = desc.Topology;
+		inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+		// Viewports and Scissors, set when recording so resizes keep the pipeline
+		VkPipelineViewportStateCreateInfo viewportState{};
+		viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+		viewportState.viewportCount = 1;
+		viewportState.pViewports = nullptr;
+		viewportState.scissorCount = 1;
+		viewportState.pScissors = nullptr;
+
+		// Rasterizer
+		VkPipelineRasterizationStateCreateInfo rasterizer{};
+		rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+		rasterizer.depthClampEnable = VK_FALSE;
+		rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+		rasterizer.lineWidth = 1.0f;
+		rasterizer.cullMode = desc.CullMode;
+		rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
+		rasterizer.depthBiasEnable = VK_FALSE;
+
+		// Multisampling
+		VkPipelineMultisampleStateCreateInfo multisampling{};
+		multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+		multisampling.sampleShadingEnable = VK_FALSE;
+		multisampling.rasterizationSamples = desc.Samples;
+		multisampling.minSampleShading = 1.0f;
+		multisampling.pSampleMask = nullptr;
+		multisampling.alphaToCoverageEnable = VK_FALSE;
+		multisampling.alphaToOneEnable = VK_FALSE;
+
+		// Depth
+		VkPipelineDepthStencilStateCreateInfo depthStencil{};
+		depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+		depthStencil.depthTestEnable = desc.DepthTest ? VK_TRUE : VK_FALSE;
+		depthStencil.depthWriteEnable = desc.DepthWrite ? VK_TRUE : VK_FALSE;
+		depthStencil.depthCompareOp = desc.DepthCompareOp;
+		depthStencil.depthBoundsTestEnable = VK_FALSE;
+		depthStencil.stencilTestEnable = VK_FALSE;
+		depthStencil.minDepthBounds = 0.0f;
+		depthStencil.maxDepthBounds = 1.0f;
+
+		// Color blending
+		VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+		colorBlendAttachment.colorWriteMask = desc.ColorWriteMask;
+		colorBlendAttachment.blendEnable = desc.BlendEnable ? VK_TRUE : VK_FALSE;
+		colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+		colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+		colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+		colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+		colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+		colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+		VkPipelineColorBlendStateCreateInfo colorBlending{};
+		colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+		colorBlending.logicOpEnable = VK_FALSE;
+		colorBlending.logicOp = VK_LOGIC_OP_COPY;
+		colorBlending.attachmentCount = 1;
+		colorBlending.pAttachments = &colorBlendAttachment;
+
+		// Dynamic States
+		VkDynamicState dynamicStates[] = {
+			VK_DYNAMIC_STATE_VIEWPORT,
+			VK_DYNAMIC_STATE_SCISSOR
+		};
+
+		VkPipelineDynamicStateCreateInfo dynamicState{};
+		dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+		dynamicState.dynamicStateCount = 2;
+		dynamicState.pDynamicStates = dynamicStates;
+
+		// Pipeline
+		VkGraphicsPipelineCreateInfo pipelineInfo{};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		pipelineInfo.stageCount = stageCount;
+		pipelineInfo.pStages = shaderStages;
+
+		pipelineInfo.pVertexInputState = &desc.VertexInput;
+		pipelineInfo.pInputAssemblyState = &inputAssembly;
+		pipelineInfo.pViewportState = &viewportState;
+		pipelineInfo.pRasterizationState = &rasterizer;
+		pipelineInfo.pMultisampleState = &multisampling;
+		pipelineInfo.pDepthStencilState = &depthStencil;
+		pipelineInfo.pColorBlendState = &colorBlending;
+		pipelineInfo.pDynamicState = &dynamicState;
+
+		pipelineInfo.layout = pipeline.Layout;
+		pipelineInfo.renderPass = desc.RenderPass;
+		pipelineInfo.subpass = 0;
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		// The cache is internally synchronized, every worker shares it
+		VkResult result = vkCreateGraphicsPipelines(m_Device, m_Cache, 1, &pipelineInfo, nullptr, &pipeline.Pipeline);
+
+		pipeline.CreationMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		// Cleanup
+		for (auto shaderModule : shaderModules)
+			vkDestroyShaderModule(m_Device, shaderModule, nullptr);
+
+		if (result != VK_SUCCESS)
+		{
+			std::cout << "Failed to create graphics pipeline!" << std::endl;
+			pipeline.Pipeline = VK_NULL_HANDLE;
+			DestroyCompiledPipeline(m_Device, pipeline);
+			return false;
+		}
+
+		return true;
+	}
+
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "AssetPack.h"
+
+#define INVALID_PIPELINE_HANDLE UINT32_MAX
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Pipeline Descriptions
+	//////////////////////////////////////////////////////////////////////////////////
+
+	// Plain data, so it can be compiled on any thread. VertexInput has to point at static
+	// tables such as VertexInputState::GetCreateInfo()
+	struct GraphicsPipelineDesc
+	{
+		std::string VertexShader;
+		// Empty for depth-only pipelines, which should also clear ColorWriteMask
+		std::string FragmentShader;
+		// GLSL the loose shaders are built from, a shader older than its source fails to compile
+		std::string VertexSource;
+		std::string FragmentSource;
+
+		VkPipelineVertexInputStateCreateInfo VertexInput{};
+		// Values for constant_id 0, 1, ... in every stage
+		std::vector<uint32_t> Specialization;
+		// Bytes pushed per draw, the shaders have to declare a push constant block of this size
+		uint32_t PushConstantSize = 0;
+
+		VkPrimitiveTopology Topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		VkCullModeFlags CullMode = VK_CULL_MODE_BACK_BIT;
+		bool BlendEnable = true;
+		// Has to match the render pass attachments
+		VkSampleCountFlagBits Samples = VK_SAMPLE_COUNT_1_BIT;
+		VkColorComponentFlags ColorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+		// Ignored when the render pass has no depth attachment
+		bool DepthTest = false;
+		bool DepthWrite = false;
+		VkCompareOp DepthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+		// Set layouts owned elsewhere, such as the bindless heap's. Sets without one are built from reflection
+		std::vector<VkDescriptorSetLayout> SharedSetLayouts;
+
+		VkRenderPass RenderPass = VK_NULL_HANDLE;
+	};
+
+	// Owned by whoever collected it
+	struct CompiledPipeline
+	{
+		VkPipeline Pipeline = VK_NULL_HANDLE;
+		VkPipelineLayout Layout = VK_NULL_HANDLE;
+		// Reflected layouts owned by the pipeline, null for shared sets
+		std::vector<VkDescriptorSetLayout> SetLayouts;
+
+		// Reflected push constant block, nothing should be pushed without one
+		uint32_t PushConstantSize = 0;
+		VkShaderStageFlags PushConstantStages = 0;
+
+		double CreationMs = 0.0;
+		// Graphics timeline value after which a replaced pipeline can be destroyed
+		uint64_t RetireValue = 0;
+	};
+
+	void DestroyCompiledPipeline(VkDevice device, CompiledPipeline& pipeline);
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Pipeline Compiler
+	//////////////////////////////////////////////////////////////////////////////////
+
+	using PipelineHandle = uint32_t;
+
+	enum class PipelineStatus
+	{
+		Pending = 0,
+		Ready,
+		Failed
+	};
+
+	// Compiles pipeline descriptions on its own worker threads, all sharing one pipeline
+	// cache. Submit returns a handle right away, Collect hands the pipeline over once it
+	// is ready, so the render loop never waits for a driver compile.
+	class PipelineCompiler
+	{
+	public:
+		// Shaders are read from assets when it has them, 0 threads uses one per hardware core
+		PipelineCompiler(VkDevice device, VkPipelineCache cache, const AssetPack* assets = nullptr, uint32_t threadCount = 0);
+		~PipelineCompiler();
+
+		// Compiles on the calling thread
+		bool Compile(const GraphicsPipelineDesc& desc, CompiledPipeline& pipeline) const;
+
+		PipelineHandle Submit(const GraphicsPipelineDesc& desc);
+
+		// Moves a ready pipeline into pipeline and forgets the handle, failed handles are forgotten as well
+		PipelineStatus Collect(PipelineHandle handle, CompiledPipeline& pipeline);
+		// Status without collecting, unknown handles count as failed
+		PipelineStatus GetStatus(PipelineHandle handle);
+
+		// Drops a handle, a compile already running is destroyed when it finishes
+		void Cancel(PipelineHandle handle);
+
+		void Wait(PipelineHandle handle);
+		// Returns once nothing is queued or compiling, for when a render pass is about to go away
+		void WaitIdle();
+
+		uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_Workers.size()); }
+		const AssetPack* GetAssetPack() const { return m_Assets; }
+
+	private:
+		struct Job
+		{
+			GraphicsPipelineDesc Desc;
+			CompiledPipeline Pipeline;
+			PipelineStatus Status = PipelineStatus::Pending;
+			bool Cancelled = false;
+		};
+
+		void WorkerLoop();
+
+	private:
+		VkDevice m_Device;
+		VkPipelineCache m_Cache;
+		const AssetPack* m_Assets;
+
+		std::vector<std::thread> m_Workers;
+
+		std::mutex m_Mutex;
+		std::condition_variable m_WorkAvailable;
+		std::condition_variable m_WorkDone;
+
+		std::deque<PipelineHandle> m_Queue;
+		std::unordered_map<PipelineHandle, std::unique_ptr<Job>> m_Jobs;
+		PipelineHandle m_NextHandle = 0;
+		uint32_t m_Compiling = 0;
+		bool m_Stop = false;
+	};
+
+}
@@ -0,0 +1,416 @@
+#include "Profiler.h"
+
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <atomic>
+#include <cstring>
+
+#define STATISTICS_CAPACITY 4096
+#define GPU_THREAD_INDEX 1000
+
+static uint64_t GetClockTime()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool EndsWith(const std::string& value, const std::string& suffix)
+{
+	return value.size() >= suffix.size() && value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Initialization and Destruction
+	//////////////////////////////////////////////////////////////////////////////////
+
+	Profiler::Profiler(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamily, uint32_t frameCount, bool pipelineStatistics, size_t capacity)
+		: m_Device(device), m_StartTime(GetClockTime())
+	{
+		m_Events.resize(capacity);
+		m_Statistics.resize(STATISTICS_CAPACITY);
+		m_FrameQueries.resize(frameCount);
+
+		VkPhysicalDeviceProperties deviceProperties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+		m_TimestampPeriod = deviceProperties.limits.timestampPeriod;
+
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+		uint32_t validBits = queueFamilies[queueFamily].timestampValidBits;
+		m_TimestampMask = validBits >= 64 ? ~0ull : ((1ull << validBits) - 1);
+
+		// Timestamps
+		if (validBits > 0)
+		{
+			VkQueryPoolCreateInfo poolInfo{};
+			poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+			poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+			poolInfo.queryCount = frameCount * MAX_GPU_SCOPES * 2;
+
+			if (vkCreateQueryPool(m_Device, &poolInfo, nullptr, &m_TimestampPool) != VK_SUCCESS)
+				std::cout << "Failed to create timestamp query pool!" << std::endl;
+		}
+		else
+		{
+			std::cout << "Graphics queue does not support timestamps, GPU scopes are disabled" << std::endl;
+		}
+
+		// Pipeline Statistics
+		if (pipelineStatistics)
+		{
+			m_StatisticFlags = VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT
+				| VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT
+				| VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT
+				| VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT
+				| VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT
+				| VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
+			VkQueryPoolCreateInfo poolInfo{};
+			poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+			poolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+			poolInfo.queryCount = frameCount;
+			poolInfo.pipelineStatistics = m_StatisticFlags;
+
+			if (vkCreateQueryPool(m_Device, &poolInfo, nullptr, &m_StatisticsPool) != VK_SUCCESS)
+				std::cout << "Failed to create pipeline statistics query pool!" << std::endl;
+		}
+	}
+
+	Profiler::~Profiler()
+	{
+		vkDestroyQueryPool(m_Device, m_TimestampPool, nullptr);
+		vkDestroyQueryPool(m_Device, m_StatisticsPool, nullptr);
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// CPU Events
+	//////////////////////////////////////////////////////////////////////////////////
+
+	uint64_t Profiler::GetTime() const
+	{
+		return GetClockTime() - m_StartTime;
+	}
+
+	void Profiler::RecordCpuEvent(const char* name, uint64_t start, uint64_t end)
+	{
+		ProfileEvent event;
+		event.Name = name;
+		event.Frame = m_Frame;
+		event.Start = start;
+		event.Duration = end - start;
+		event.Thread = GetThreadIndex();
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		PushEvent(event);
+	}
+
+	void Profiler::PushEvent(const ProfileEvent& event)
+	{
+		// Overwrites the oldest event once full
+		m_Events[(m_EventHead + m_EventCount) % m_Events.size()] = event;
+
+		if (m_EventCount < m_Events.size())
+			m_EventCount++;
+		else
+			m_EventHead = (m_EventHead + 1) % m_Events.size();
+	}
+
+	uint32_t Profiler::GetThreadIndex()
+	{
+		static std::atomic<uint32_t> s_NextIndex{ 0 };
+		thread_local uint32_t s_Index = s_NextIndex++;
+		return s_Index;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// GPU Queries
+	//////////////////////////////////////////////////////////////////////////////////
+
+	void Profiler::BeginFrame(uint32_t frameSlot)
+	{
+		Collect(frameSlot);
+
+		m_CurrentSlot = frameSlot;
+		m_Frame++;
+
+		FrameQueries& queries = m_FrameQueries[frameSlot];
+		queries.Frame = m_Frame;
+		queries.ScopeCount = 0;
+		queries.StatisticsWritten = false;
+	}
+
+	void Profiler::CmdResetQueries(VkCommandBuffer commandBuffer)
+	{
+		if (m_TimestampPool)
+			vkCmdResetQueryPool(commandBuffer, m_TimestampPool, m_CurrentSlot * MAX_GPU_SCOPES * 2, MAX_GPU_SCOPES * 2);
+		if (m_StatisticsPool)
+			vkCmdResetQueryPool(commandBuffer, m_StatisticsPool, m_CurrentSlot, 1);
+	}
+
+	uint32_t Profiler::CmdBeginGpuScope(VkCommandBuffer commandBuffer, const char* name)
+	{
+		FrameQueries& queries = m_FrameQueries[m_CurrentSlot];
+		if (!m_TimestampPool || queries.ScopeCount == MAX_GPU_SCOPES)
+			return UINT32_MAX;
+
+		uint32_t scope = queries.ScopeCount++;
+		queries.ScopeNames[scope] = name;
+
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_TimestampPool, (m_CurrentSlot * MAX_GPU_SCOPES + scope) * 2);
+		return scope;
+	}
+
+	void Profiler::CmdEndGpuScope(VkCommandBuffer commandBuffer, uint32_t scope)
+	{
+		if (scope == UINT32_MAX)
+			return;
+
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_TimestampPool, (m_CurrentSlot * MAX_GPU_SCOPES + scope) * 2 + 1);
+	}
+
+	void Profiler::CmdBeginStatistics(VkCommandBuffer commandBuffer)
+	{
+		if (m_StatisticsPool)
+			vkCmdBeginQuery(commandBuffer, m_StatisticsPool, m_CurrentSlot, 0);
+	}
+
+	void Profiler::CmdEndStatistics(VkCommandBuffer commandBuffer)
+	{
+		if (!m_StatisticsPool)
+			return;
+
+		vkCmdEndQuery(commandBuffer, m_StatisticsPool, m_CurrentSlot);
+		m_FrameQueries[m_CurrentSlot].StatisticsWritten = true;
+	}
+
+	void Profiler::MarkSubmit()
+	{
+		FrameQueries& queries = m_FrameQueries[m_CurrentSlot];
+		queries.SubmitTime = GetTime();
+		queries.Pending = true;
+	}
+
+	void Profiler::Collect(uint32_t frameSlot)
+	{
+		FrameQueries& queries = m_FrameQueries[frameSlot];
+		if (!queries.Pending)
+			return;
+
+		queries.Pending = false;
+
+		// No WAIT flag, the frame's fence has signaled so the results are available. Should
+		// they not be, the frame is dropped rather than stalling the CPU.
+		if (queries.ScopeCount > 0)
+		{
+			uint64_t timestamps[MAX_GPU_SCOPES * 2];
+			VkResult result = vkGetQueryPoolResults(m_Device, m_TimestampPool, frameSlot * MAX_GPU_SCOPES * 2, queries.ScopeCount * 2,
+				sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+			if (result == VK_SUCCESS)
+			{
+				// GPU and CPU clocks aren't calibrated, the first scope is aligned to the submission
+				uint64_t base = timestamps[0] & m_TimestampMask;
+
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				for (uint32_t i = 0; i < queries.ScopeCount; i++)
+				{
+					uint64_t begin = timestamps[i * 2] & m_TimestampMask;
+					uint64_t end = timestamps[i * 2 + 1] & m_TimestampMask;
+
+					ProfileEvent event;
+					event.Name = queries.ScopeNames[i];
+					event.Frame = queries.Frame;
+					event.Start = queries.SubmitTime + (uint64_t)((begin - base) * m_TimestampPeriod);
+					event.Duration = end >= begin ? (uint64_t)((end - begin) * m_TimestampPeriod) : 0;
+					event.Thread = GPU_THREAD_INDEX;
+					event.Gpu = true;
+					PushEvent(event);
+				}
+			}
+		}
+
+		if (queries.StatisticsWritten)
+		{
+			uint64_t values[6];
+			VkResult result = vkGetQueryPoolResults(m_Device, m_StatisticsPool, frameSlot, 1, sizeof(values), values, sizeof(values), VK_QUERY_RESULT_64_BIT);
+
+			if (result == VK_SUCCESS)
+			{
+				// Results are written in flag bit order
+				PipelineStatistics statistics;
+				statistics.Frame = queries.Frame;
+				statistics.Time = queries.SubmitTime;
+				statistics.InputAssemblyVertices = values[0];
+				statistics.InputAssemblyPrimitives = values[1];
+				statistics.VertexShaderInvocations = values[2];
+				statistics.ClippingInvocations = values[3];
+				statistics.ClippingPrimitives = values[4];
+				statistics.FragmentShaderInvocations = values[5];
+
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				m_Statistics[(m_StatisticsHead + m_StatisticsCount) % m_Statistics.size()] = statistics;
+
+				if (m_StatisticsCount < m_Statistics.size())
+					m_StatisticsCount++;
+				else
+					m_StatisticsHead = (m_StatisticsHead + 1) % m_Statistics.size();
+			}
+		}
+	}
+
+	void Profiler::Flush()
+	{
+		for (uint32_t i = 0; i < m_FrameQueries.size(); i++)
+			Collect(i);
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Summaries
+	//////////////////////////////////////////////////////////////////////////////////
+
+	double Profiler::GetAverageDuration(const char* name, bool gpu)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		uint64_t total = 0;
+		uint32_t count = 0;
+		for (size_t i = 0; i < m_EventCount; i++)
+		{
+			const ProfileEvent& event = m_Events[(m_EventHead + i) % m_Events.size()];
+			if (event.Gpu == gpu && strcmp(event.Name, name) == 0)
+			{
+				total += event.Duration;
+				count++;
+			}
+		}
+
+		return count ? total / 1e6 / count : 0.0;
+	}
+
+	bool Profiler::GetAverageStatistics(PipelineStatistics& statistics)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		statistics = {};
+		if (m_StatisticsCount == 0)
+			return false;
+
+		for (size_t i = 0; i < m_StatisticsCount; i++)
+		{
+			const PipelineStatistics& sample = m_Statistics[(m_StatisticsHead + i) % m_Statistics.size()];
+			statistics.InputAssemblyVertices += sample.InputAssemblyVertices;
+			statistics.InputAssemblyPrimitives += sample.InputAssemblyPrimitives;
+			statistics.VertexShaderInvocations += sample.VertexShaderInvocations;
+			statistics.ClippingInvocations += sample.ClippingInvocations;
+			statistics.ClippingPrimitives += sample.ClippingPrimitives;
+			statistics.FragmentShaderInvocations += sample.FragmentShaderInvocations;
+		}
+
+		statistics.InputAssemblyVertices /= m_StatisticsCount;
+		statistics.InputAssemblyPrimitives /= m_StatisticsCount;
+		statistics.VertexShaderInvocations /= m_StatisticsCount;
+		statistics.ClippingInvocations /= m_StatisticsCount;
+		statistics.ClippingPrimitives /= m_StatisticsCount;
+		statistics.FragmentShaderInvocations /= m_StatisticsCount;
+		return true;
+	}
+
+	void Profiler::Clear()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		m_EventHead = m_EventCount = 0;
+		m_StatisticsHead = m_StatisticsCount = 0;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Export
+	//////////////////////////////////////////////////////////////////////////////////
+
+	bool Profiler::Export(const std::string& path)
+	{
+		std::ofstream file(path, std::ios::trunc);
+		if (!file.is_open())
+		{
+			std::cout << "Failed to open profile output " << path << "!" << std::endl;
+			return false;
+		}
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		if (EndsWith(path, ".csv"))
+			ExportCsv(file);
+		else
+			ExportChromeTrace(file);
+
+		std::cout << "Profile: " << m_EventCount << " events, " << m_StatisticsCount << " statistics samples written to " << path << std::endl;
+		return true;
+	}
+
+	void Profiler::ExportChromeTrace(std::ostream& stream)
+	{
+		stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << std::endl;
+		stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << GPU_THREAD_INDEX << ",\"args\":{\"name\":\"GPU\"}}";
+
+		for (size_t i = 0; i < m_EventCount; i++)
+		{
+			const ProfileEvent& event = m_Events[(m_EventHead + i) % m_Events.size()];
+
+			stream << "," << std::endl << "{\"name\":\"" << event.Name << "\",\"cat\":\"" << (event.Gpu ? "gpu" : "cpu")
+				<< "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.Thread
+				<< ",\"ts\":" << event.Start / 1000.0 << ",\"dur\":" << event.Duration / 1000.0
+				<< ",\"args\":{\"frame\":" << event.Frame << "}}";
+		}
+
+		for (size_t i = 0; i < m_StatisticsCount; i++)
+		{
+			const PipelineStatistics& statistics = m_Statistics[(m_StatisticsHead + i) % m_Statistics.size()];
+
+			stream << "," << std::endl << "{\"name\":\"Pipeline Statistics\",\"ph\":\"C\",\"pid\":0,\"ts\":" << statistics.Time / 1000.0
+				<< ",\"args\":{\"vertices\":" << statistics.InputAssemblyVertices
+				<< ",\"primitives\":" << statistics.InputAssemblyPrimitives
+				<< ",\"vs_invocations\":" << statistics.VertexShaderInvocations
+				<< ",\"clip_invocations\":" << statistics.ClippingInvocations
+				<< ",\"clip_primitives\":" << statistics.ClippingPrimitives
+				<< ",\"fs_invocations\":" << statistics.FragmentShaderInvocations << "}}";
+		}
+
+		stream << std::endl << "]}" << std::endl;
+	}
+
+	void Profiler::ExportCsv(std::ostream& stream)
+	{
+		stream << "type,name,frame,thread,start_us,duration_us,value" << std::endl;
+
+		for (size_t i = 0; i < m_EventCount; i++)
+		{
+			const ProfileEvent& event = m_Events[(m_EventHead + i) % m_Events.size()];
+
+			stream << (event.Gpu ? "gpu" : "cpu") << "," << event.Name << "," << event.Frame << "," << event.Thread << ","
+				<< event.Start / 1000.0 << "," << event.Duration / 1000.0 << "," << std::endl;
+		}
+
+		for (size_t i = 0; i < m_StatisticsCount; i++)
+		{
+			const PipelineStatistics& statistics = m_Statistics[(m_StatisticsHead + i) % m_Statistics.size()];
+
+			const std::pair<const char*, uint64_t> counters[] = {
+				{ "vertices", statistics.InputAssemblyVertices },
+				{ "primitives", statistics.InputAssemblyPrimitives },
+				{ "vs_invocations", statistics.VertexShaderInvocations },
+				{ "clip_invocations", statistics.ClippingInvocations },
+				{ "clip_primitives", statistics.ClippingPrimitives },
+				{ "fs_invocations", statistics.FragmentShaderInvocations }
+			};
+
+			for (const auto& counter : counters)
+				stream << "statistic," << counter.first << "," << statistics.Frame << ",," << statistics.Time / 1000.0 << ",," << counter.second << std::endl;
+		}
+	}
+
+}
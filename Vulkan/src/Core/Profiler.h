@@ -0,0 +1,158 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <ostream>
+
+#define MAX_GPU_SCOPES 32
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Profile Events
+	//////////////////////////////////////////////////////////////////////////////////
+
+	struct ProfileEvent
+	{
+		const char* Name = nullptr;
+		uint64_t Frame = 0;
+		uint64_t Start = 0;
+		uint64_t Duration = 0;
+		uint32_t Thread = 0;
+		bool Gpu = false;
+	};
+
+	struct PipelineStatistics
+	{
+		uint64_t Frame = 0;
+		uint64_t Time = 0;
+
+		uint64_t InputAssemblyVertices = 0;
+		uint64_t InputAssemblyPrimitives = 0;
+		uint64_t VertexShaderInvocations = 0;
+		uint64_t ClippingInvocations = 0;
+		uint64_t ClippingPrimitives = 0;
+		uint64_t FragmentShaderInvocations = 0;
+	};
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Profiler
+	//////////////////////////////////////////////////////////////////////////////////
+
+	// Collects CPU scopes and GPU timestamp pairs into a ring buffer that keeps the most
+	// recent events. GPU queries are double buffered per frame in flight and only read
+	// back once that frame's fence has signaled, so resolving them never stalls.
+	// Times are in nanoseconds since the profiler was created.
+	class Profiler
+	{
+	public:
+		Profiler(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamily, uint32_t frameCount, bool pipelineStatistics, size_t capacity = 1 << 16);
+		~Profiler();
+
+		// Collects the results of the slot's previous frame, call after waiting on its fence
+		void BeginFrame(uint32_t frameSlot);
+
+		uint64_t GetTime() const;
+		void RecordCpuEvent(const char* name, uint64_t start, uint64_t end);
+
+		// Recorded into the current frame's primary command buffer, outside of a render pass
+		void CmdResetQueries(VkCommandBuffer commandBuffer);
+		uint32_t CmdBeginGpuScope(VkCommandBuffer commandBuffer, const char* name);
+		void CmdEndGpuScope(VkCommandBuffer commandBuffer, uint32_t scope);
+
+		void CmdBeginStatistics(VkCommandBuffer commandBuffer);
+		void CmdEndStatistics(VkCommandBuffer commandBuffer);
+
+		// GPU events of a frame are placed on the timeline relative to its submission
+		void MarkSubmit();
+
+		// 0 when pipeline statistics are disabled
+		VkQueryPipelineStatisticFlags GetStatisticFlags() const { return m_StatisticsPool ? m_StatisticFlags : 0; }
+
+		// Collects every outstanding frame, the device has to be idle
+		void Flush();
+
+		// Averages over what the ring buffers still hold, in milliseconds. Flush first so every frame is collected
+		double GetAverageDuration(const char* name, bool gpu);
+		// False without statistics samples
+		bool GetAverageStatistics(PipelineStatistics& statistics);
+		// Drops every event and statistics sample, such as between benchmark runs
+		void Clear();
+
+		// Writes CSV when the path ends in .csv, Chrome trace JSON otherwise
+		bool Export(const std::string& path);
+
+	private:
+		struct FrameQueries
+		{
+			uint64_t Frame = 0;
+			uint64_t SubmitTime = 0;
+			bool Pending = false;
+
+			uint32_t ScopeCount = 0;
+			const char* ScopeNames[MAX_GPU_SCOPES] = {};
+			bool StatisticsWritten = false;
+		};
+
+		void Collect(uint32_t frameSlot);
+		void PushEvent(const ProfileEvent& event);
+
+		void ExportChromeTrace(std::ostream& stream);
+		void ExportCsv(std::ostream& stream);
+
+		static uint32_t GetThreadIndex();
+
+	private:
+		VkDevice m_Device;
+
+		VkQueryPool m_TimestampPool = VK_NULL_HANDLE;
+		VkQueryPool m_StatisticsPool = VK_NULL_HANDLE;
+		VkQueryPipelineStatisticFlags m_StatisticFlags = 0;
+
+		double m_TimestampPeriod = 1.0;
+		uint64_t m_TimestampMask = ~0ull;
+
+		std::vector<FrameQueries> m_FrameQueries;
+		uint32_t m_CurrentSlot = 0;
+		uint64_t m_Frame = 0;
+
+		uint64_t m_StartTime;
+
+		// Ring Buffers
+		std::mutex m_Mutex;
+		std::vector<ProfileEvent> m_Events;
+		size_t m_EventHead = 0;
+		size_t m_EventCount = 0;
+
+		std::vector<PipelineStatistics> m_Statistics;
+		size_t m_StatisticsHead = 0;
+		size_t m_StatisticsCount = 0;
+	};
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Profile Scope
+	//////////////////////////////////////////////////////////////////////////////////
+
+	// Records a CPU event for its lifetime, does nothing without a profiler
+	class ProfileScope
+	{
+	public:
+		ProfileScope(Profiler* profiler, const char* name)
+			: m_Profiler(profiler), m_Name(name), m_Start(profiler ? profiler->GetTime() : 0) {}
+
+		~ProfileScope()
+		{
+			if (m_Profiler)
+				m_Profiler->RecordCpuEvent(m_Name, m_Start, m_Profiler->GetTime());
+		}
+
+	private:
+		Profiler* m_Profiler;
+		const char* m_Name;
+		uint64_t m_Start;
+	};
+
+}
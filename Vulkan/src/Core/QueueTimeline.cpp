@@ -0,0 +1,49 @@
+#include "QueueTimeline.h"
+
+#include <iostream>
+
+namespace Vulkan {
+
+	QueueTimeline::QueueTimeline(VkDevice device, VkQueue queue)
+		: m_Device(device), m_Queue(queue)
+	{
+		VkSemaphoreTypeCreateInfo typeInfo{};
+		typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		typeInfo.initialValue = 0;
+
+		VkSemaphoreCreateInfo semaphoreInfo{};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		semaphoreInfo.pNext = &typeInfo;
+
+		if (vkCreateSemaphore(m_Device, &semaphoreInfo, nullptr, &m_Semaphore) != VK_SUCCESS)
+			std::cout << "Failed to create timeline semaphore!" << std::endl;
+	}
+
+	QueueTimeline::~QueueTimeline()
+	{
+		vkDestroySemaphore(m_Device, m_Semaphore, nullptr);
+	}
+
+	uint64_t QueueTimeline::GetCompletedValue() const
+	{
+		uint64_t value = 0;
+		vkGetSemaphoreCounterValue(m_Device, m_Semaphore, &value);
+		return value;
+	}
+
+	void QueueTimeline::Wait(uint64_t value) const
+	{
+		if (value == 0)
+			return;
+
+		VkSemaphoreWaitInfo waitInfo{};
+		waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores = &m_Semaphore;
+		waitInfo.pValues = &value;
+
+		vkWaitSemaphores(m_Device, &waitInfo, UINT64_MAX);
+	}
+
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Queue Timeline
+	//////////////////////////////////////////////////////////////////////////////////
+
+	// Timeline semaphore shared by everything submitting to one queue. Each submission
+	// signals the value returned by NextValue(), so values have to be taken in the same
+	// order the submissions reach the queue.
+	class QueueTimeline
+	{
+	public:
+		QueueTimeline(VkDevice device, VkQueue queue);
+		~QueueTimeline();
+
+		VkQueue GetQueue() const { return m_Queue; }
+		VkSemaphore GetSemaphore() const { return m_Semaphore; }
+
+		uint64_t NextValue() { return ++m_SubmittedValue; }
+		uint64_t GetSubmittedValue() const { return m_SubmittedValue; }
+
+		uint64_t GetCompletedValue() const;
+		bool IsComplete(uint64_t value) const { return value <= GetCompletedValue(); }
+
+		void Wait(uint64_t value) const;
+		void WaitIdle() const { Wait(m_SubmittedValue); }
+
+	private:
+		VkDevice m_Device;
+		VkQueue m_Queue;
+		VkSemaphore m_Semaphore = VK_NULL_HANDLE;
+
+		uint64_t m_SubmittedValue = 0;
+	};
+
+}
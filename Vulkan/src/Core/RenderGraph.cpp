@@ -0,0 +1,661 @@
+#include "RenderGraph.h"
+
+#include <iostream>
+#include <algorithm>
+
+//////////////////////////////////////////////////////////////////////////////////
+// Helpers
+//////////////////////////////////////////////////////////////////////////////////
+
+#define WRITE_ACCESS_MASK (VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | \
+	VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT)
+
+// Images with only these usages can live in lazily allocated memory
+#define ATTACHMENT_USAGE_MASK (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT)
+
+namespace Vulkan {
+
+	struct UsageInfo
+	{
+		VkPipelineStageFlags Stages;
+		VkAccessFlags Access;
+		VkImageLayout Layout;
+	};
+
+	static UsageInfo GetUsageInfo(ResourceUsage usage)
+	{
+		switch (usage)
+		{
+		case ResourceUsage::Acquire:
+			return { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED };
+		case ResourceUsage::ColorAttachment:
+			return { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+		case ResourceUsage::DepthAttachment:
+			return { VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+		case ResourceUsage::ComputeRead:
+			return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+		case ResourceUsage::ComputeWrite:
+			return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL };
+		case ResourceUsage::FragmentRead:
+			return { VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+		case ResourceUsage::IndirectRead:
+			return { VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED };
+		case ResourceUsage::TransferRead:
+			return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL };
+		case ResourceUsage::TransferWrite:
+			return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL };
+		case ResourceUsage::HostRead:
+			return { VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT, VK_IMAGE_LAYOUT_GENERAL };
+		case ResourceUsage::Present:
+			return { VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR };
+		default:
+			return { 0, 0, VK_IMAGE_LAYOUT_UNDEFINED };
+		}
+	}
+
+	static VkImageUsageFlags GetImageUsageFlags(ResourceUsage usage)
+	{
+		switch (usage)
+		{
+		case ResourceUsage::ColorAttachment:	return VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+		case ResourceUsage::DepthAttachment:	return VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+		case ResourceUsage::ComputeRead:		return VK_IMAGE_USAGE_SAMPLED_BIT;
+		case ResourceUsage::FragmentRead:		return VK_IMAGE_USAGE_SAMPLED_BIT;
+		case ResourceUsage::ComputeWrite:		return VK_IMAGE_USAGE_STORAGE_BIT;
+		case ResourceUsage::TransferRead:		return VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		case ResourceUsage::TransferWrite:		return VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		default:								return 0;
+		}
+	}
+
+	static VkImageAspectFlags GetAspectMask(VkFormat format)
+	{
+		switch (format)
+		{
+		case VK_FORMAT_D16_UNORM:
+		case VK_FORMAT_X8_D24_UNORM_PACK32:
+		case VK_FORMAT_D32_SFLOAT:
+			return VK_IMAGE_ASPECT_DEPTH_BIT;
+		case VK_FORMAT_D16_UNORM_S8_UINT:
+		case VK_FORMAT_D24_UNORM_S8_UINT:
+		case VK_FORMAT_D32_SFLOAT_S8_UINT:
+			return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+		case VK_FORMAT_S8_UINT:
+			return VK_IMAGE_ASPECT_STENCIL_BIT;
+		default:
+			return VK_IMAGE_ASPECT_COLOR_BIT;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Render Graph
+	//////////////////////////////////////////////////////////////////////////////////
+
+	RenderGraph::RenderGraph(VkDevice device, MemoryAllocator& allocator)
+		: m_Device(device), m_Allocator(allocator)
+	{
+	}
+
+	RenderGraph::~RenderGraph()
+	{
+		ReleaseTransients();
+	}
+
+	void RenderGraph::Reset()
+	{
+		m_Resources.clear();
+		m_Passes.clear();
+		m_FinalBarriers.clear();
+	}
+
+	RenderResource RenderGraph::CreateImage(const std::string& name, const TransientImageDesc& desc)
+	{
+		ResourceNode resource;
+		resource.Name = name;
+		resource.IsImage = true;
+		resource.Desc = desc;
+		resource.Aspect = GetAspectMask(desc.Format);
+
+		m_Resources.push_back(resource);
+		return static_cast<RenderResource>(m_Resources.size() - 1);
+	}
+
+	RenderResource RenderGraph::ImportImage(const std::string& name, VkImage image, VkFormat format, ResourceUsage initial, ResourceUsage final)
+	{
+		ResourceNode resource;
+		resource.Name = name;
+		resource.IsImage = true;
+		resource.Imported = true;
+		resource.Image = image;
+		resource.Aspect = GetAspectMask(format);
+		resource.Initial = initial;
+		resource.Final = final;
+
+		m_Resources.push_back(resource);
+		return static_cast<RenderResource>(m_Resources.size() - 1);
+	}
+
+	RenderResource RenderGraph::ImportBuffer(const std::string& name, ResourceUsage initial, ResourceUsage final)
+	{
+		ResourceNode resource;
+		resource.Name = name;
+		resource.Imported = true;
+		resource.Initial = initial;
+		resource.Final = final;
+
+		m_Resources.push_back(resource);
+		return static_cast<RenderResource>(m_Resources.size() - 1);
+	}
+
+	uint32_t RenderGraph::AddPass(const std::string& name, RecordCallback record)
+	{
+		PassNode pass;
+		pass.Name = name;
+		pass.Record = std::move(record);
+
+		m_Passes.push_back(std::move(pass));
+		return static_cast<uint32_t>(m_Passes.size() - 1);
+	}
+
+	void RenderGraph::Read(uint32_t pass, RenderResource resource, ResourceUsage usage)
+	{
+		m_Passes[pass].Accesses.push_back({ resource, usage, false });
+	}
+
+	void RenderGraph::Write(uint32_t pass, RenderResource resource, ResourceUsage usage)
+	{
+		m_Passes[pass].Accesses.push_back({ resource, usage, true });
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Compilation
+	//////////////////////////////////////////////////////////////////////////////////
+
+	void RenderGraph::Compile()
+	{
+		m_Stats = RenderGraphStats();
+		m_Stats.PassCount = static_cast<uint32_t>(m_Passes.size());
+
+		CullPasses();
+
+		// Lifetimes, and the usages transient images are created with
+		for (uint32_t i = 0; i < m_Passes.size(); i++)
+		{
+			if (m_Passes[i].Culled)
+				continue;
+
+			for (const ResourceAccess& access : m_Passes[i].Accesses)
+			{
+				ResourceNode& resource = m_Resources[access.Resource];
+				resource.FirstPass = std::min(resource.FirstPass, i);
+				resource.LastPass = std::max(resource.LastPass, i);
+				resource.ImageUsage |= GetImageUsageFlags(access.Usage);
+			}
+		}
+
+		PlaceTransients();
+		BuildBarriers();
+	}
+
+	void RenderGraph::CullPasses()
+	{
+		// Passes count the resources they write, resources the passes reading them
+		for (PassNode& pass : m_Passes)
+		{
+			for (const ResourceAccess& access : pass.Accesses)
+			{
+				if (access.Write)
+					pass.RefCount++;
+				else
+					m_Resources[access.Resource].RefCount++;
+			}
+		}
+
+		// Imported resources used after the graph are what keeps passes alive
+		std::vector<RenderResource> unused;
+		for (RenderResource i = 0; i < m_Resources.size(); i++)
+		{
+			if (m_Resources[i].Imported && m_Resources[i].Final != ResourceUsage::None)
+				m_Resources[i].RefCount++;
+
+			if (m_Resources[i].RefCount == 0)
+				unused.push_back(i);
+		}
+
+		auto cull = [&](PassNode& pass)
+		{
+			pass.Culled = true;
+			m_Stats.CulledPasses++;
+
+			for (const ResourceAccess& access : pass.Accesses)
+			{
+				if (!access.Write && --m_Resources[access.Resource].RefCount == 0)
+					unused.push_back(access.Resource);
+			}
+		};
+
+		for (PassNode& pass : m_Passes)
+		{
+			if (pass.RefCount == 0)
+				cull(pass);
+		}
+
+		// A pass whose every output is unused goes, which may leave its inputs unused in turn
+		while (!unused.empty())
+		{
+			RenderResource resource = unused.back();
+			unused.pop_back();
+
+			for (PassNode& pass : m_Passes)
+			{
+				if (pass.Culled)
+					continue;
+
+				for (const ResourceAccess& access : pass.Accesses)
+				{
+					if (access.Write && access.Resource == resource && --pass.RefCount == 0)
+					{
+						cull(pass);
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	void RenderGraph::PlaceTransients()
+	{
+		// Transient images that survived culling, in the order they are first used
+		std::vector<RenderResource> order;
+		for (RenderResource i = 0; i < m_Resources.size(); i++)
+		{
+			if (m_Resources[i].IsImage && !m_Resources[i].Imported && m_Resources[i].FirstPass != UINT32_MAX)
+				order.push_back(i);
+		}
+
+		std::stable_sort(order.begin(), order.end(), [&](RenderResource a, RenderResource b) { return m_Resources[a].FirstPass < m_Resources[b].FirstPass; });
+
+		std::vector<TransientImage> images(order.size());
+		for (size_t i = 0; i < order.size(); i++)
+		{
+			const ResourceNode& resource = m_Resources[order[i]];
+			images[i].Desc = resource.Desc;
+			images[i].Usage = resource.ImageUsage;
+
+			if ((resource.ImageUsage & ~ATTACHMENT_USAGE_MASK) == 0)
+				images[i].Usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+		}
+
+		// Same images as last compile, they are kept unless their placement changed
+		bool reuse = images.size() == m_TransientImages.size();
+		for (size_t i = 0; reuse && i < images.size(); i++)
+		{
+			const TransientImage& cached = m_TransientImages[i];
+			reuse = images[i].Desc.Format == cached.Desc.Format && images[i].Desc.Extent.width == cached.Desc.Extent.width &&
+				images[i].Desc.Extent.height == cached.Desc.Extent.height && images[i].Desc.Samples == cached.Desc.Samples && images[i].Usage == cached.Usage;
+		}
+
+		if (reuse)
+		{
+			for (size_t i = 0; i < images.size(); i++)
+				images[i].Requirements = m_TransientImages[i].Requirements;
+
+			reuse = AssignMemory(order, images) == m_TransientMemory.size();
+			for (size_t i = 0; reuse && i < images.size(); i++)
+				reuse = images[i].Memory == m_TransientImages[i].Memory;
+		}
+
+		if (!reuse)
+		{
+			ReleaseTransients();
+			CreateTransients(order, images);
+		}
+
+		for (size_t i = 0; i < order.size(); i++)
+		{
+			m_Resources[order[i]].Transient = static_cast<uint32_t>(i);
+			m_Resources[order[i]].Image = m_TransientImages[i].Image;
+			m_Stats.UnaliasedBytes += m_TransientImages[i].Requirements.size;
+		}
+
+		for (const TransientMemory& memory : m_TransientMemory)
+			m_Stats.TransientBytes += memory.Memory.Size;
+
+		m_Stats.TransientImages = static_cast<uint32_t>(m_TransientImages.size());
+	}
+
+	uint32_t RenderGraph::AssignMemory(const std::vector<RenderResource>& order, std::vector<TransientImage>& images) const
+	{
+		struct MemorySlot
+		{
+			uint32_t LastPass;
+			uint32_t TypeBits;
+		};
+
+		// First fit, an image moves into memory whose images were all last used before its first pass
+		std::vector<MemorySlot> slots;
+		for (size_t i = 0; i < order.size(); i++)
+		{
+			const ResourceNode& resource = m_Resources[order[i]];
+			uint32_t typeBits = images[i].Requirements.memoryTypeBits;
+
+			uint32_t slot = 0;
+			while (slot < slots.size() && (slots[slot].LastPass >= resource.FirstPass || !(slots[slot].TypeBits & typeBits)))
+				slot++;
+
+			if (slot == slots.size())
+				slots.push_back({ resource.LastPass, typeBits });
+
+			slots[slot].LastPass = resource.LastPass;
+			slots[slot].TypeBits &= typeBits;
+			images[i].Memory = slot;
+		}
+
+		return static_cast<uint32_t>(slots.size());
+	}
+
+	void RenderGraph::CreateTransients(const std::vector<RenderResource>& order, std::vector<TransientImage>& images)
+	{
+		for (size_t i = 0; i < images.size(); i++)
+		{
+			TransientImage& image = images[i];
+
+			VkImageCreateInfo imageInfo{};
+			imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			imageInfo.imageType = VK_IMAGE_TYPE_2D;
+			imageInfo.format = image.Desc.Format;
+			imageInfo.extent = { image.Desc.Extent.width, image.Desc.Extent.height, 1 };
+			imageInfo.mipLevels = 1;
+			imageInfo.arrayLayers = 1;
+			imageInfo.samples = image.Desc.Samples;
+			imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			imageInfo.usage = image.Usage;
+			imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+			if (vkCreateImage(m_Device, &imageInfo, nullptr, &image.Image) != VK_SUCCESS)
+				std::cout << "Failed to create transient image " << m_Resources[order[i]].Name << "!" << std::endl;
+
+			vkGetImageMemoryRequirements(m_Device, image.Image, &image.Requirements);
+		}
+
+		m_TransientMemory.resize(AssignMemory(order, images));
+
+		// Every image sharing the memory is bound at its start
+		for (uint32_t slot = 0; slot < m_TransientMemory.size(); slot++)
+		{
+			VkMemoryRequirements requirements{ 0, 1, UINT32_MAX };
+			for (const TransientImage& image : images)
+			{
+				if (image.Memory != slot)
+					continue;
+
+				requirements.size = std::max(requirements.size, image.Requirements.size);
+				requirements.alignment = std::max(requirements.alignment, image.Requirements.alignment);
+				requirements.memoryTypeBits &= image.Requirements.memoryTypeBits;
+			}
+
+			// Only transient attachments allow lazily allocated types, tilers then never back them with memory
+			m_TransientMemory[slot].Memory = m_Allocator.Allocate(requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT, ResourceKind::Optimal);
+			if (!m_TransientMemory[slot].Memory.IsValid())
+				std::cout << "Failed to allocate transient memory!" << std::endl;
+		}
+
+		for (size_t i = 0; i < images.size(); i++)
+		{
+			TransientImage& image = images[i];
+			const Allocation& memory = m_TransientMemory[image.Memory].Memory;
+
+			if (memory.IsValid())
+				vkBindImageMemory(m_Device, image.Image, memory.Memory, memory.Offset);
+
+			VkImageViewCreateInfo viewInfo{};
+			viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			viewInfo.image = image.Image;
+			viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			viewInfo.format = image.Desc.Format;
+			viewInfo.subresourceRange.aspectMask = m_Resources[order[i]].Aspect;
+			viewInfo.subresourceRange.baseMipLevel = 0;
+			viewInfo.subresourceRange.levelCount = 1;
+			viewInfo.subresourceRange.baseArrayLayer = 0;
+			viewInfo.subresourceRange.layerCount = 1;
+
+			if (vkCreateImageView(m_Device, &viewInfo, nullptr, &image.View) != VK_SUCCESS)
+				std::cout << "Failed to create transient image view " << m_Resources[order[i]].Name << "!" << std::endl;
+		}
+
+		m_TransientImages = images;
+	}
+
+	void RenderGraph::ReleaseTransients()
+	{
+		for (TransientImage& image : m_TransientImages)
+		{
+			vkDestroyImageView(m_Device, image.View, nullptr);
+			vkDestroyImage(m_Device, image.Image, nullptr);
+		}
+
+		for (TransientMemory& memory : m_TransientMemory)
+		{
+			if (memory.Memory.IsValid())
+				m_Allocator.Free(memory.Memory);
+		}
+
+		m_TransientImages.clear();
+		m_TransientMemory.clear();
+		m_PendingLastUsage.clear();
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Barriers
+	//////////////////////////////////////////////////////////////////////////////////
+
+	void RenderGraph::BuildBarriers()
+	{
+		std::vector<ResourceState> states(m_Resources.size());
+		std::vector<bool> tracked(m_Resources.size(), false);
+
+		// What last touched each transient memory, the previous frame's use until an image in it is first used
+		m_PendingLastUsage.resize(m_TransientMemory.size());
+		for (size_t i = 0; i < m_TransientMemory.size(); i++)
+			m_PendingLastUsage[i] = m_TransientMemory[i].LastUsage;
+
+		auto track = [&](RenderResource index)
+		{
+			if (tracked[index])
+				return;
+
+			const ResourceNode& resource = m_Resources[index];
+			bool transient = resource.Transient != UINT32_MAX;
+
+			// Transient contents never carry over, only the accesses to the memory have to finish
+			ResourceUsage previous = transient ? m_PendingLastUsage[m_TransientImages[resource.Transient].Memory] : resource.Initial;
+			UsageInfo info = GetUsageInfo(previous);
+
+			ResourceState& state = states[index];
+			if (info.Access & WRITE_ACCESS_MASK)
+			{
+				state.WriteStages = info.Stages;
+				state.WriteAccess = info.Access & WRITE_ACCESS_MASK;
+			}
+			else
+			{
+				state.ReadStages = info.Stages;
+			}
+
+			state.Layout = transient ? VK_IMAGE_LAYOUT_UNDEFINED : info.Layout;
+			tracked[index] = true;
+		};
+
+		for (PassNode& pass : m_Passes)
+		{
+			if (pass.Culled)
+				continue;
+
+			for (const ResourceAccess& access : pass.Accesses)
+			{
+				const ResourceNode& resource = m_Resources[access.Resource];
+
+				track(access.Resource);
+				AddBarrier(pass.Barriers, resource, states[access.Resource], access.Usage, access.Write);
+
+				if (resource.Transient != UINT32_MAX)
+					m_PendingLastUsage[m_TransientImages[resource.Transient].Memory] = access.Usage;
+			}
+		}
+
+		// Imported resources are left the way whoever uses them next expects
+		for (RenderResource i = 0; i < m_Resources.size(); i++)
+		{
+			if (!m_Resources[i].Imported || m_Resources[i].Final == ResourceUsage::None)
+				continue;
+
+			track(i);
+			AddBarrier(m_FinalBarriers, m_Resources[i], states[i], m_Resources[i].Final, false);
+		}
+
+		auto count = [&](const std::vector<BarrierBatch>& batches)
+		{
+			for (const BarrierBatch& batch : batches)
+			{
+				m_Stats.BarrierBatches++;
+				m_Stats.Barriers += static_cast<uint32_t>(batch.ImageBarriers.size());
+				if (batch.MemoryBarrier.srcAccessMask || batch.MemoryBarrier.dstAccessMask)
+					m_Stats.Barriers++;
+			}
+		};
+
+		for (const PassNode& pass : m_Passes)
+			count(pass.Barriers);
+		count(m_FinalBarriers);
+	}
+
+	void RenderGraph::AddBarrier(std::vector<BarrierBatch>& batches, const ResourceNode& resource, ResourceState& state, ResourceUsage usage, bool write)
+	{
+		UsageInfo info = GetUsageInfo(usage);
+		bool transition = resource.IsImage && info.Layout != state.Layout;
+
+		VkPipelineStageFlags srcStages = 0;
+		VkAccessFlags srcAccess = 0;
+
+		if (write || transition)
+		{
+			// Reads since the last write already waited for it, so only they have to finish
+			if (state.ReadStages)
+			{
+				srcStages = state.ReadStages;
+			}
+			else
+			{
+				srcStages = state.WriteStages;
+				srcAccess = state.WriteAccess;
+			}
+		}
+		else if ((info.Stages & ~state.VisibleStages) || (info.Access & ~state.VisibleAccess))
+		{
+			// The last write isn't visible to this read yet
+			srcStages = state.WriteStages;
+			srcAccess = state.WriteAccess;
+		}
+
+		if (srcStages || transition)
+		{
+			if (!srcStages)
+				srcStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+
+			auto batch = std::find_if(batches.begin(), batches.end(), [&](const BarrierBatch& b) { return b.SrcStages == srcStages && b.DstStages == info.Stages; });
+			if (batch == batches.end())
+			{
+				batches.emplace_back();
+				batch = batches.end() - 1;
+				batch->SrcStages = srcStages;
+				batch->DstStages = info.Stages;
+				batch->MemoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			}
+
+			if (resource.IsImage)
+			{
+				VkImageMemoryBarrier barrier{};
+				barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+				barrier.srcAccessMask = srcAccess;
+				barrier.dstAccessMask = info.Access;
+				barrier.oldLayout = state.Layout;
+				barrier.newLayout = info.Layout;
+				barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.image = resource.Image;
+				barrier.subresourceRange.aspectMask = resource.Aspect;
+				barrier.subresourceRange.baseMipLevel = 0;
+				barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+				barrier.subresourceRange.baseArrayLayer = 0;
+				barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+
+				batch->ImageBarriers.push_back(barrier);
+			}
+			else if (srcAccess)
+			{
+				batch->MemoryBarrier.srcAccessMask |= srcAccess;
+				batch->MemoryBarrier.dstAccessMask |= info.Access;
+			}
+		}
+
+		if (write)
+		{
+			// Attachments read what they write, so a writer sees its own results
+			state.WriteStages = info.Stages;
+			state.WriteAccess = info.Access & WRITE_ACCESS_MASK;
+			state.ReadStages = 0;
+			state.VisibleStages = info.Stages;
+			state.VisibleAccess = info.Access;
+		}
+		else
+		{
+			state.ReadStages |= info.Stages;
+			state.VisibleStages |= info.Stages;
+			state.VisibleAccess |= info.Access;
+		}
+
+		if (resource.IsImage)
+			state.Layout = info.Layout;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Execution
+	//////////////////////////////////////////////////////////////////////////////////
+
+	void RenderGraph::Execute(VkCommandBuffer commandBuffer)
+	{
+		for (PassNode& pass : m_Passes)
+		{
+			if (pass.Culled)
+				continue;
+
+			CmdBarriers(commandBuffer, pass.Barriers);
+			pass.Record(commandBuffer);
+		}
+
+		CmdBarriers(commandBuffer, m_FinalBarriers);
+
+		for (size_t i = 0; i < m_PendingLastUsage.size(); i++)
+			m_TransientMemory[i].LastUsage = m_PendingLastUsage[i];
+	}
+
+	void RenderGraph::CmdBarriers(VkCommandBuffer commandBuffer, const std::vector<BarrierBatch>& batches) const
+	{
+		for (const BarrierBatch& batch : batches)
+		{
+			// Execution only when nothing has to be made visible
+			uint32_t memoryBarrierCount = batch.MemoryBarrier.srcAccessMask || batch.MemoryBarrier.dstAccessMask ? 1 : 0;
+
+			vkCmdPipelineBarrier(commandBuffer, batch.SrcStages, batch.DstStages, 0, memoryBarrierCount, &batch.MemoryBarrier, 0, nullptr,
+				static_cast<uint32_t>(batch.ImageBarriers.size()), batch.ImageBarriers.data());
+		}
+	}
+
+	VkImageView RenderGraph::GetImageView(RenderResource resource) const
+	{
+		uint32_t transient = m_Resources[resource].Transient;
+		return transient != UINT32_MAX ? m_TransientImages[transient].View : VK_NULL_HANDLE;
+	}
+
+}
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "MemoryAllocator.h"
+
+#define INVALID_RENDER_RESOURCE UINT32_MAX
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Render Graph Resources
+	//////////////////////////////////////////////////////////////////////////////////
+
+	using RenderResource = uint32_t;
+
+	// How a pass touches a resource, each maps to the stages, accesses and image layout barriers are built from
+	enum class ResourceUsage
+	{
+		// Nothing to wait for, the contents are undefined
+		None = 0,
+		// Swapchain image, its acquire semaphore is waited on at the color output stage
+		Acquire,
+		ColorAttachment,
+		DepthAttachment,
+		ComputeRead,
+		ComputeWrite,
+		FragmentRead,
+		IndirectRead,
+		TransferRead,
+		TransferWrite,
+		HostRead,
+		Present
+	};
+
+	// Owned by the graph, contents only live from the first to the last pass using the image
+	struct TransientImageDesc
+	{
+		VkFormat Format = VK_FORMAT_UNDEFINED;
+		VkExtent2D Extent = { 0, 0 };
+		VkSampleCountFlagBits Samples = VK_SAMPLE_COUNT_1_BIT;
+	};
+
+	struct RenderGraphStats
+	{
+		uint32_t PassCount = 0;
+		uint32_t CulledPasses = 0;
+
+		// Image and memory barriers, and the vkCmdPipelineBarrier calls they are batched into
+		uint32_t Barriers = 0;
+		uint32_t BarrierBatches = 0;
+
+		uint32_t TransientImages = 0;
+		VkDeviceSize TransientBytes = 0;
+		// What the transient images would take without aliasing
+		VkDeviceSize UnaliasedBytes = 0;
+	};
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Render Graph
+	//////////////////////////////////////////////////////////////////////////////////
+
+	// Declared every frame. Passes name the resources they read and write, Compile culls passes
+	// nothing consumes, places transient images whose lifetimes don't overlap in the same memory
+	// and derives every barrier and layout transition between the passes. Passes run in the
+	// order they were added and record no synchronization for the resources they declared
+	class RenderGraph
+	{
+	public:
+		using RecordCallback = std::function<void(VkCommandBuffer commandBuffer)>;
+
+		RenderGraph(VkDevice device, MemoryAllocator& allocator);
+		~RenderGraph();
+
+		// Drops the declared passes and resources, transient images are kept for the next Compile
+		void Reset();
+
+		RenderResource CreateImage(const std::string& name, const TransientImageDesc& desc);
+		// A final usage other than None keeps the passes writing the resource alive
+		RenderResource ImportImage(const std::string& name, VkImage image, VkFormat format, ResourceUsage initial, ResourceUsage final);
+		// Buffers are synchronized with global memory barriers, so only their usage is tracked
+		RenderResource ImportBuffer(const std::string& name, ResourceUsage initial, ResourceUsage final);
+
+		// A pass that writes nothing is culled
+		uint32_t AddPass(const std::string& name, RecordCallback record);
+		void Read(uint32_t pass, RenderResource resource, ResourceUsage usage);
+		void Write(uint32_t pass, RenderResource resource, ResourceUsage usage);
+
+		// Transient images are only created again when their descriptions or placement changed,
+		// nothing submitted may still use them then
+		void Compile();
+		void Execute(VkCommandBuffer commandBuffer);
+
+		// Destroys the transient images, nothing submitted may still use them
+		void ReleaseTransients();
+
+		// Transient images only, valid after Compile
+		VkImageView GetImageView(RenderResource resource) const;
+		const RenderGraphStats& GetStats() const { return m_Stats; }
+
+	private:
+		struct ResourceAccess
+		{
+			RenderResource Resource;
+			ResourceUsage Usage;
+			bool Write;
+		};
+
+		struct ResourceNode
+		{
+			std::string Name;
+			bool IsImage = false;
+			bool Imported = false;
+
+			TransientImageDesc Desc;
+			VkImageUsageFlags ImageUsage = 0;
+			VkImage Image = VK_NULL_HANDLE;
+			VkImageAspectFlags Aspect = 0;
+
+			ResourceUsage Initial = ResourceUsage::None;
+			ResourceUsage Final = ResourceUsage::None;
+
+			uint32_t RefCount = 0;
+			uint32_t FirstPass = UINT32_MAX;
+			uint32_t LastPass = 0;
+			uint32_t Transient = UINT32_MAX;
+		};
+
+		// Barriers sharing a source and destination stage mask, recorded with one vkCmdPipelineBarrier
+		struct BarrierBatch
+		{
+			VkPipelineStageFlags SrcStages = 0;
+			VkPipelineStageFlags DstStages = 0;
+			VkMemoryBarrier MemoryBarrier{};
+			std::vector<VkImageMemoryBarrier> ImageBarriers;
+		};
+
+		struct PassNode
+		{
+			std::string Name;
+			RecordCallback Record;
+			std::vector<ResourceAccess> Accesses;
+
+			uint32_t RefCount = 0;
+			bool Culled = false;
+
+			std::vector<BarrierBatch> Barriers;
+		};
+
+		// Hazard tracking while barriers are derived
+		struct ResourceState
+		{
+			VkPipelineStageFlags WriteStages = 0;
+			VkAccessFlags WriteAccess = 0;
+			// Reads since the last write, and what the last write was made visible to
+			VkPipelineStageFlags ReadStages = 0;
+			VkPipelineStageFlags VisibleStages = 0;
+			VkAccessFlags VisibleAccess = 0;
+			VkImageLayout Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		};
+
+		struct TransientImage
+		{
+			TransientImageDesc Desc;
+			VkImageUsageFlags Usage = 0;
+			uint32_t Memory = 0;
+
+			VkImage Image = VK_NULL_HANDLE;
+			VkImageView View = VK_NULL_HANDLE;
+			VkMemoryRequirements Requirements{};
+		};
+
+		// Shared by transient images whose lifetimes don't overlap
+		struct TransientMemory
+		{
+			Allocation Memory;
+			// Last use of the memory by any image, the next frame's first use waits on it
+			ResourceUsage LastUsage = ResourceUsage::None;
+		};
+
+		void CullPasses();
+		void PlaceTransients();
+		// Returns the number of memory allocations the images share
+		uint32_t AssignMemory(const std::vector<RenderResource>& order, std::vector<TransientImage>& images) const;
+		void CreateTransients(const std::vector<RenderResource>& order, std::vector<TransientImage>& images);
+		void BuildBarriers();
+
+		void AddBarrier(std::vector<BarrierBatch>& batches, const ResourceNode& resource, ResourceState& state, ResourceUsage usage, bool write);
+		void CmdBarriers(VkCommandBuffer commandBuffer, const std::vector<BarrierBatch>& batches) const;
+
+	private:
+		VkDevice m_Device;
+		MemoryAllocator& m_Allocator;
+
+		std::vector<ResourceNode> m_Resources;
+		std::vector<PassNode> m_Passes;
+		std::vector<BarrierBatch> m_FinalBarriers;
+
+		// Kept across frames while the declared transients don't change
+		std::vector<TransientImage> m_TransientImages;
+		std::vector<TransientMemory> m_TransientMemory;
+		std::vector<ResourceUsage> m_PendingLastUsage;
+
+		RenderGraphStats m_Stats;
+	};
+
+}
@@ -0,0 +1,660 @@
+#include "ShaderReflection.h"
+
+#include <iostream>
+#include <cstring>
+#include <map>
+#include <algorithm>
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// SPIR-V Parsing
+	//////////////////////////////////////////////////////////////////////////////////
+
+	// The subset of the SPIR-V grammar the reflection reads
+	enum SpirvOp : uint32_t
+	{
+		SpvOpEntryPoint = 15,
+		SpvOpTypeInt = 21,
+		SpvOpTypeFloat = 22,
+		SpvOpTypeVector = 23,
+		SpvOpTypeMatrix = 24,
+		SpvOpTypeImage = 25,
+		SpvOpTypeSampler = 26,
+		SpvOpTypeSampledImage = 27,
+		SpvOpTypeArray = 28,
+		SpvOpTypeRuntimeArray = 29,
+		SpvOpTypeStruct = 30,
+		SpvOpTypePointer = 32,
+		SpvOpConstant = 43,
+		SpvOpSpecConstant = 50,
+		SpvOpVariable = 59,
+		SpvOpDecorate = 71,
+		SpvOpMemberDecorate = 72
+	};
+
+	enum SpirvDecoration : uint32_t
+	{
+		SpvDecorationBlock = 2,
+		SpvDecorationBufferBlock = 3,
+		SpvDecorationArrayStride = 6,
+		SpvDecorationMatrixStride = 7,
+		SpvDecorationBuiltIn = 11,
+		SpvDecorationLocation = 30,
+		SpvDecorationBinding = 33,
+		SpvDecorationDescriptorSet = 34,
+		SpvDecorationOffset = 35
+	};
+
+	enum SpirvStorageClass : uint32_t
+	{
+		SpvStorageClassUniformConstant = 0,
+		SpvStorageClassInput = 1,
+		SpvStorageClassUniform = 2,
+		SpvStorageClassPushConstant = 9,
+		SpvStorageClassStorageBuffer = 12
+	};
+
+	static const uint32_t SpirvMagic = 0x07230203;
+	static const uint32_t SpirvDimBuffer = 5;
+	static const uint32_t SpirvDimSubpassData = 6;
+	// Universal limit on the id bound
+	static const uint32_t SpirvMaxBound = 0x3fffff;
+	// Deeper types are treated as malformed, they can only nest this far through a cycle
+	static const uint32_t SpirvMaxTypeDepth = 64;
+
+	struct SpirvId
+	{
+		uint32_t Opcode = 0;
+		// Result type of constants and variables
+		uint32_t TypeId = 0;
+		// Words following the result id
+		std::vector<uint32_t> Operands;
+
+		uint32_t Location = UINT32_MAX;
+		uint32_t Binding = UINT32_MAX;
+		uint32_t Set = 0;
+		uint32_t ArrayStride = 0;
+		bool BuiltIn = false;
+		bool BufferBlock = false;
+
+		std::vector<uint32_t> MemberOffsets;
+		std::vector<uint32_t> MemberMatrixStrides;
+	};
+
+	// Operands a type instruction needs before the reflection reads it
+	static size_t GetMinOperandCount(uint32_t opcode)
+	{
+		switch (opcode)
+		{
+		case SpvOpTypeInt:			return 2;
+		case SpvOpTypeFloat:		return 1;
+		case SpvOpTypeVector:		return 2;
+		case SpvOpTypeMatrix:		return 2;
+		case SpvOpTypeImage:		return 7;
+		case SpvOpTypeSampledImage:	return 1;
+		case SpvOpTypeArray:		return 2;
+		case SpvOpTypeRuntimeArray:	return 1;
+		case SpvOpTypePointer:		return 2;
+		}
+
+		return 0;
+	}
+
+	// nullptr when the id is out of bounds or was never defined
+	static const SpirvId* FindId(const std::vector<SpirvId>& ids, uint32_t id)
+	{
+		if (id >= ids.size() || ids[id].Opcode == 0)
+			return nullptr;
+
+		return &ids[id];
+	}
+
+	// Array lengths have to be constants
+	static bool GetArrayLength(const std::vector<SpirvId>& ids, const SpirvId& array, uint32_t& length)
+	{
+		const SpirvId* constant = FindId(ids, array.Operands[1]);
+		if (!constant || (constant->Opcode != SpvOpConstant && constant->Opcode != SpvOpSpecConstant))
+			return false;
+
+		length = constant->Operands[0];
+		return true;
+	}
+
+	static bool GetTypeSize(const std::vector<SpirvId>& ids, uint32_t typeId, uint32_t& size, uint32_t matrixStride = 0, uint32_t depth = 0)
+	{
+		const SpirvId* type = FindId(ids, typeId);
+		if (!type || depth > SpirvMaxTypeDepth)
+			return false;
+
+		uint32_t elementSize = 0;
+		switch (type->Opcode)
+		{
+		case SpvOpTypeInt:
+		case SpvOpTypeFloat:
+			size = type->Operands[0] / 8;
+			return true;
+		case SpvOpTypeVector:
+			if (!GetTypeSize(ids, type->Operands[0], elementSize, 0, depth + 1))
+				return false;
+			size = type->Operands[1] * elementSize;
+			return true;
+		case SpvOpTypeMatrix:
+			if (!matrixStride && !GetTypeSize(ids, type->Operands[0], elementSize, 0, depth + 1))
+				return false;
+			size = type->Operands[1] * (matrixStride ? matrixStride : elementSize);
+			return true;
+		case SpvOpTypeArray:
+		{
+			uint32_t length = 0;
+			if (!GetArrayLength(ids, *type, length) || (!type->ArrayStride && !GetTypeSize(ids, type->Operands[0], elementSize, matrixStride, depth + 1)))
+				return false;
+			size = length * (type->ArrayStride ? type->ArrayStride : elementSize);
+			return true;
+		}
+		case SpvOpTypeStruct:
+		{
+			size = 0;
+			for (size_t i = 0; i < type->Operands.size(); i++)
+			{
+				uint32_t offset = i < type->MemberOffsets.size() ? type->MemberOffsets[i] : 0;
+				uint32_t memberMatrixStride = i < type->MemberMatrixStrides.size() ? type->MemberMatrixStrides[i] : 0;
+				if (!GetTypeSize(ids, type->Operands[i], elementSize, memberMatrixStride, depth + 1))
+					return false;
+				size = std::max(size, offset + elementSize);
+			}
+			return true;
+		}
+		}
+
+		// Runtime arrays and opaque types take no space in a block
+		size = 0;
+		return true;
+	}
+
+	static bool GetShaderStage(uint32_t executionModel, VkShaderStageFlagBits& stage)
+	{
+		switch (executionModel)
+		{
+		case 0:	stage = VK_SHADER_STAGE_VERTEX_BIT; return true;
+		case 1:	stage = VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT; return true;
+		case 2:	stage = VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT; return true;
+		case 3:	stage = VK_SHADER_STAGE_GEOMETRY_BIT; return true;
+		case 4:	stage = VK_SHADER_STAGE_FRAGMENT_BIT; return true;
+		case 5:	stage = VK_SHADER_STAGE_COMPUTE_BIT; return true;
+		}
+
+		return false;
+	}
+
+	static bool GetDescriptorType(const SpirvId& type, uint32_t storageClass, VkDescriptorType& descriptorType)
+	{
+		if (storageClass == SpvStorageClassStorageBuffer)
+		{
+			descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			return true;
+		}
+
+		if (storageClass == SpvStorageClassUniform)
+		{
+			// Older compilers still emit storage buffers as BufferBlock uniforms
+			descriptorType = type.BufferBlock ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			return true;
+		}
+
+		switch (type.Opcode)
+		{
+		case SpvOpTypeSampler:
+			descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+			return true;
+		case SpvOpTypeSampledImage:
+			descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			return true;
+		case SpvOpTypeImage:
+		{
+			uint32_t dim = type.Operands[1];
+			bool storage = type.Operands[5] == 2;
+
+			if (dim == SpirvDimBuffer)
+				descriptorType = storage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+			else if (dim == SpirvDimSubpassData)
+				descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+			else
+				descriptorType = storage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+			return true;
+		}
+		}
+
+		return false;
+	}
+
+	bool ReflectShader(const void* code, size_t size, ShaderReflection& reflection)
+	{
+		reflection = ShaderReflection();
+
+		if (size < 5 * sizeof(uint32_t) || size % sizeof(uint32_t) != 0)
+		{
+			std::cout << "Failed to reflect shader: not a SPIR-V module!" << std::endl;
+			return false;
+		}
+
+		std::vector<uint32_t> words(size / sizeof(uint32_t));
+		std::memcpy(words.data(), code, size);
+
+		if (words[0] != SpirvMagic)
+		{
+			std::cout << "Failed to reflect shader: not a SPIR-V module!" << std::endl;
+			return false;
+		}
+
+		uint32_t bound = words[3];
+		if (bound > SpirvMaxBound)
+		{
+			std::cout << "Failed to reflect shader: id bound " << bound << " is out of range!" << std::endl;
+			return false;
+		}
+
+		std::vector<SpirvId> ids(bound);
+		std::vector<uint32_t> variables;
+		bool hasEntryPoint = false;
+
+		auto validId = [bound](uint32_t id) { return id < bound; };
+
+		for (size_t offset = 5; offset < words.size();)
+		{
+			uint32_t wordCount = words[offset] >> 16;
+			uint32_t opcode = words[offset] & 0xffff;
+
+			if (wordCount == 0 || offset + wordCount > words.size())
+			{
+				std::cout << "Failed to reflect shader: truncated instruction!" << std::endl;
+				return false;
+			}
+
+			const uint32_t* instruction = &words[offset];
+
+			switch (opcode)
+			{
+			case SpvOpEntryPoint:
+			{
+				if (wordCount < 4 || hasEntryPoint)
+					break;
+
+				if (!GetShaderStage(instruction[1], reflection.Stage))
+				{
+					std::cout << "Failed to reflect shader: unsupported execution model " << instruction[1] << "!" << std::endl;
+					return false;
+				}
+
+				const char* name = reinterpret_cast<const char*>(instruction + 3);
+				reflection.EntryPoint.assign(name, strnlen(name, (wordCount - 3) * sizeof(uint32_t)));
+				hasEntryPoint = true;
+				break;
+			}
+			case SpvOpDecorate:
+			{
+				if (wordCount < 3 || !validId(instruction[1]))
+					break;
+
+				SpirvId& target = ids[instruction[1]];
+				uint32_t value = wordCount > 3 ? instruction[3] : 0;
+
+				switch (instruction[2])
+				{
+				case SpvDecorationBufferBlock:	target.BufferBlock = true; break;
+				case SpvDecorationArrayStride:	target.ArrayStride = value; break;
+				case SpvDecorationBuiltIn:		target.BuiltIn = true; break;
+				case SpvDecorationLocation:		target.Location = value; break;
+				case SpvDecorationBinding:		target.Binding = value; break;
+				case SpvDecorationDescriptorSet:	target.Set = value; break;
+				}
+				break;
+			}
+			case SpvOpMemberDecorate:
+			{
+				if (wordCount < 4 || !validId(instruction[1]))
+					break;
+
+				// A struct can't have more members than the module has words
+				SpirvId& target = ids[instruction[1]];
+				uint32_t member = instruction[2];
+				if (member >= words.size())
+				{
+					std::cout << "Failed to reflect shader: member decoration out of range!" << std::endl;
+					return false;
+				}
+
+				uint32_t value = wordCount > 4 ? instruction[4] : 0;
+
+				if (instruction[3] == SpvDecorationOffset)
+				{
+					target.MemberOffsets.resize(std::max<size_t>(target.MemberOffsets.size(), member + 1));
+					target.MemberOffsets[member] = value;
+				}
+				else if (instruction[3] == SpvDecorationMatrixStride)
+				{
+					target.MemberMatrixStrides.resize(std::max<size_t>(target.MemberMatrixStrides.size(), member + 1));
+					target.MemberMatrixStrides[member] = value;
+				}
+				break;
+			}
+			case SpvOpTypeInt:
+			case SpvOpTypeFloat:
+			case SpvOpTypeVector:
+			case SpvOpTypeMatrix:
+			case SpvOpTypeImage:
+			case SpvOpTypeSampler:
+			case SpvOpTypeSampledImage:
+			case SpvOpTypeArray:
+			case SpvOpTypeRuntimeArray:
+			case SpvOpTypeStruct:
+			case SpvOpTypePointer:
+			{
+				if (wordCount < 2 + GetMinOperandCount(opcode) || !validId(instruction[1]) || ids[instruction[1]].Opcode != 0)
+				{
+					std::cout << "Failed to reflect shader: malformed type instruction!" << std::endl;
+					return false;
+				}
+
+				SpirvId& type = ids[instruction[1]];
+				type.Opcode = opcode;
+				type.Operands.assign(instruction + 2, instruction + wordCount);
+				break;
+			}
+			case SpvOpConstant:
+			case SpvOpSpecConstant:
+			case SpvOpVariable:
+			{
+				if (wordCount < 4 || !validId(instruction[2]) || ids[instruction[2]].Opcode != 0)
+				{
+					std::cout << "Failed to reflect shader: malformed " << (opcode == SpvOpVariable ? "variable" : "constant") << "!" << std::endl;
+					return false;
+				}
+
+				SpirvId& result = ids[instruction[2]];
+				result.Opcode = opcode;
+				result.TypeId = instruction[1];
+				result.Operands.assign(instruction + 3, instruction + wordCount);
+
+				if (opcode == SpvOpVariable)
+					variables.push_back(instruction[2]);
+				break;
+			}
+			}
+
+			offset += wordCount;
+		}
+
+		if (!hasEntryPoint)
+		{
+			std::cout << "Failed to reflect shader: no entry point!" << std::endl;
+			return false;
+		}
+
+		for (uint32_t variableId : variables)
+		{
+			const SpirvId& variable = ids[variableId];
+			const SpirvId* pointer = FindId(ids, variable.TypeId);
+			if (!pointer || pointer->Opcode != SpvOpTypePointer)
+			{
+				std::cout << "Failed to reflect shader: variable " << variableId << " is not a pointer!" << std::endl;
+				return false;
+			}
+
+			uint32_t storageClass = variable.Operands[0];
+			uint32_t typeId = pointer->Operands[1];
+			const SpirvId* type = FindId(ids, typeId);
+			if (!type)
+			{
+				std::cout << "Failed to reflect shader: variable " << variableId << " has an undefined type!" << std::endl;
+				return false;
+			}
+
+			if (storageClass == SpvStorageClassInput)
+			{
+				// Built-ins and interface blocks carry no vertex attribute
+				if (variable.BuiltIn || variable.Location == UINT32_MAX || type->Opcode == SpvOpTypeStruct)
+					continue;
+
+				ShaderInput input{ variable.Location, ShaderBaseType::Float, 1 };
+
+				if (type->Opcode == SpvOpTypeVector)
+				{
+					input.ComponentCount = type->Operands[1];
+					type = FindId(ids, type->Operands[0]);
+					if (!type)
+					{
+						std::cout << "Failed to reflect shader: input at location " << input.Location << " has an undefined component type!" << std::endl;
+						return false;
+					}
+				}
+
+				if (type->Opcode == SpvOpTypeInt)
+					input.BaseType = type->Operands[1] ? ShaderBaseType::Int : ShaderBaseType::Uint;
+
+				reflection.Inputs.push_back(input);
+			}
+			else if (storageClass == SpvStorageClassPushConstant)
+			{
+				uint32_t size = 0;
+				if (!GetTypeSize(ids, typeId, size))
+				{
+					std::cout << "Failed to reflect shader: malformed push constant block!" << std::endl;
+					return false;
+				}
+
+				reflection.PushConstantSize = std::max(reflection.PushConstantSize, size);
+			}
+			else if (storageClass == SpvStorageClassUniform || storageClass == SpvStorageClassUniformConstant || storageClass == SpvStorageClassStorageBuffer)
+			{
+				if (variable.Binding == UINT32_MAX)
+					continue;
+
+				ShaderDescriptorBinding binding{ variable.Set, variable.Binding, VK_DESCRIPTOR_TYPE_MAX_ENUM, 1, static_cast<VkShaderStageFlags>(reflection.Stage) };
+
+				// Arrays of descriptors, runtime sized ones report a count of 0
+				for (uint32_t depth = 0; type && (type->Opcode == SpvOpTypeArray || type->Opcode == SpvOpTypeRuntimeArray); depth++)
+				{
+					uint32_t length = 0;
+					if (depth > SpirvMaxTypeDepth || (type->Opcode == SpvOpTypeArray && !GetArrayLength(ids, *type, length)))
+					{
+						type = nullptr;
+						break;
+					}
+
+					binding.Count = type->Opcode == SpvOpTypeArray ? binding.Count * length : 0;
+					type = FindId(ids, type->Operands[0]);
+				}
+
+				if (!type || !GetDescriptorType(*type, storageClass, binding.Type))
+				{
+					std::cout << "Failed to reflect shader: unsupported descriptor at set " << binding.Set << " binding " << binding.Binding << "!" << std::endl;
+					return false;
+				}
+
+				reflection.Bindings.push_back(binding);
+			}
+		}
+
+		std::sort(reflection.Inputs.begin(), reflection.Inputs.end(), [](const ShaderInput& a, const ShaderInput& b) { return a.Location < b.Location; });
+
+		return true;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Pipeline Layouts
+	//////////////////////////////////////////////////////////////////////////////////
+
+	bool CreateReflectedPipelineLayout(VkDevice device, const std::vector<ShaderReflection>& stages, const std::vector<VkDescriptorSetLayout>& sharedSetLayouts, VkPipelineLayout& layout, std::vector<VkDescriptorSetLayout>& setLayouts)
+	{
+		auto isShared = [&](uint32_t set) { return set < sharedSetLayouts.size() && sharedSetLayouts[set] != VK_NULL_HANDLE; };
+
+		std::map<uint32_t, std::map<uint32_t, VkDescriptorSetLayoutBinding>> sets;
+		VkPushConstantRange pushConstantRange{};
+
+		for (const auto& stage : stages)
+		{
+			for (const auto& binding : stage.Bindings)
+			{
+				// Shared layouts may hold unsized arrays, they are declared with the layout's own size
+				if (isShared(binding.Set))
+					continue;
+
+				if (binding.Count == 0)
+				{
+					std::cout << "Failed to create pipeline layout: set " << binding.Set << " binding " << binding.Binding << " is an unsized array!" << std::endl;
+					return false;
+				}
+
+				auto& bindings = sets[binding.Set];
+				auto it = bindings.find(binding.Binding);
+
+				if (it == bindings.end())
+				{
+					VkDescriptorSetLayoutBinding layoutBinding{};
+					layoutBinding.binding = binding.Binding;
+					layoutBinding.descriptorType = binding.Type;
+					layoutBinding.descriptorCount = binding.Count;
+					layoutBinding.stageFlags = stage.Stage;
+					bindings[binding.Binding] = layoutBinding;
+				}
+				else if (it->second.descriptorType != binding.Type || it->second.descriptorCount != binding.Count)
+				{
+					std::cout << "Failed to create pipeline layout: stages disagree about set " << binding.Set << " binding " << binding.Binding << "!" << std::endl;
+					return false;
+				}
+				else
+				{
+					it->second.stageFlags |= stage.Stage;
+				}
+			}
+
+			// One range shared by every stage that declares a block
+			if (stage.PushConstantSize)
+			{
+				pushConstantRange.stageFlags |= stage.Stage;
+				pushConstantRange.size = std::max(pushConstantRange.size, stage.PushConstantSize);
+			}
+		}
+
+		// Gaps in the set numbers get empty layouts
+		uint32_t setCount = sets.empty() ? 0 : sets.rbegin()->first + 1;
+		for (uint32_t set = 0; set < sharedSetLayouts.size(); set++)
+		{
+			if (isShared(set))
+				setCount = std::max(setCount, set + 1);
+		}
+
+		setLayouts.assign(setCount, VK_NULL_HANDLE);
+		std::vector<VkDescriptorSetLayout> pipelineSetLayouts(setCount, VK_NULL_HANDLE);
+
+		auto destroySetLayouts = [&]()
+		{
+			for (auto setLayout : setLayouts)
+				vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+			setLayouts.clear();
+		};
+
+		for (uint32_t set = 0; set < setCount; set++)
+		{
+			if (isShared(set))
+			{
+				pipelineSetLayouts[set] = sharedSetLayouts[set];
+				continue;
+			}
+
+			std::vector<VkDescriptorSetLayoutBinding> bindings;
+			for (const auto& binding : sets[set])
+				bindings.push_back(binding.second);
+
+			VkDescriptorSetLayoutCreateInfo setLayoutInfo{};
+			setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+			setLayoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+			setLayoutInfo.pBindings = bindings.data();
+
+			if (vkCreateDescriptorSetLayout(device, &setLayoutInfo, nullptr, &setLayouts[set]) != VK_SUCCESS)
+			{
+				std::cout << "Failed to create descriptor set layout!" << std::endl;
+				destroySetLayouts();
+				return false;
+			}
+
+			pipelineSetLayouts[set] = setLayouts[set];
+		}
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = setCount;
+		pipelineLayoutInfo.pSetLayouts = pipelineSetLayouts.data();
+		pipelineLayoutInfo.pushConstantRangeCount = pushConstantRange.size ? 1 : 0;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+		if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &layout) != VK_SUCCESS)
+		{
+			std::cout << "Failed to create pipeline layout!" << std::endl;
+			destroySetLayouts();
+			return false;
+		}
+
+		return true;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Vertex Input Validation
+	//////////////////////////////////////////////////////////////////////////////////
+
+	ShaderBaseType GetFormatBaseType(VkFormat format)
+	{
+		switch (format)
+		{
+		case VK_FORMAT_R32_UINT:
+		case VK_FORMAT_R32G32_UINT:
+		case VK_FORMAT_R32G32B32_UINT:
+		case VK_FORMAT_R32G32B32A32_UINT:
+		case VK_FORMAT_R16G16B16A16_UINT:
+		case VK_FORMAT_R16_UINT:
+		case VK_FORMAT_R8G8B8A8_UINT:
+			return ShaderBaseType::Uint;
+		case VK_FORMAT_R32_SINT:
+		case VK_FORMAT_R32G32_SINT:
+		case VK_FORMAT_R32G32B32_SINT:
+		case VK_FORMAT_R32G32B32A32_SINT:
+		case VK_FORMAT_R16G16B16A16_SINT:
+			return ShaderBaseType::Int;
+		default:
+			return ShaderBaseType::Float;
+		}
+	}
+
+	bool ValidateVertexInputs(const ShaderReflection& reflection, const VkPipelineVertexInputStateCreateInfo& vertexInput)
+	{
+		static const char* baseTypeNames[] = { "float", "int", "uint" };
+
+		for (const auto& input : reflection.Inputs)
+		{
+			const VkVertexInputAttributeDescription* attribute = nullptr;
+			for (uint32_t i = 0; i < vertexInput.vertexAttributeDescriptionCount; i++)
+			{
+				if (vertexInput.pVertexAttributeDescriptions[i].location == input.Location)
+					attribute = &vertexInput.pVertexAttributeDescriptions[i];
+			}
+
+			if (!attribute)
+			{
+				std::cout << "Vertex shader input at location " << input.Location << " has no vertex attribute!" << std::endl;
+				return false;
+			}
+
+			ShaderBaseType attributeType = GetFormatBaseType(attribute->format);
+			if (attributeType != input.BaseType)
+			{
+				std::cout << "Vertex shader input at location " << input.Location << " reads " << baseTypeNames[(int)input.BaseType]
+					<< " but its attribute is " << baseTypeNames[(int)attributeType] << "!" << std::endl;
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+}
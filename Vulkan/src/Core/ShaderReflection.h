@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <string>
+#include <vector>
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Shader Reflection
+	//////////////////////////////////////////////////////////////////////////////////
+
+	enum class ShaderBaseType
+	{
+		Float = 0,
+		Int,
+		Uint
+	};
+
+	struct ShaderInput
+	{
+		uint32_t Location;
+		ShaderBaseType BaseType;
+		uint32_t ComponentCount;
+	};
+
+	struct ShaderDescriptorBinding
+	{
+		uint32_t Set;
+		uint32_t Binding;
+		VkDescriptorType Type;
+		uint32_t Count;
+		VkShaderStageFlags Stages;
+	};
+
+	// What a pipeline layout needs to know about one SPIR-V module, read straight from the binary
+	struct ShaderReflection
+	{
+		VkShaderStageFlagBits Stage = VK_SHADER_STAGE_VERTEX_BIT;
+		std::string EntryPoint;
+
+		// Stage inputs with a location, built-ins are skipped
+		std::vector<ShaderInput> Inputs;
+		std::vector<ShaderDescriptorBinding> Bindings;
+
+		// Size of the push constant block, 0 without one
+		uint32_t PushConstantSize = 0;
+	};
+
+	bool ReflectShader(const void* code, size_t size, ShaderReflection& reflection);
+
+	// Merges the stages' bindings and push constants into set layouts and a pipeline layout. Sets with a
+	// non-null shared layout use it as is, setLayouts only receives the layouts created here
+	bool CreateReflectedPipelineLayout(VkDevice device, const std::vector<ShaderReflection>& stages, const std::vector<VkDescriptorSetLayout>& sharedSetLayouts, VkPipelineLayout& layout, std::vector<VkDescriptorSetLayout>& setLayouts);
+
+	// Every shader input has to be fed by an attribute of the same base type
+	bool ValidateVertexInputs(const ShaderReflection& reflection, const VkPipelineVertexInputStateCreateInfo& vertexInput);
+
+	ShaderBaseType GetFormatBaseType(VkFormat format);
+
+}
@@ -0,0 +1,156 @@
+#include "ShaderWatcher.h"
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+
+#ifdef __linux__
+	#include <sys/inotify.h>
+	#include <poll.h>
+	#include <unistd.h>
+#endif
+
+namespace Vulkan {
+
+	ShaderWatcher::ShaderWatcher(const std::string& directory, const ChangeCallback& callback)
+		: m_Directory(directory), m_Callback(callback)
+	{
+#ifdef __linux__
+		m_InotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+		// Compilers either rewrite the file in place or move a temporary over it
+		if (m_InotifyFd < 0 || inotify_add_watch(m_InotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+		{
+			std::cout << "Failed to watch shader directory: " << directory << "!" << std::endl;
+			if (m_InotifyFd >= 0)
+				close(m_InotifyFd);
+			m_InotifyFd = -1;
+			return;
+		}
+#else
+		ScanWriteTimes(nullptr);
+#endif
+
+		m_Thread = std::thread(&ShaderWatcher::Watch, this);
+	}
+
+	ShaderWatcher::~ShaderWatcher()
+	{
+		m_Running = false;
+		if (m_Thread.joinable())
+			m_Thread.join();
+
+#ifdef __linux__
+		if (m_InotifyFd >= 0)
+			close(m_InotifyFd);
+#endif
+	}
+
+	void ShaderWatcher::Watch()
+	{
+		while (m_Running)
+		{
+			std::vector<std::string> changed = WaitForChanges();
+			if (!changed.empty() && m_Running)
+				m_Callback(changed);
+		}
+	}
+
+#ifdef __linux__
+
+	std::vector<std::string> ShaderWatcher::WaitForChanges()
+	{
+		std::vector<std::string> changed;
+
+		pollfd descriptor{ m_InotifyFd, POLLIN, 0 };
+
+		// Wakes up regularly so the destructor never waits long
+		if (poll(&descriptor, 1, SHADER_WATCH_POLL_MS) <= 0)
+			return changed;
+
+		auto drain = [&]()
+		{
+			alignas(inotify_event) char buffer[4096];
+
+			ssize_t length;
+			while ((length = read(m_InotifyFd, buffer, sizeof(buffer))) > 0)
+			{
+				for (char* event = buffer; event < buffer + length;)
+				{
+					const inotify_event* info = reinterpret_cast<const inotify_event*>(event);
+					if (info->len)
+						changed.push_back(info->name);
+
+					event += sizeof(inotify_event) + info->len;
+				}
+			}
+		};
+
+		drain();
+
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(SHADER_WATCH_DEBOUNCE_MS);
+		for (;;)
+		{
+			int remaining = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count());
+			if (remaining <= 0)
+				break;
+
+			if (poll(&descriptor, 1, remaining) > 0)
+				drain();
+		}
+
+		std::sort(changed.begin(), changed.end());
+		changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+
+		return changed;
+	}
+
+#else
+
+	std::vector<std::string> ShaderWatcher::WaitForChanges()
+	{
+		std::vector<std::string> changed;
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(SHADER_WATCH_POLL_MS));
+		ScanWriteTimes(&changed);
+
+		// Let the writer finish before anyone reads the files
+		if (!changed.empty())
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(SHADER_WATCH_DEBOUNCE_MS));
+			ScanWriteTimes(&changed);
+		}
+
+		std::sort(changed.begin(), changed.end());
+		changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+
+		return changed;
+	}
+
+	void ShaderWatcher::ScanWriteTimes(std::vector<std::string>* changed)
+	{
+		std::error_code error;
+		for (const auto& entry : std::filesystem::directory_iterator(m_Directory, error))
+		{
+			if (!entry.is_regular_file(error))
+				continue;
+
+			auto writeTime = entry.last_write_time(error);
+			if (error)
+				continue;
+
+			std::string name = entry.path().filename().string();
+
+			auto it = m_WriteTimes.find(name);
+			if (it != m_WriteTimes.end() && it->second == writeTime)
+				continue;
+
+			m_WriteTimes[name] = writeTime;
+			if (changed)
+				changed->push_back(name);
+		}
+	}
+
+#endif
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <filesystem>
+
+// Editors and compilers touch a file several times per save, changes are batched over this window
+#define SHADER_WATCH_DEBOUNCE_MS 100
+// Poll interval where inotify is not available
+#define SHADER_WATCH_POLL_MS 250
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Shader Watcher
+	//////////////////////////////////////////////////////////////////////////////////
+
+	// Watches a directory for rewritten files on its own thread, inotify on Linux and
+	// modification times elsewhere. The callback runs on the watcher thread with the
+	// names of the files changed since the last call.
+	class ShaderWatcher
+	{
+	public:
+		using ChangeCallback = std::function<void(const std::vector<std::string>& files)>;
+
+		ShaderWatcher(const std::string& directory, const ChangeCallback& callback);
+		~ShaderWatcher();
+
+		bool IsWatching() const { return m_Thread.joinable(); }
+
+	private:
+		void Watch();
+
+		std::vector<std::string> WaitForChanges();
+#ifndef __linux__
+		void ScanWriteTimes(std::vector<std::string>* changed);
+#endif
+
+	private:
+		std::string m_Directory;
+		ChangeCallback m_Callback;
+
+		std::thread m_Thread;
+		std::atomic<bool> m_Running{ true };
+
+#ifdef __linux__
+		int m_InotifyFd = -1;
+#else
+		std::map<std::string, std::filesystem::file_time_type> m_WriteTimes;
+#endif
+	};
+
+}
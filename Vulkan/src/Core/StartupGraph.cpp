@@ -0,0 +1,208 @@
+#include "StartupGraph.h"
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Initialization
+	//////////////////////////////////////////////////////////////////////////////////
+
+	StartupGraph::StartupGraph()
+		: m_Start(std::chrono::high_resolution_clock::now())
+	{
+	}
+
+	StartupTask StartupGraph::AddTask(const std::string& name, const std::vector<StartupTask>& dependencies, TaskCallback callback, bool mainThread)
+	{
+		StartupTask task = static_cast<StartupTask>(m_Tasks.size());
+
+		TaskNode node;
+		node.Name = name;
+		node.Callback = std::move(callback);
+		node.MainThread = mainThread;
+
+		// Tasks can only depend on tasks added before them, so the graph never has a cycle
+		for (StartupTask dependency : dependencies)
+		{
+			if (dependency >= task)
+			{
+				std::cout << "Startup task " << name << " depends on a task that doesn't exist yet, ignoring it" << std::endl;
+				continue;
+			}
+
+			node.Dependencies.push_back(dependency);
+		}
+
+		node.PendingDependencies = static_cast<uint32_t>(node.Dependencies.size());
+		m_Tasks.push_back(std::move(node));
+		return task;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Execution
+	//////////////////////////////////////////////////////////////////////////////////
+
+	void StartupGraph::Run(ThreadPool& threadPool)
+	{
+		m_ThreadCount = threadPool.GetThreadCount();
+		m_RunStartMs = GetElapsedMs();
+
+		// Every thread keeps claiming tasks until the graph is done, the caller is thread 0
+		threadPool.Dispatch(m_ThreadCount, [this](uint32_t, uint32_t threadIndex) { RunTasks(threadIndex); });
+
+		m_RunEndMs = GetElapsedMs();
+	}
+
+	void StartupGraph::RunTasks(uint32_t threadIndex)
+	{
+		while (true)
+		{
+			StartupTask task = ClaimTask(threadIndex);
+			if (task == INVALID_STARTUP_TASK)
+				return;
+
+			TaskNode& node = m_Tasks[task];
+			node.Thread = threadIndex;
+			node.StartMs = GetElapsedMs();
+
+			node.Callback();
+
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			node.EndMs = GetElapsedMs();
+			node.Finished = true;
+			m_FinishedCount++;
+
+			for (TaskNode& dependent : m_Tasks)
+			{
+				if (std::find(dependent.Dependencies.begin(), dependent.Dependencies.end(), task) != dependent.Dependencies.end())
+					dependent.PendingDependencies--;
+			}
+
+			m_TaskFinished.notify_all();
+		}
+	}
+
+	StartupTask StartupGraph::ClaimTask(uint32_t threadIndex)
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+
+		while (m_FinishedCount < m_Tasks.size())
+		{
+			// The first thread runs main thread work before anything else, nothing else can take it
+			StartupTask ready = INVALID_STARTUP_TASK;
+			for (StartupTask i = 0; i < m_Tasks.size(); i++)
+			{
+				const TaskNode& node = m_Tasks[i];
+				if (node.Started || node.PendingDependencies > 0 || (node.MainThread && threadIndex != 0))
+					continue;
+
+				if (node.MainThread || ready == INVALID_STARTUP_TASK)
+					ready = i;
+				if (node.MainThread)
+					break;
+			}
+
+			if (ready != INVALID_STARTUP_TASK)
+			{
+				m_Tasks[ready].Started = true;
+				return ready;
+			}
+
+			m_TaskFinished.wait(lock);
+		}
+
+		return INVALID_STARTUP_TASK;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Trace
+	//////////////////////////////////////////////////////////////////////////////////
+
+	void StartupGraph::Mark(const std::string& name)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Marks.push_back({ name, GetElapsedMs() });
+	}
+
+	double StartupGraph::GetElapsedMs() const
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - m_Start).count();
+	}
+
+	void StartupGraph::Report() const
+	{
+		double taskMs = 0.0;
+		StartupTask last = INVALID_STARTUP_TASK;
+		for (StartupTask i = 0; i < m_Tasks.size(); i++)
+		{
+			taskMs += m_Tasks[i].EndMs - m_Tasks[i].StartMs;
+			if (last == INVALID_STARTUP_TASK || m_Tasks[i].EndMs > m_Tasks[last].EndMs)
+				last = i;
+		}
+
+		std::cout << "Startup: ";
+		if (!m_Marks.empty())
+			std::cout << m_Marks.back().TimeMs << " ms to " << m_Marks.back().Name << ", ";
+		std::cout << m_Tasks.size() << " init tasks took " << m_RunEndMs - m_RunStartMs << " ms on " << m_ThreadCount << " thread(s), " << taskMs << " ms serially" << std::endl;
+
+		if (last == INVALID_STARTUP_TASK)
+			return;
+
+		// Walk back through the dependency that finished last, nothing on the path could have started sooner
+		std::vector<StartupTask> path;
+		for (StartupTask task = last; task != INVALID_STARTUP_TASK;)
+		{
+			path.push_back(task);
+
+			StartupTask latest = INVALID_STARTUP_TASK;
+			for (StartupTask dependency : m_Tasks[task].Dependencies)
+			{
+				if (latest == INVALID_STARTUP_TASK || m_Tasks[dependency].EndMs > m_Tasks[latest].EndMs)
+					latest = dependency;
+			}
+
+			task = latest;
+		}
+
+		std::cout << "  Critical path:";
+		for (auto it = path.rbegin(); it != path.rend(); it++)
+			std::cout << (it == path.rbegin() ? " " : " > ") << m_Tasks[*it].Name << " " << m_Tasks[*it].EndMs - m_Tasks[*it].StartMs << " ms";
+		std::cout << std::endl;
+	}
+
+	bool StartupGraph::Export(const std::string& path) const
+	{
+		std::ofstream file(path, std::ios::trunc);
+		if (!file.is_open())
+		{
+			std::cout << "Failed to open startup trace " << path << "!" << std::endl;
+			return false;
+		}
+
+		ExportChromeTrace(file);
+
+		std::cout << "Startup trace: " << m_Tasks.size() << " tasks written to " << path << std::endl;
+		return true;
+	}
+
+	void StartupGraph::ExportChromeTrace(std::ostream& stream) const
+	{
+		stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << std::endl;
+		stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"Main\"}}";
+
+		for (const TaskNode& node : m_Tasks)
+		{
+			stream << "," << std::endl << "{\"name\":\"" << node.Name << "\",\"cat\":\"startup\",\"ph\":\"X\",\"pid\":0,\"tid\":" << node.Thread
+				<< ",\"ts\":" << node.StartMs * 1000.0 << ",\"dur\":" << (node.EndMs - node.StartMs) * 1000.0 << "}";
+		}
+
+		for (const MarkEvent& mark : m_Marks)
+			stream << "," << std::endl << "{\"name\":\"" << mark.Name << "\",\"cat\":\"startup\",\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":0,\"ts\":" << mark.TimeMs * 1000.0 << "}";
+
+		stream << std::endl << "]}" << std::endl;
+	}
+
+}
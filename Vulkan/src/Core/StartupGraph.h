@@ -0,0 +1,93 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <ostream>
+
+#include "ThreadPool.h"
+
+#define INVALID_STARTUP_TASK UINT32_MAX
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Startup Graph
+	//////////////////////////////////////////////////////////////////////////////////
+
+	using StartupTask = uint32_t;
+
+	// Initialization split into tasks that name the tasks they depend on. Run starts every task
+	// as soon as its dependencies finished, spread over the thread pool, and traces when and on
+	// which thread each one ran. Times are in milliseconds since the graph was created.
+	class StartupGraph
+	{
+	public:
+		using TaskCallback = std::function<void()>;
+
+	public:
+		StartupGraph();
+
+		// Main thread tasks only run on the thread calling Run, for window system calls
+		StartupTask AddTask(const std::string& name, const std::vector<StartupTask>& dependencies, TaskCallback callback, bool mainThread = false);
+
+		// Returns once every task finished
+		void Run(ThreadPool& threadPool);
+
+		// Traced as an instant, such as the first frame
+		void Mark(const std::string& name);
+		double GetElapsedMs() const;
+
+		// Prints the time to the last mark and the chain of tasks that bounded the graph
+		void Report() const;
+		// Chrome trace JSON
+		bool Export(const std::string& path) const;
+
+	private:
+		struct TaskNode
+		{
+			std::string Name;
+			std::vector<StartupTask> Dependencies;
+			TaskCallback Callback;
+			bool MainThread = false;
+
+			uint32_t PendingDependencies = 0;
+			bool Started = false;
+			bool Finished = false;
+
+			uint32_t Thread = 0;
+			double StartMs = 0.0;
+			double EndMs = 0.0;
+		};
+
+		struct MarkEvent
+		{
+			std::string Name;
+			double TimeMs;
+		};
+
+		void RunTasks(uint32_t threadIndex);
+		// INVALID_STARTUP_TASK when nothing the thread may run is ready
+		StartupTask ClaimTask(uint32_t threadIndex);
+
+		void ExportChromeTrace(std::ostream& stream) const;
+
+	private:
+		std::chrono::high_resolution_clock::time_point m_Start;
+
+		std::vector<TaskNode> m_Tasks;
+		std::vector<MarkEvent> m_Marks;
+
+		std::mutex m_Mutex;
+		std::condition_variable m_TaskFinished;
+		uint32_t m_FinishedCount = 0;
+
+		uint32_t m_ThreadCount = 1;
+		double m_RunStartMs = 0.0;
+		double m_RunEndMs = 0.0;
+	};
+
+}
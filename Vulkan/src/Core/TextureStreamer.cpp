@@ -0,0 +1,479 @@
+#include "TextureStreamer.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+
+#define KTX2_HEADER_SIZE 80
+#define KTX2_LEVEL_SIZE 24
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// KTX2
+	//////////////////////////////////////////////////////////////////////////////////
+
+	static const uint8_t s_Ktx2Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+	template<typename T>
+	static T ReadValue(const char* data, size_t offset)
+	{
+		T value;
+		memcpy(&value, data + offset, sizeof(T));
+		return value;
+	}
+
+	bool GetFormatBlockInfo(VkFormat format, FormatBlockInfo& info)
+	{
+		switch (format)
+		{
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_R8G8B8A8_SRGB:
+		case VK_FORMAT_B8G8R8A8_UNORM:
+		case VK_FORMAT_B8G8R8A8_SRGB:
+			info = { 1, 1, 4 };
+			return true;
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+		case VK_FORMAT_BC4_UNORM_BLOCK:
+		case VK_FORMAT_BC4_SNORM_BLOCK:
+			info = { 4, 4, 8 };
+			return true;
+		case VK_FORMAT_BC2_UNORM_BLOCK:
+		case VK_FORMAT_BC2_SRGB_BLOCK:
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+		case VK_FORMAT_BC5_SNORM_BLOCK:
+		case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+		case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+			info = { 4, 4, 16 };
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	bool ParseKtx2(const char* data, size_t size, Ktx2Image& image)
+	{
+		if (size < KTX2_HEADER_SIZE || memcmp(data, s_Ktx2Identifier, sizeof(s_Ktx2Identifier)) != 0)
+		{
+			std::cout << "Not a KTX2 file!" << std::endl;
+			return false;
+		}
+
+		VkFormat format = static_cast<VkFormat>(ReadValue<uint32_t>(data, 12));
+		uint32_t width = ReadValue<uint32_t>(data, 20);
+		uint32_t height = ReadValue<uint32_t>(data, 24);
+		uint32_t depth = ReadValue<uint32_t>(data, 28);
+		uint32_t layerCount = ReadValue<uint32_t>(data, 32);
+		uint32_t faceCount = ReadValue<uint32_t>(data, 36);
+		uint32_t levelCount = std::max(ReadValue<uint32_t>(data, 40), 1u);
+		uint32_t supercompression = ReadValue<uint32_t>(data, 44);
+
+		if (width == 0 || height == 0 || depth > 1 || layerCount > 1 || faceCount != 1 || supercompression != 0)
+		{
+			std::cout << "Only uncompressed 2D KTX2 textures are supported!" << std::endl;
+			return false;
+		}
+
+		FormatBlockInfo block;
+		if (!GetFormatBlockInfo(format, block))
+		{
+			std::cout << "Unsupported KTX2 format " << format << "!" << std::endl;
+			return false;
+		}
+
+		if (levelCount > 32 || KTX2_HEADER_SIZE + (size_t)levelCount * KTX2_LEVEL_SIZE > size)
+		{
+			std::cout << "Truncated KTX2 level index!" << std::endl;
+			return false;
+		}
+
+		image.Format = format;
+		image.Width = width;
+		image.Height = height;
+		image.Levels.resize(levelCount);
+		image.Data = data;
+
+		for (uint32_t i = 0; i < levelCount; i++)
+		{
+			size_t entry = KTX2_HEADER_SIZE + (size_t)i * KTX2_LEVEL_SIZE;
+			Ktx2Level& level = image.Levels[i];
+			level.Offset = ReadValue<uint64_t>(data, entry);
+			level.Size = ReadValue<uint64_t>(data, entry + 8);
+
+			uint64_t blocksX = (std::max(width >> i, 1u) + block.Width - 1) / block.Width;
+			uint64_t blocksY = (std::max(height >> i, 1u) + block.Height - 1) / block.Height;
+
+			if (level.Size != blocksX * blocksY * block.Bytes || level.Offset > size || level.Size > size - level.Offset)
+			{
+				std::cout << "Invalid KTX2 level " << i << "!" << std::endl;
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Texture Streamer
+	//////////////////////////////////////////////////////////////////////////////////
+
+	static const uint8_t s_WhiteTexel[4] = { 0xFF, 0xFF, 0xFF, 0xFF };
+
+	TextureStreamer::TextureStreamer(VkPhysicalDevice physicalDevice, VkDevice device, MemoryAllocator& allocator, UploadManager& uploads, QueueTimeline& graphicsTimeline, BindlessHeap& bindless, VkDeviceSize budget)
+		: m_PhysicalDevice(physicalDevice), m_Device(device), m_Allocator(allocator), m_Uploads(uploads), m_GraphicsTimeline(graphicsTimeline), m_Bindless(bindless), m_Budget(budget)
+	{
+		VkSamplerCreateInfo samplerInfo{};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = VK_FILTER_LINEAR;
+		samplerInfo.minFilter = VK_FILTER_LINEAR;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerInfo.minLod = 0.0f;
+		samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+		if (vkCreateSampler(m_Device, &samplerInfo, nullptr, &m_Sampler) != VK_SUCCESS)
+			std::cout << "Failed to create texture sampler!" << std::endl;
+
+		// The default texture is the fallback for every view, so it is resident before anything samples it
+		auto texture = std::make_unique<Texture>();
+		texture->Info.Format = VK_FORMAT_R8G8B8A8_UNORM;
+		texture->Info.Width = 1;
+		texture->Info.Height = 1;
+		texture->Info.Levels.push_back({ 0, sizeof(s_WhiteTexel) });
+		texture->Info.Data = reinterpret_cast<const char*>(s_WhiteTexel);
+		GetFormatBlockInfo(texture->Info.Format, texture->Block);
+
+		if (CreateChain(*texture, 0, texture->Current))
+		{
+			m_Uploads.Wait(texture->Current.Ticket);
+			texture->Current.DescriptorIndex = m_Bindless.AddTexture(texture->Current.View, m_Sampler);
+			m_TargetBytes = texture->Current.Bytes;
+		}
+
+		m_Textures.push_back(std::move(texture));
+	}
+
+	TextureStreamer::~TextureStreamer()
+	{
+		// Pending chains may still be copied into and retired ones sampled
+		vkDeviceWaitIdle(m_Device);
+
+		for (auto& texture : m_Textures)
+		{
+			DestroyImage(texture->Current);
+			DestroyImage(texture->Pending);
+		}
+
+		for (TextureImage& image : m_RetiredImages)
+			DestroyImage(image);
+
+		vkDestroySampler(m_Device, m_Sampler, nullptr);
+	}
+
+	TextureHandle TextureStreamer::Load(const AssetPack* pack, const std::string& path)
+	{
+		std::shared_ptr<AssetData>& source = m_Sources[path];
+		if (!source)
+		{
+			source = std::make_shared<AssetData>();
+			if (!LoadAsset(pack, path, AssetType::Texture, *source))
+			{
+				std::cout << "Failed to load texture " << path << "!" << std::endl;
+				m_Sources.erase(path);
+				return INVALID_TEXTURE_HANDLE;
+			}
+		}
+
+		auto texture = std::make_unique<Texture>();
+		texture->Source = source;
+
+		if (!ParseKtx2(source->Data, source->Size, texture->Info))
+		{
+			std::cout << "Failed to parse texture " << path << "!" << std::endl;
+			return INVALID_TEXTURE_HANDLE;
+		}
+
+		GetFormatBlockInfo(texture->Info.Format, texture->Block);
+
+		VkFormatProperties properties;
+		vkGetPhysicalDeviceFormatProperties(m_PhysicalDevice, texture->Info.Format, &properties);
+
+		if (!(properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT))
+		{
+			std::cout << "Texture format of " << path << " is not supported by the device!" << std::endl;
+			return INVALID_TEXTURE_HANDLE;
+		}
+
+		uint32_t levelCount = static_cast<uint32_t>(texture->Info.Levels.size());
+		while (texture->TailMip < levelCount - 1 && GetChainBytes(*texture, texture->TailMip) > TEXTURE_TAIL_BYTES)
+			texture->TailMip++;
+
+		// Nothing is resident until the tail is uploaded, the default texture stands in until then
+		texture->Current.BaseMip = levelCount;
+		texture->LastUsedFrame = m_Frame;
+
+		if (!RequestChain(*texture, texture->TailMip))
+			return INVALID_TEXTURE_HANDLE;
+
+		m_Textures.push_back(std::move(texture));
+		return static_cast<TextureHandle>(m_Textures.size() - 1);
+	}
+
+	void TextureStreamer::Touch(TextureHandle handle)
+	{
+		if (handle < m_Textures.size())
+			m_Textures[handle]->LastUsedFrame = m_Frame;
+	}
+
+	void TextureStreamer::Update()
+	{
+		uint64_t completed = m_GraphicsTimeline.GetCompletedValue();
+
+		for (size_t i = 0; i < m_RetiredImages.size();)
+		{
+			if (m_RetiredImages[i].RetireValue <= completed)
+			{
+				DestroyImage(m_RetiredImages[i]);
+				m_RetiredImages[i] = m_RetiredImages.back();
+				m_RetiredImages.pop_back();
+			}
+			else
+				i++;
+		}
+
+		// Finished chains replace the current ones in a new slot, frames already submitted keep sampling the old one
+		for (auto& texture : m_Textures)
+		{
+			if (!texture->Pending.Image || !m_Uploads.IsComplete(texture->Pending.Ticket))
+				continue;
+
+			texture->Pending.DescriptorIndex = m_Bindless.AddTexture(texture->Pending.View, m_Sampler);
+			if (texture->Pending.DescriptorIndex == INVALID_BINDLESS_INDEX)
+				continue;
+
+			if (texture->Current.Image)
+			{
+				m_Bindless.RemoveTexture(texture->Current.DescriptorIndex);
+				texture->Current.RetireValue = m_GraphicsTimeline.GetSubmittedValue();
+				m_RetiredImages.push_back(texture->Current);
+			}
+
+			texture->Current = texture->Pending;
+			texture->Pending = TextureImage();
+		}
+
+		// Over budget, the least recently used textures give up their finest level first
+		while (m_TargetBytes > m_Budget)
+		{
+			Texture* victim = FindEvictionCandidate(UINT64_MAX);
+			if (!victim || !RequestChain(*victim, victim->Current.BaseMip + 1))
+				break;
+		}
+
+		// Textures in use sharpen one level at a time, coarsest first, so all of them improve
+		// evenly instead of one reaching full resolution while the others stay blurry
+		std::vector<Texture*> candidates;
+		for (auto& texture : m_Textures)
+		{
+			if (texture->Current.Image && !texture->Pending.Image && texture->Current.BaseMip > 0 && texture->LastUsedFrame + TEXTURE_IDLE_FRAMES > m_Frame)
+				candidates.push_back(texture.get());
+		}
+
+		std::sort(candidates.begin(), candidates.end(), [](const Texture* a, const Texture* b)
+		{
+			if (a->Current.BaseMip != b->Current.BaseMip)
+				return a->Current.BaseMip > b->Current.BaseMip;
+			return a->LastUsedFrame > b->LastUsedFrame;
+		});
+
+		VkDeviceSize streamed = 0;
+		for (Texture* texture : candidates)
+		{
+			// An eviction for an earlier candidate may have replaced this one's chain already
+			if (texture->Pending.Image)
+				continue;
+
+			uint32_t baseMip = texture->Current.BaseMip - 1;
+			VkDeviceSize bytes = GetChainBytes(*texture, baseMip);
+			VkDeviceSize growth = bytes - texture->Current.Bytes;
+
+			if (streamed > 0 && streamed + bytes > TEXTURE_STREAM_BYTES_PER_FRAME)
+				break;
+
+			// Only textures used less recently make room, so two visible textures never trade levels
+			while (m_TargetBytes + growth > m_Budget)
+			{
+				Texture* victim = FindEvictionCandidate(texture->LastUsedFrame);
+				if (!victim || !RequestChain(*victim, victim->Current.BaseMip + 1))
+					break;
+			}
+
+			// The current chain stays allocated next to the new one until it is retired, the stream waits for the room
+			if (m_TargetBytes + growth > m_Budget || m_ResidentBytes + bytes > m_Budget)
+				continue;
+
+			if (RequestChain(*texture, baseMip))
+				streamed += bytes;
+		}
+
+		m_Frame++;
+	}
+
+	uint32_t TextureStreamer::GetDescriptorIndex(TextureHandle handle) const
+	{
+		if (handle < m_Textures.size() && m_Textures[handle]->Current.DescriptorIndex != INVALID_BINDLESS_INDEX)
+			return m_Textures[handle]->Current.DescriptorIndex;
+
+		return m_Textures[0]->Current.DescriptorIndex;
+	}
+
+	uint32_t TextureStreamer::GetResidentMip(TextureHandle handle) const
+	{
+		return handle < m_Textures.size() ? m_Textures[handle]->Current.BaseMip : 0;
+	}
+
+	TextureStats TextureStreamer::GetStats() const
+	{
+		TextureStats stats;
+		stats.TextureCount = static_cast<uint32_t>(m_Textures.size());
+		stats.ResidentBytes = m_ResidentBytes;
+		stats.PeakBytes = m_PeakBytes;
+		stats.Budget = m_Budget;
+		stats.StreamedLevels = m_StreamedLevels;
+		stats.EvictedLevels = m_EvictedLevels;
+
+		for (auto& texture : m_Textures)
+			stats.FullBytes += GetChainBytes(*texture, 0);
+
+		return stats;
+	}
+
+	VkDeviceSize TextureStreamer::GetChainBytes(const Texture& texture, uint32_t baseMip) const
+	{
+		VkDeviceSize bytes = 0;
+		for (size_t i = baseMip; i < texture.Info.Levels.size(); i++)
+			bytes += texture.Info.Levels[i].Size;
+
+		return bytes;
+	}
+
+	bool TextureStreamer::CreateChain(Texture& texture, uint32_t baseMip, TextureImage& image)
+	{
+		const Ktx2Image& info = texture.Info;
+		uint32_t levelCount = static_cast<uint32_t>(info.Levels.size()) - baseMip;
+
+		// The base level is the largest, a queue that only copies whole levels may not fit it through the staging ring
+		VkExtent2D baseExtent = { std::max(info.Width >> baseMip, 1u), std::max(info.Height >> baseMip, 1u) };
+		if (!m_Uploads.CanUploadImage(baseExtent, texture.Block.Height, info.Levels[baseMip].Size))
+			return false;
+
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.format = info.Format;
+		imageInfo.extent = { std::max(info.Width >> baseMip, 1u), std::max(info.Height >> baseMip, 1u), 1 };
+		imageInfo.mipLevels = levelCount;
+		imageInfo.arrayLayers = 1;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		if (!m_Allocator.CreateImage(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, image.Image, image.ImageAllocation))
+		{
+			std::cout << "Failed to create texture image!" << std::endl;
+			return false;
+		}
+
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = image.Image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = info.Format;
+		viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, levelCount, 0, 1 };
+
+		if (vkCreateImageView(m_Device, &viewInfo, nullptr, &image.View) != VK_SUCCESS)
+		{
+			std::cout << "Failed to create texture image view!" << std::endl;
+			m_Allocator.DestroyImage(image.Image, image.ImageAllocation);
+			image.Image = VK_NULL_HANDLE;
+			return false;
+		}
+
+		// Coarsest level first, the chain is only sampled once the last level is complete
+		for (uint32_t level = static_cast<uint32_t>(info.Levels.size()); level-- > baseMip;)
+		{
+			VkExtent2D extent = { std::max(info.Width >> level, 1u), std::max(info.Height >> level, 1u) };
+			image.Ticket = m_Uploads.UploadImage(image.Image, level - baseMip, extent, texture.Block.Height, info.Data + info.Levels[level].Offset, info.Levels[level].Size,
+				VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+		}
+
+		image.BaseMip = baseMip;
+		image.Bytes = GetChainBytes(texture, baseMip);
+
+		m_ResidentBytes += image.Bytes;
+		m_PeakBytes = std::max(m_PeakBytes, m_ResidentBytes);
+		return true;
+	}
+
+	void TextureStreamer::DestroyImage(TextureImage& image)
+	{
+		if (!image.Image)
+			return;
+
+		vkDestroyImageView(m_Device, image.View, nullptr);
+		m_Allocator.DestroyImage(image.Image, image.ImageAllocation);
+		m_ResidentBytes -= image.Bytes;
+		image = TextureImage();
+	}
+
+	bool TextureStreamer::RequestChain(Texture& texture, uint32_t baseMip)
+	{
+		// One chain in flight per texture, replacing Pending would leak the one still uploading
+		if (texture.Pending.Image)
+			return false;
+
+		TextureImage image;
+		if (!CreateChain(texture, baseMip, image))
+			return false;
+
+		m_TargetBytes = m_TargetBytes - texture.Current.Bytes + image.Bytes;
+
+		if (texture.Current.Image)
+		{
+			if (baseMip < texture.Current.BaseMip)
+				m_StreamedLevels += texture.Current.BaseMip - baseMip;
+			else
+				m_EvictedLevels += baseMip - texture.Current.BaseMip;
+		}
+
+		texture.Pending = image;
+		return true;
+	}
+
+	TextureStreamer::Texture* TextureStreamer::FindEvictionCandidate(uint64_t usedBefore)
+	{
+		Texture* victim = nullptr;
+		for (auto& texture : m_Textures)
+		{
+			if (!texture->Current.Image || texture->Pending.Image || texture->Current.BaseMip >= texture->TailMip || texture->LastUsedFrame >= usedBefore)
+				continue;
+
+			if (!victim || texture->LastUsedFrame < victim->LastUsedFrame)
+				victim = texture.get();
+		}
+
+		return victim;
+	}
+
+}
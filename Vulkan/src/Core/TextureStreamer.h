@@ -0,0 +1,179 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+#include "MemoryAllocator.h"
+#include "UploadManager.h"
+#include "QueueTimeline.h"
+#include "AssetPack.h"
+#include "BindlessHeap.h"
+
+// Mip chains at or below this size are uploaded on load and never evicted
+#define TEXTURE_TAIL_BYTES (64 * 1024)
+// Upper bound on the mip chains started per Update, a single larger chain still goes through
+#define TEXTURE_STREAM_BYTES_PER_FRAME (16ull * 1024 * 1024)
+// Textures not touched for this many updates stop streaming in and are evicted first
+#define TEXTURE_IDLE_FRAMES 120
+
+#define INVALID_TEXTURE_HANDLE UINT32_MAX
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// KTX2
+	//////////////////////////////////////////////////////////////////////////////////
+
+	struct Ktx2Level
+	{
+		uint64_t Offset;
+		uint64_t Size;
+	};
+
+	// A 2D texture without supercompression, levels point into the file
+	struct Ktx2Image
+	{
+		VkFormat Format = VK_FORMAT_UNDEFINED;
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+
+		// Level 0 is the full resolution image
+		std::vector<Ktx2Level> Levels;
+		const char* Data = nullptr;
+	};
+
+	bool ParseKtx2(const char* data, size_t size, Ktx2Image& image);
+
+	struct FormatBlockInfo
+	{
+		uint32_t Width;
+		uint32_t Height;
+		uint32_t Bytes;
+	};
+
+	// BC1-7 and 8-bit RGBA, false for anything else
+	bool GetFormatBlockInfo(VkFormat format, FormatBlockInfo& info);
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Texture Streamer
+	//////////////////////////////////////////////////////////////////////////////////
+
+	using TextureHandle = uint32_t;
+
+	struct TextureStats
+	{
+		uint32_t TextureCount = 0;
+
+		// Texel bytes allocated for mip chains, including ones still uploading and replaced ones not freed yet
+		VkDeviceSize ResidentBytes = 0;
+		VkDeviceSize PeakBytes = 0;
+		// What every texture would take fully resident
+		VkDeviceSize FullBytes = 0;
+		VkDeviceSize Budget = 0;
+
+		uint64_t StreamedLevels = 0;
+		uint64_t EvictedLevels = 0;
+	};
+
+	// Keeps a mip chain [BaseMip, LevelCount) of every texture resident. Loading only uploads the
+	// small tail of the chain, finer levels are streamed in through the upload manager while the
+	// texture is in use, and the least recently used textures give up their finest levels when
+	// the budget runs out. A chain is never resized in place, a new image with one level more or
+	// less is uploaded and replaces the old one once the transfer completed, moving the texture
+	// to a new bindless slot.
+	class TextureStreamer
+	{
+	public:
+		TextureStreamer(VkPhysicalDevice physicalDevice, VkDevice device, MemoryAllocator& allocator, UploadManager& uploads, QueueTimeline& graphicsTimeline, BindlessHeap& bindless, VkDeviceSize budget);
+		~TextureStreamer();
+
+		// Files loaded more than once share their source data, the file stays loaded for the streamer's lifetime
+		TextureHandle Load(const AssetPack* pack, const std::string& path);
+		// 1x1 white, always resident
+		TextureHandle GetDefaultTexture() const { return 0; }
+
+		// Marks a texture as used by the frame being recorded
+		void Touch(TextureHandle handle);
+		// Swaps in finished chains and starts new streams and evictions, call once per frame before the upload manager's Update
+		void Update();
+
+		// Bindless slot of the resident chain, the default texture's until the first chain is uploaded.
+		// Changes whenever the chain does, so it has to be looked up for every frame
+		uint32_t GetDescriptorIndex(TextureHandle handle) const;
+		uint32_t GetResidentMip(TextureHandle handle) const;
+
+		void SetBudget(VkDeviceSize budget) { m_Budget = budget; }
+		TextureStats GetStats() const;
+
+	private:
+		struct TextureImage
+		{
+			VkImage Image = VK_NULL_HANDLE;
+			Allocation ImageAllocation;
+			VkImageView View = VK_NULL_HANDLE;
+			uint32_t DescriptorIndex = INVALID_BINDLESS_INDEX;
+
+			uint32_t BaseMip = 0;
+			VkDeviceSize Bytes = 0;
+
+			UploadTicket Ticket = 0;
+			// Graphics timeline value after which a replaced image can be destroyed
+			uint64_t RetireValue = 0;
+		};
+
+		struct Texture
+		{
+			std::shared_ptr<AssetData> Source;
+			Ktx2Image Info;
+			FormatBlockInfo Block;
+
+			// Finest level that is never evicted
+			uint32_t TailMip = 0;
+
+			TextureImage Current;
+			TextureImage Pending;
+
+			uint64_t LastUsedFrame = 0;
+		};
+
+		VkDeviceSize GetChainBytes(const Texture& texture, uint32_t baseMip) const;
+		bool CreateChain(Texture& texture, uint32_t baseMip, TextureImage& image);
+		void DestroyImage(TextureImage& image);
+
+		// Replaces the current chain with one starting at baseMip
+		bool RequestChain(Texture& texture, uint32_t baseMip);
+		// Least recently used texture with an evictable level, used before the given frame
+		Texture* FindEvictionCandidate(uint64_t usedBefore);
+
+	private:
+		VkPhysicalDevice m_PhysicalDevice;
+		VkDevice m_Device;
+		MemoryAllocator& m_Allocator;
+		UploadManager& m_Uploads;
+		QueueTimeline& m_GraphicsTimeline;
+		BindlessHeap& m_Bindless;
+
+		VkSampler m_Sampler = VK_NULL_HANDLE;
+
+		std::vector<std::unique_ptr<Texture>> m_Textures;
+		std::unordered_map<std::string, std::shared_ptr<AssetData>> m_Sources;
+		std::vector<TextureImage> m_RetiredImages;
+
+		uint64_t m_Frame = 0;
+
+		// Chains count from creation until they are destroyed. Target bytes are what residency settles
+		// to once pending chains replaced the current ones, evictions are decided on those
+		VkDeviceSize m_Budget;
+		VkDeviceSize m_ResidentBytes = 0;
+		VkDeviceSize m_TargetBytes = 0;
+		VkDeviceSize m_PeakBytes = 0;
+
+		uint64_t m_StreamedLevels = 0;
+		uint64_t m_EvictedLevels = 0;
+	};
+
+}
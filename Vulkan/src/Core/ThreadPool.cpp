@@ -0,0 +1,109 @@
+#include "ThreadPool.h"
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Initialization and Destruction
+	//////////////////////////////////////////////////////////////////////////////////
+
+	ThreadPool::ThreadPool(uint32_t threadCount)
+	{
+		if (threadCount == 0)
+			threadCount = std::thread::hardware_concurrency();
+		if (threadCount == 0)
+			threadCount = 1;
+
+		for (uint32_t i = 1; i < threadCount; i++)
+			m_Workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Stop = true;
+		}
+
+		m_WorkAvailable.notify_all();
+
+		for (auto& worker : m_Workers)
+			worker.join();
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Dispatch
+	//////////////////////////////////////////////////////////////////////////////////
+
+	void ThreadPool::Dispatch(uint32_t count, const Job& job)
+	{
+		if (count == 0)
+			return;
+
+		// Nothing to gain from waking the workers for a single job
+		if (count == 1 || m_Workers.empty())
+		{
+			for (uint32_t i = 0; i < count; i++)
+				job(i, 0);
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Job = &job;
+			m_JobCount = count;
+			m_NextIndex = 0;
+			m_Generation++;
+		}
+
+		m_WorkAvailable.notify_all();
+
+		RunJobs(0);
+
+		// Every index is claimed at this point, wait for the workers still running one.
+		// Workers that wake up after m_Job is cleared skip this dispatch.
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_WorkDone.wait(lock, [this] { return m_ActiveWorkers == 0; });
+		m_Job = nullptr;
+	}
+
+	void ThreadPool::RunJobs(uint32_t threadIndex)
+	{
+		while (true)
+		{
+			uint32_t index = m_NextIndex.fetch_add(1);
+			if (index >= m_JobCount)
+				break;
+
+			(*m_Job)(index, threadIndex);
+		}
+	}
+
+	void ThreadPool::WorkerLoop(uint32_t threadIndex)
+	{
+		uint64_t seenGeneration = 0;
+
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_WorkAvailable.wait(lock, [&] { return m_Stop || (m_Job && m_Generation != seenGeneration); });
+
+				if (m_Stop)
+					return;
+
+				seenGeneration = m_Generation;
+				m_ActiveWorkers++;
+			}
+
+			RunJobs(threadIndex);
+
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				m_ActiveWorkers--;
+			}
+
+			m_WorkDone.notify_one();
+		}
+	}
+
+}
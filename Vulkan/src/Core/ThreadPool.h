@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Thread Pool
+	//////////////////////////////////////////////////////////////////////////////////
+
+	// Fork-join pool for per-frame work. The calling thread takes part in every
+	// dispatch as thread 0, workers are numbered 1 to GetThreadCount() - 1, so
+	// the thread index can select per-thread resources such as command pools.
+	class ThreadPool
+	{
+	public:
+		using Job = std::function<void(uint32_t index, uint32_t threadIndex)>;
+
+	public:
+		// 0 uses one thread per hardware core
+		ThreadPool(uint32_t threadCount = 0);
+		~ThreadPool();
+
+		// Runs job(i, thread) for every i in [0, count) and returns once all of them finished
+		void Dispatch(uint32_t count, const Job& job);
+
+		uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_Workers.size()) + 1; }
+
+	private:
+		void WorkerLoop(uint32_t threadIndex);
+		void RunJobs(uint32_t threadIndex);
+
+	private:
+		std::vector<std::thread> m_Workers;
+
+		std::mutex m_Mutex;
+		std::condition_variable m_WorkAvailable;
+		std::condition_variable m_WorkDone;
+
+		const Job* m_Job = nullptr;
+		uint32_t m_JobCount = 0;
+		std::atomic<uint32_t> m_NextIndex{ 0 };
+
+		uint64_t m_Generation = 0;
+		uint32_t m_ActiveWorkers = 0;
+		bool m_Stop = false;
+	};
+
+}
@@ -0,0 +1,123 @@
+#include "UniformRing.h"
+
+#include <iostream>
+#include <algorithm>
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Uniform Ring
+	//////////////////////////////////////////////////////////////////////////////////
+
+	UniformRing::UniformRing(VkPhysicalDevice physicalDevice, VkDevice device, MemoryAllocator& allocator, uint32_t frameCount)
+		: m_Device(device), m_Allocator(allocator), m_FrameCount(frameCount)
+	{
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+		m_Alignment = std::max<VkDeviceSize>(properties.limits.minUniformBufferOffsetAlignment, 16);
+		m_Range = std::min<VkDeviceSize>(UNIFORM_RING_MAX_RANGE, properties.limits.maxUniformBufferRange);
+
+		// The descriptor's range has to fit behind the last offset, so the buffer ends in one spare range
+		VkBufferCreateInfo bufferInfo{};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = VkDeviceSize(UNIFORM_RING_FRAME_SIZE) * m_FrameCount + m_Range;
+		bufferInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		if (!m_Allocator.CreateBuffer(bufferInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_Buffer, m_BufferAllocation))
+			std::cout << "Failed to create uniform ring buffer!" << std::endl;
+
+		VkDescriptorSetLayoutBinding binding{};
+		binding.binding = UNIFORM_RING_BINDING;
+		binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		binding.descriptorCount = 1;
+		binding.stageFlags = VK_SHADER_STAGE_ALL_GRAPHICS | VK_SHADER_STAGE_COMPUTE_BIT;
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo{};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.bindingCount = 1;
+		layoutInfo.pBindings = &binding;
+
+		if (vkCreateDescriptorSetLayout(m_Device, &layoutInfo, nullptr, &m_SetLayout) != VK_SUCCESS)
+			std::cout << "Failed to create uniform ring descriptor set layout!" << std::endl;
+
+		VkDescriptorPoolSize poolSize = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1 };
+
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.maxSets = 1;
+		poolInfo.poolSizeCount = 1;
+		poolInfo.pPoolSizes = &poolSize;
+
+		if (vkCreateDescriptorPool(m_Device, &poolInfo, nullptr, &m_Pool) != VK_SUCCESS)
+			std::cout << "Failed to create uniform ring descriptor pool!" << std::endl;
+
+		VkDescriptorSetAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = m_Pool;
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts = &m_SetLayout;
+
+		if (vkAllocateDescriptorSets(m_Device, &allocInfo, &m_Set) != VK_SUCCESS)
+			std::cout << "Failed to allocate uniform ring descriptor set!" << std::endl;
+
+		// Written once, every allocation only moves the dynamic offset
+		VkDescriptorBufferInfo descriptorBufferInfo{};
+		descriptorBufferInfo.buffer = m_Buffer;
+		descriptorBufferInfo.offset = 0;
+		descriptorBufferInfo.range = m_Range;
+
+		VkWriteDescriptorSet write{};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = m_Set;
+		write.dstBinding = UNIFORM_RING_BINDING;
+		write.descriptorCount = 1;
+		write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		write.pBufferInfo = &descriptorBufferInfo;
+
+		vkUpdateDescriptorSets(m_Device, 1, &write, 0, nullptr);
+	}
+
+	UniformRing::~UniformRing()
+	{
+		vkDestroyDescriptorPool(m_Device, m_Pool, nullptr);
+		vkDestroyDescriptorSetLayout(m_Device, m_SetLayout, nullptr);
+		m_Allocator.DestroyBuffer(m_Buffer, m_BufferAllocation);
+	}
+
+	void UniformRing::BeginFrame(uint32_t frameIndex)
+	{
+		m_FrameStart = VkDeviceSize(UNIFORM_RING_FRAME_SIZE) * (frameIndex % m_FrameCount);
+		m_FrameUsed = 0;
+	}
+
+	bool UniformRing::Allocate(VkDeviceSize size, uint32_t& dynamicOffset, void*& data)
+	{
+		if (size > m_Range)
+			return false;
+
+		VkDeviceSize alignedSize = (size + m_Alignment - 1) & ~(m_Alignment - 1);
+		VkDeviceSize offset = m_FrameUsed.fetch_add(alignedSize);
+
+		if (offset + alignedSize > UNIFORM_RING_FRAME_SIZE)
+			return false;
+
+		dynamicOffset = static_cast<uint32_t>(m_FrameStart + offset);
+		data = static_cast<uint8_t*>(m_BufferAllocation.MappedData) + dynamicOffset;
+		return true;
+	}
+
+	void UniformRing::Flush()
+	{
+		VkDeviceSize used = std::min<VkDeviceSize>(m_FrameUsed, UNIFORM_RING_FRAME_SIZE);
+		if (used)
+			m_Allocator.FlushAllocation(m_BufferAllocation, m_FrameStart, used);
+	}
+
+	void UniformRing::CmdBind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout layout, uint32_t dynamicOffset) const
+	{
+		vkCmdBindDescriptorSets(commandBuffer, bindPoint, layout, UNIFORM_RING_SET, 1, &m_Set, 1, &dynamicOffset);
+	}
+
+}
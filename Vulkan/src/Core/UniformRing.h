@@ -0,0 +1,79 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <cstring>
+
+#include "MemoryAllocator.h"
+
+// Bytes every frame in flight can allocate
+#define UNIFORM_RING_FRAME_SIZE (256 * 1024)
+// Largest single allocation, the dynamic descriptor's range
+#define UNIFORM_RING_MAX_RANGE (16 * 1024)
+
+// Set 1 of every pipeline that uses the ring, after the bindless set
+#define UNIFORM_RING_SET 1
+#define UNIFORM_RING_BINDING 0
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Uniform Ring
+	//////////////////////////////////////////////////////////////////////////////////
+
+	// Persistently mapped uniform memory split into one slice per frame in flight. Allocations
+	// bump a pointer in the current frame's slice and are addressed through a single
+	// UNIFORM_BUFFER_DYNAMIC descriptor, so per-frame constants need no buffers, descriptor
+	// writes or fences. A slice is reused once the frame that last used it completed
+	class UniformRing
+	{
+	public:
+		UniformRing(VkPhysicalDevice physicalDevice, VkDevice device, MemoryAllocator& allocator, uint32_t frameCount);
+		~UniformRing();
+
+		// Starts over at the frame's slice, everything allocated from it last time must be complete
+		void BeginFrame(uint32_t frameIndex);
+
+		// Thread safe. Returns false when the slice is full or size exceeds UNIFORM_RING_MAX_RANGE
+		bool Allocate(VkDeviceSize size, uint32_t& dynamicOffset, void*& data);
+
+		template<typename T>
+		bool Push(const T& value, uint32_t& dynamicOffset)
+		{
+			void* data;
+			if (!Allocate(sizeof(T), dynamicOffset, data))
+				return false;
+
+			memcpy(data, &value, sizeof(T));
+			return true;
+		}
+
+		// Makes the current slice visible to the device, no-op for HOST_COHERENT memory
+		void Flush();
+
+		void CmdBind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout layout, uint32_t dynamicOffset) const;
+
+		VkDescriptorSetLayout GetSetLayout() const { return m_SetLayout; }
+		VkDeviceSize GetAlignment() const { return m_Alignment; }
+
+	private:
+		VkDevice m_Device;
+		MemoryAllocator& m_Allocator;
+
+		VkBuffer m_Buffer = VK_NULL_HANDLE;
+		Allocation m_BufferAllocation;
+
+		VkDescriptorSetLayout m_SetLayout = VK_NULL_HANDLE;
+		VkDescriptorPool m_Pool = VK_NULL_HANDLE;
+		VkDescriptorSet m_Set = VK_NULL_HANDLE;
+
+		VkDeviceSize m_Alignment;
+		VkDeviceSize m_Range;
+		uint32_t m_FrameCount;
+
+		VkDeviceSize m_FrameStart = 0;
+		std::atomic<VkDeviceSize> m_FrameUsed{ 0 };
+	};
+
+}
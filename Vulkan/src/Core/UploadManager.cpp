@@ -0,0 +1,560 @@
+#include "UploadManager.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+
+#define UPLOAD_BATCH_COUNT 4
+#define UPLOAD_MIN_CHUNK VkDeviceSize(64 * 1024)
+#define STAGING_ALIGNMENT VkDeviceSize(16)
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Initialization and Destruction
+	//////////////////////////////////////////////////////////////////////////////////
+
+	UploadManager::UploadManager(VkPhysicalDevice physicalDevice, VkDevice device, MemoryAllocator& allocator, QueueTimeline& transferTimeline, uint32_t transferFamily, QueueTimeline& graphicsTimeline, uint32_t graphicsFamily, VkDeviceSize stagingSize)
+		: m_Device(device), m_Allocator(allocator), m_TransferTimeline(transferTimeline), m_GraphicsTimeline(graphicsTimeline),
+		m_TransferFamily(transferFamily), m_GraphicsFamily(graphicsFamily), m_StagingSize(stagingSize)
+	{
+		// Graphics and compute families always copy at any offset, transfer-only ones may not
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+		m_ImageGranularity = m_TransferFamily < queueFamilyCount ? queueFamilies[m_TransferFamily].minImageTransferGranularity : VkExtent3D{ 1, 1, 1 };
+
+		// Command Pools
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+		poolInfo.queueFamilyIndex = m_TransferFamily;
+		if (vkCreateCommandPool(m_Device, &poolInfo, nullptr, &m_TransferCommandPool) != VK_SUCCESS)
+			std::cout << "Failed to create transfer command pool!" << std::endl;
+
+		poolInfo.queueFamilyIndex = m_GraphicsFamily;
+		if (vkCreateCommandPool(m_Device, &poolInfo, nullptr, &m_GraphicsCommandPool) != VK_SUCCESS)
+			std::cout << "Failed to create upload acquire command pool!" << std::endl;
+
+		// Staging Ring
+		VkBufferCreateInfo bufferInfo{};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = m_StagingSize;
+		bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		if (!m_Allocator.CreateBuffer(bufferInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0, m_StagingBuffer, m_StagingAllocation))
+			std::cout << "Failed to create staging buffer!" << std::endl;
+
+		// Batches
+		m_Batches.resize(UPLOAD_BATCH_COUNT);
+
+		for (auto& batch : m_Batches)
+		{
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandBufferCount = 1;
+
+			allocInfo.commandPool = m_TransferCommandPool;
+			if (vkAllocateCommandBuffers(m_Device, &allocInfo, &batch.TransferCommandBuffer) != VK_SUCCESS)
+				std::cout << "Failed to allocate transfer command buffer!" << std::endl;
+
+			allocInfo.commandPool = m_GraphicsCommandPool;
+			if (vkAllocateCommandBuffers(m_Device, &allocInfo, &batch.AcquireCommandBuffer) != VK_SUCCESS)
+				std::cout << "Failed to allocate acquire command buffer!" << std::endl;
+		}
+	}
+
+	UploadManager::~UploadManager()
+	{
+		m_TransferTimeline.WaitIdle();
+		m_GraphicsTimeline.WaitIdle();
+
+		vkDestroyCommandPool(m_Device, m_TransferCommandPool, nullptr);
+		vkDestroyCommandPool(m_Device, m_GraphicsCommandPool, nullptr);
+
+		m_Allocator.DestroyBuffer(m_StagingBuffer, m_StagingAllocation);
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Uploads
+	//////////////////////////////////////////////////////////////////////////////////
+
+	UploadTicket UploadManager::UploadBuffer(VkBuffer dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		UploadRequest request;
+		request.Dst = dst;
+		request.DstOffset = dstOffset;
+		request.DstImage = VK_NULL_HANDLE;
+		request.Data = static_cast<const uint8_t*>(data);
+		request.Size = size;
+		request.Copied = 0;
+		request.DstStage = dstStage;
+		request.DstAccess = dstAccess;
+		request.Ticket = m_NextTicket++;
+
+		m_Requests.push_back(request);
+		return request.Ticket;
+	}
+
+	UploadTicket UploadManager::UploadImage(VkImage dst, uint32_t mipLevel, VkExtent2D extent, uint32_t blockHeight, const void* data, VkDeviceSize size, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+	{
+		uint32_t rowHeight;
+		VkDeviceSize rowBytes = GetImageChunkBytes(extent, blockHeight, size, rowHeight);
+		if (rowBytes > m_StagingSize)
+		{
+			std::cout << "Failed to upload image level, " << rowBytes << " bytes can't be split to fit the staging ring!" << std::endl;
+			return INVALID_UPLOAD_TICKET;
+		}
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		UploadRequest request;
+		request.Dst = VK_NULL_HANDLE;
+		request.DstOffset = 0;
+		request.DstImage = dst;
+		request.MipLevel = mipLevel;
+		request.Extent = extent;
+		request.RowHeight = rowHeight;
+		request.RowBytes = rowBytes;
+		request.Data = static_cast<const uint8_t*>(data);
+		request.Size = size;
+		request.Copied = 0;
+		request.DstStage = dstStage;
+		request.DstAccess = dstAccess;
+		request.Ticket = m_NextTicket++;
+
+		m_Requests.push_back(request);
+		return request.Ticket;
+	}
+
+	void UploadManager::Update()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		PollBatches();
+		RecordBatches();
+	}
+
+	bool UploadManager::CanUploadImage(VkExtent2D extent, uint32_t blockHeight, VkDeviceSize size) const
+	{
+		uint32_t rowHeight;
+		return GetImageChunkBytes(extent, blockHeight, size, rowHeight) <= m_StagingSize;
+	}
+
+	bool UploadManager::IsComplete(UploadTicket ticket)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return ticket <= m_CompletedTicket;
+	}
+
+	void UploadManager::Wait(UploadTicket ticket)
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+
+		if (ticket >= m_NextTicket)
+		{
+			std::cout << "Failed to wait for upload " << ticket << ", it was never requested!" << std::endl;
+			return;
+		}
+
+		while (ticket > m_CompletedTicket)
+		{
+			PollBatches();
+			RecordBatches();
+
+			if (ticket <= m_CompletedTicket)
+				break;
+
+			// The transfer carrying the ticket, or the oldest batch when the ticket still waits for staging space
+			QueueTimeline* timeline = nullptr;
+			uint64_t value = 0;
+
+			for (uint32_t index : m_InFlightBatches)
+			{
+				const UploadBatch& batch = m_Batches[index];
+				if (batch.State == BatchState::Transferring && batch.LastTicket >= ticket)
+				{
+					timeline = &m_TransferTimeline;
+					value = batch.TransferValue;
+					break;
+				}
+			}
+
+			if (!timeline && !m_InFlightBatches.empty())
+			{
+				const UploadBatch& batch = m_Batches[m_InFlightBatches.front()];
+				timeline = batch.State == BatchState::Transferring ? &m_TransferTimeline : &m_GraphicsTimeline;
+				value = batch.State == BatchState::Transferring ? batch.TransferValue : batch.AcquireValue;
+			}
+
+			if (!timeline)
+			{
+				std::cout << "Failed to wait for upload " << ticket << ", nothing is in flight!" << std::endl;
+				return;
+			}
+
+			// Blocks in vkWaitSemaphores, other threads keep queueing uploads meanwhile
+			lock.unlock();
+			timeline->Wait(value);
+			lock.lock();
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Batches
+	//////////////////////////////////////////////////////////////////////////////////
+
+	void UploadManager::PollBatches()
+	{
+		// Hand finished transfers over to the graphics queue, the transfer timeline has
+		// already reached the acquire's wait value so the graphics queue never stalls on it
+		uint64_t transferValue = m_TransferTimeline.GetCompletedValue();
+
+		for (uint32_t index : m_InFlightBatches)
+		{
+			UploadBatch& batch = m_Batches[index];
+			if (batch.State != BatchState::Transferring)
+				continue;
+
+			if (batch.TransferValue > transferValue)
+				break;
+
+			m_RingTail = batch.RingEnd;
+
+			if (!batch.AcquireBarriers.empty() || !batch.AcquireImageBarriers.empty())
+				SubmitAcquire(batch);
+
+			batch.State = BatchState::Acquiring;
+
+			// Work submitted to the graphics queue from now on sees the data
+			if (batch.LastTicket)
+				m_CompletedTicket = std::max(m_CompletedTicket, batch.LastTicket);
+		}
+
+		// Retire batches whose acquire has executed
+		uint64_t graphicsValue = m_GraphicsTimeline.GetCompletedValue();
+
+		while (!m_InFlightBatches.empty())
+		{
+			UploadBatch& batch = m_Batches[m_InFlightBatches.front()];
+
+			if (batch.State != BatchState::Acquiring || batch.AcquireValue > graphicsValue)
+				break;
+
+			batch.State = BatchState::Free;
+			m_InFlightBatches.pop_front();
+		}
+	}
+
+	void UploadManager::RecordBatches()
+	{
+		// Keep recording while there are free batches and staging space
+		for (uint32_t i = 0; i < m_Batches.size() && !m_Requests.empty(); i++)
+		{
+			if (m_Batches[i].State != BatchState::Free)
+				continue;
+
+			if (!RecordBatch(i))
+				break;
+		}
+	}
+
+	bool UploadManager::RecordBatch(uint32_t index)
+	{
+		UploadBatch& batch = m_Batches[index];
+
+		if (m_InFlightBatches.empty())
+			m_RingHead = m_RingTail = 0;
+
+		batch.AcquireBarriers.clear();
+		batch.AcquireImageBarriers.clear();
+		batch.AcquireStages = 0;
+		batch.LastTicket = 0;
+
+		std::vector<VkBufferMemoryBarrier> releaseBarriers;
+		std::vector<VkImageMemoryBarrier> releaseImageBarriers;
+		bool recorded = false;
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		if (vkBeginCommandBuffer(batch.TransferCommandBuffer, &beginInfo) != VK_SUCCESS)
+			std::cout << "Failed to begin recording upload batch!" << std::endl;
+
+		while (!m_Requests.empty())
+		{
+			UploadRequest& request = m_Requests.front();
+
+			// Large uploads are split into chunks that continue in later batches
+			VkDeviceSize stagingOffset;
+			VkDeviceSize chunk = AcquireStaging(request.Size - request.Copied, request.DstImage ? request.RowBytes : 1, stagingOffset);
+			if (chunk == 0)
+				break;
+
+			memcpy(static_cast<uint8_t*>(m_StagingAllocation.MappedData) + stagingOffset, request.Data + request.Copied, (size_t)chunk);
+
+			if (request.DstImage)
+				RecordImageCopy(batch.TransferCommandBuffer, request, stagingOffset, chunk);
+			else
+			{
+				VkBufferCopy region{};
+				region.srcOffset = stagingOffset;
+				region.dstOffset = request.DstOffset + request.Copied;
+				region.size = chunk;
+
+				vkCmdCopyBuffer(batch.TransferCommandBuffer, m_StagingBuffer, request.Dst, 1, &region);
+			}
+
+			request.Copied += chunk;
+			recorded = true;
+
+			if (request.Copied < request.Size)
+				continue;
+
+			batch.AcquireStages |= request.DstStage;
+			batch.LastTicket = request.Ticket;
+
+			if (request.DstImage)
+			{
+				VkImageMemoryBarrier barrier{};
+				barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+				barrier.image = request.DstImage;
+				barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+				barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+				barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, request.MipLevel, 1, 0, 1 };
+
+				if (UsesDedicatedQueue())
+				{
+					barrier.srcQueueFamilyIndex = m_TransferFamily;
+					barrier.dstQueueFamilyIndex = m_GraphicsFamily;
+
+					barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+					barrier.dstAccessMask = 0;
+					releaseImageBarriers.push_back(barrier);
+
+					barrier.srcAccessMask = 0;
+					barrier.dstAccessMask = request.DstAccess;
+					batch.AcquireImageBarriers.push_back(barrier);
+				}
+				else
+				{
+					barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+					barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+					barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+					barrier.dstAccessMask = request.DstAccess;
+					releaseImageBarriers.push_back(barrier);
+				}
+
+				m_Requests.pop_front();
+				continue;
+			}
+
+			// Queue ownership transfer, or a plain memory barrier when both queues are the same family
+			VkBufferMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			barrier.buffer = request.Dst;
+			barrier.offset = request.DstOffset;
+			barrier.size = request.Size;
+
+			if (UsesDedicatedQueue())
+			{
+				barrier.srcQueueFamilyIndex = m_TransferFamily;
+				barrier.dstQueueFamilyIndex = m_GraphicsFamily;
+
+				barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				barrier.dstAccessMask = 0;
+				releaseBarriers.push_back(barrier);
+
+				barrier.srcAccessMask = 0;
+				barrier.dstAccessMask = request.DstAccess;
+				batch.AcquireBarriers.push_back(barrier);
+			}
+			else
+			{
+				barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				barrier.dstAccessMask = request.DstAccess;
+				releaseBarriers.push_back(barrier);
+			}
+
+			m_Requests.pop_front();
+		}
+
+		if (!releaseBarriers.empty() || !releaseImageBarriers.empty())
+		{
+			VkPipelineStageFlags dstStage = UsesDedicatedQueue() ? static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT) : batch.AcquireStages;
+			vkCmdPipelineBarrier(batch.TransferCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage, 0, 0, nullptr,
+				static_cast<uint32_t>(releaseBarriers.size()), releaseBarriers.data(), static_cast<uint32_t>(releaseImageBarriers.size()), releaseImageBarriers.data());
+		}
+
+		if (vkEndCommandBuffer(batch.TransferCommandBuffer) != VK_SUCCESS)
+			std::cout << "Failed to record upload batch!" << std::endl;
+
+		if (!recorded)
+			return false;
+
+		batch.TransferValue = m_TransferTimeline.NextValue();
+		batch.AcquireValue = 0;
+
+		VkTimelineSemaphoreSubmitInfo timelineInfo{};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.signalSemaphoreValueCount = 1;
+		timelineInfo.pSignalSemaphoreValues = &batch.TransferValue;
+
+		VkSemaphore signalSemaphore = m_TransferTimeline.GetSemaphore();
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = &timelineInfo;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &batch.TransferCommandBuffer;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &signalSemaphore;
+
+		if (vkQueueSubmit(m_TransferTimeline.GetQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+			std::cout << "Failed to submit upload batch!" << std::endl;
+
+		batch.RingEnd = m_RingHead;
+		batch.State = BatchState::Transferring;
+		m_InFlightBatches.push_back(index);
+
+		return true;
+	}
+
+	void UploadManager::SubmitAcquire(UploadBatch& batch)
+	{
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		if (vkBeginCommandBuffer(batch.AcquireCommandBuffer, &beginInfo) != VK_SUCCESS)
+			std::cout << "Failed to begin recording upload acquire!" << std::endl;
+
+		vkCmdPipelineBarrier(batch.AcquireCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, batch.AcquireStages, 0, 0, nullptr,
+			static_cast<uint32_t>(batch.AcquireBarriers.size()), batch.AcquireBarriers.data(), static_cast<uint32_t>(batch.AcquireImageBarriers.size()), batch.AcquireImageBarriers.data());
+
+		if (vkEndCommandBuffer(batch.AcquireCommandBuffer) != VK_SUCCESS)
+			std::cout << "Failed to record upload acquire!" << std::endl;
+
+		// The wait is already satisfied, it only orders the release before the acquire
+		batch.AcquireValue = m_GraphicsTimeline.NextValue();
+
+		VkTimelineSemaphoreSubmitInfo timelineInfo{};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.waitSemaphoreValueCount = 1;
+		timelineInfo.pWaitSemaphoreValues = &batch.TransferValue;
+		timelineInfo.signalSemaphoreValueCount = 1;
+		timelineInfo.pSignalSemaphoreValues = &batch.AcquireValue;
+
+		VkSemaphore waitSemaphore = m_TransferTimeline.GetSemaphore();
+		VkSemaphore signalSemaphore = m_GraphicsTimeline.GetSemaphore();
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = &timelineInfo;
+		submitInfo.waitSemaphoreCount = 1;
+		submitInfo.pWaitSemaphores = &waitSemaphore;
+		submitInfo.pWaitDstStageMask = &batch.AcquireStages;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &batch.AcquireCommandBuffer;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &signalSemaphore;
+
+		if (vkQueueSubmit(m_GraphicsTimeline.GetQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+			std::cout << "Failed to submit upload acquire!" << std::endl;
+	}
+
+	void UploadManager::RecordImageCopy(VkCommandBuffer commandBuffer, const UploadRequest& request, VkDeviceSize stagingOffset, VkDeviceSize size)
+	{
+		// The level's old contents are discarded, nothing else writes it before the copy
+		if (request.Copied == 0)
+		{
+			VkImageMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.image = request.DstImage;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, request.MipLevel, 1, 0, 1 };
+
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+		}
+
+		uint32_t firstRow = static_cast<uint32_t>(request.Copied / request.RowBytes);
+		uint32_t rowCount = static_cast<uint32_t>((size + request.RowBytes - 1) / request.RowBytes);
+		uint32_t y = firstRow * request.RowHeight;
+
+		VkBufferImageCopy region{};
+		region.bufferOffset = stagingOffset;
+		region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, request.MipLevel, 0, 1 };
+		region.imageOffset = { 0, static_cast<int32_t>(y), 0 };
+		region.imageExtent = { request.Extent.width, std::min(rowCount * request.RowHeight, request.Extent.height - y), 1 };
+
+		vkCmdCopyBufferToImage(commandBuffer, m_StagingBuffer, request.DstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Staging Ring
+	//////////////////////////////////////////////////////////////////////////////////
+
+	VkDeviceSize UploadManager::GetImageChunkBytes(VkExtent2D extent, uint32_t blockHeight, VkDeviceSize size, uint32_t& rowHeight) const
+	{
+		// Copies start and end at multiples of the granularity's height, counted in block rows. The last
+		// piece may be shorter, it ends at the edge of the level
+		uint32_t rows = (extent.height + blockHeight - 1) / blockHeight;
+		uint32_t pieceRows = m_ImageGranularity.height == 0 ? rows : std::min(m_ImageGranularity.height, rows);
+
+		rowHeight = pieceRows * blockHeight;
+		return size / rows * pieceRows;
+	}
+
+	VkDeviceSize UploadManager::AcquireStaging(VkDeviceSize desired, VkDeviceSize granularity, VkDeviceSize& offset)
+	{
+		// The last piece of a level may be smaller than the others
+		granularity = std::min(granularity, desired);
+		VkDeviceSize minChunk = std::max(std::min(desired, UPLOAD_MIN_CHUNK), granularity);
+		VkDeviceSize head = (m_RingHead + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+
+		// In use is [tail, head), free space runs to the end of the ring
+		if (m_RingHead >= m_RingTail)
+		{
+			if (head < m_StagingSize && m_StagingSize - head >= minChunk)
+			{
+				offset = head;
+				VkDeviceSize granted = std::min(desired, m_StagingSize - head);
+				granted -= granted % granularity;
+				m_RingHead = head + granted;
+				return granted;
+			}
+
+			// Wrap around
+			head = 0;
+		}
+
+		// In use wraps around, free space is [head, tail). Head never catches up with
+		// the tail so an empty ring can't be mistaken for a full one
+		if (head < m_RingTail && m_RingTail - head > minChunk)
+		{
+			offset = head;
+			VkDeviceSize granted = std::min(desired, m_RingTail - head - 1);
+			granted -= granted % granularity;
+			m_RingHead = head + granted;
+			return granted;
+		}
+
+		return 0;
+	}
+
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <deque>
+#include <mutex>
+
+#include "MemoryAllocator.h"
+#include "QueueTimeline.h"
+
+#define INVALID_UPLOAD_TICKET UINT64_MAX
+
+namespace Vulkan {
+
+	using UploadTicket = uint64_t;
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Upload Manager
+	//////////////////////////////////////////////////////////////////////////////////
+
+	// Streams data into DEVICE_LOCAL buffers and images through a staging ring on the transfer queue.
+	// Finished copies are released to the graphics queue family, which acquires them
+	// once the transfer has completed, so the graphics queue never waits on an upload.
+	// Progress is tracked on the queues' timelines, which are the same object when
+	// both families match. Destinations must be EXCLUSIVE and either new or fully
+	// rewritten.
+	class UploadManager
+	{
+	public:
+		UploadManager(VkPhysicalDevice physicalDevice, VkDevice device, MemoryAllocator& allocator, QueueTimeline& transferTimeline, uint32_t transferFamily, QueueTimeline& graphicsTimeline, uint32_t graphicsFamily, VkDeviceSize stagingSize = 32ull * 1024 * 1024);
+		~UploadManager();
+
+		// data has to stay valid until the returned ticket is complete
+		UploadTicket UploadBuffer(VkBuffer dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+		// One mip level of a 2D color image, tightly packed rows of texel blocks blockHeight texels tall.
+		// The level goes from UNDEFINED to SHADER_READ_ONLY_OPTIMAL, large levels are split at block rows
+		// rounded to the transfer queue's image granularity. INVALID_UPLOAD_TICKET when a level that can't
+		// be split further is larger than the staging ring
+		UploadTicket UploadImage(VkImage dst, uint32_t mipLevel, VkExtent2D extent, uint32_t blockHeight, const void* data, VkDeviceSize size, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+
+		// Submits queued copies and hands finished ones over to the graphics queue, call once per frame
+		void Update();
+
+		bool IsComplete(UploadTicket ticket);
+		// Blocks on the timeline of the batch carrying the ticket, submitting queued copies as space frees up
+		void Wait(UploadTicket ticket);
+
+		bool UsesDedicatedQueue() const { return m_TransferFamily != m_GraphicsFamily; }
+		bool CanUploadImage(VkExtent2D extent, uint32_t blockHeight, VkDeviceSize size) const;
+
+	private:
+		enum class BatchState
+		{
+			Free,
+			Transferring,
+			Acquiring
+		};
+
+		struct UploadRequest
+		{
+			VkBuffer Dst;
+			VkDeviceSize DstOffset;
+
+			// Null for buffer uploads
+			VkImage DstImage;
+			uint32_t MipLevel;
+			VkExtent2D Extent;
+			uint32_t RowHeight;
+			VkDeviceSize RowBytes;
+
+			const uint8_t* Data;
+			VkDeviceSize Size;
+			VkDeviceSize Copied;
+
+			VkPipelineStageFlags DstStage;
+			VkAccessFlags DstAccess;
+
+			UploadTicket Ticket;
+		};
+
+		struct UploadBatch
+		{
+			VkCommandBuffer TransferCommandBuffer = VK_NULL_HANDLE;
+			VkCommandBuffer AcquireCommandBuffer = VK_NULL_HANDLE;
+
+			uint64_t TransferValue = 0;
+			uint64_t AcquireValue = 0;
+
+			BatchState State = BatchState::Free;
+			VkDeviceSize RingEnd = 0;
+			UploadTicket LastTicket = 0;
+
+			std::vector<VkBufferMemoryBarrier> AcquireBarriers;
+			std::vector<VkImageMemoryBarrier> AcquireImageBarriers;
+			VkPipelineStageFlags AcquireStages = 0;
+		};
+
+		void PollBatches();
+		void SubmitAcquire(UploadBatch& batch);
+		void RecordBatches();
+		// Returns false when nothing could be staged
+		bool RecordBatch(uint32_t index);
+		void RecordImageCopy(VkCommandBuffer commandBuffer, const UploadRequest& request, VkDeviceSize stagingOffset, VkDeviceSize size);
+
+		// Bytes of the smallest piece a level can be copied in, and its height in texels
+		VkDeviceSize GetImageChunkBytes(VkExtent2D extent, uint32_t blockHeight, VkDeviceSize size, uint32_t& rowHeight) const;
+
+		// Grants a multiple of granularity, or all of desired when it is less
+		VkDeviceSize AcquireStaging(VkDeviceSize desired, VkDeviceSize granularity, VkDeviceSize& offset);
+
+	private:
+		VkDevice m_Device;
+		MemoryAllocator& m_Allocator;
+
+		QueueTimeline& m_TransferTimeline;
+		QueueTimeline& m_GraphicsTimeline;
+		uint32_t m_TransferFamily;
+		uint32_t m_GraphicsFamily;
+		// In block rows, (0, 0, 0) only allows whole levels
+		VkExtent3D m_ImageGranularity;
+
+		VkCommandPool m_TransferCommandPool;
+		VkCommandPool m_GraphicsCommandPool;
+
+		// Staging Ring
+		VkBuffer m_StagingBuffer;
+		Allocation m_StagingAllocation;
+		VkDeviceSize m_StagingSize;
+		VkDeviceSize m_RingHead = 0;
+		VkDeviceSize m_RingTail = 0;
+
+		std::vector<UploadBatch> m_Batches;
+		std::deque<uint32_t> m_InFlightBatches;
+
+		std::mutex m_Mutex;
+		std::deque<UploadRequest> m_Requests;
+
+		UploadTicket m_NextTicket = 1;
+		UploadTicket m_CompletedTicket = 0;
+	};
+
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+
+// Declares an attribute from a vertex member, the format is derived from the member's type
+#define VERTEX_ATTRIBUTE(type, member, location) \
+	::Vulkan::VertexAttribute<location, ::Vulkan::VertexFormatOf<decltype(type::member)>::Value, offsetof(type, member), sizeof(type::member)>
+
+// Same with an explicit format, for packed members such as normalized or half float arrays
+#define VERTEX_ATTRIBUTE_FORMAT(type, member, location, format) \
+	::Vulkan::VertexAttribute<location, format, offsetof(type, member), sizeof(type::member)>
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Format Mapping
+	//////////////////////////////////////////////////////////////////////////////////
+
+	template<typename T>
+	struct VertexFormatOf
+	{
+		static_assert(sizeof(T) == 0, "No VkFormat for this type, use VERTEX_ATTRIBUTE_FORMAT");
+	};
+
+	template<> struct VertexFormatOf<float> { static constexpr VkFormat Value = VK_FORMAT_R32_SFLOAT; };
+	template<> struct VertexFormatOf<glm::vec2> { static constexpr VkFormat Value = VK_FORMAT_R32G32_SFLOAT; };
+	template<> struct VertexFormatOf<glm::vec3> { static constexpr VkFormat Value = VK_FORMAT_R32G32B32_SFLOAT; };
+	template<> struct VertexFormatOf<glm::vec4> { static constexpr VkFormat Value = VK_FORMAT_R32G32B32A32_SFLOAT; };
+
+	template<> struct VertexFormatOf<int32_t> { static constexpr VkFormat Value = VK_FORMAT_R32_SINT; };
+	template<> struct VertexFormatOf<glm::ivec2> { static constexpr VkFormat Value = VK_FORMAT_R32G32_SINT; };
+	template<> struct VertexFormatOf<glm::ivec3> { static constexpr VkFormat Value = VK_FORMAT_R32G32B32_SINT; };
+	template<> struct VertexFormatOf<glm::ivec4> { static constexpr VkFormat Value = VK_FORMAT_R32G32B32A32_SINT; };
+
+	template<> struct VertexFormatOf<uint32_t> { static constexpr VkFormat Value = VK_FORMAT_R32_UINT; };
+	template<> struct VertexFormatOf<glm::uvec2> { static constexpr VkFormat Value = VK_FORMAT_R32G32_UINT; };
+	template<> struct VertexFormatOf<glm::uvec3> { static constexpr VkFormat Value = VK_FORMAT_R32G32B32_UINT; };
+	template<> struct VertexFormatOf<glm::uvec4> { static constexpr VkFormat Value = VK_FORMAT_R32G32B32A32_UINT; };
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Vertex Layouts
+	//////////////////////////////////////////////////////////////////////////////////
+
+	template<uint32_t TLocation, VkFormat TFormat, size_t TOffset, size_t TSize>
+	struct VertexAttribute
+	{
+		static constexpr uint32_t Location = TLocation;
+		static constexpr VkFormat Format = TFormat;
+		static constexpr uint32_t Offset = static_cast<uint32_t>(TOffset);
+		static constexpr uint32_t Size = static_cast<uint32_t>(TSize);
+	};
+
+	// One binding of vertex type T, every description is built at compile time
+	template<typename T, uint32_t TBinding, VkVertexInputRate TInputRate, typename... Attributes>
+	struct VertexLayout
+	{
+		static_assert(sizeof...(Attributes) > 0, "A vertex layout needs at least one attribute");
+		static_assert(((Attributes::Offset + Attributes::Size <= sizeof(T)) && ...), "Attribute lies outside the vertex");
+
+		using VertexType = T;
+
+		static constexpr uint32_t Binding = TBinding;
+		static constexpr uint32_t Stride = static_cast<uint32_t>(sizeof(T));
+		static constexpr uint32_t AttributeCount = static_cast<uint32_t>(sizeof...(Attributes));
+
+		static constexpr VkVertexInputBindingDescription BindingDescription = { TBinding, Stride, TInputRate };
+
+		static constexpr std::array<VkVertexInputAttributeDescription, sizeof...(Attributes)> AttributeDescriptions = { {
+			{ Attributes::Location, TBinding, Attributes::Format, Attributes::Offset }...
+		} };
+	};
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Pipeline Vertex Input
+	//////////////////////////////////////////////////////////////////////////////////
+
+	namespace Detail {
+
+		template<size_t N>
+		constexpr void AppendAttributes(VkVertexInputAttributeDescription* out, size_t& count, const std::array<VkVertexInputAttributeDescription, N>& attributes)
+		{
+			for (size_t i = 0; i < N; i++)
+				out[count++] = attributes[i];
+		}
+
+		template<size_t N>
+		constexpr bool HasUniqueLocations(const std::array<VkVertexInputAttributeDescription, N>& attributes)
+		{
+			for (size_t i = 0; i < N; i++)
+			{
+				for (size_t j = i + 1; j < N; j++)
+				{
+					if (attributes[i].location == attributes[j].location)
+						return false;
+				}
+			}
+
+			return true;
+		}
+
+		template<size_t N>
+		constexpr bool HasUniqueBindings(const std::array<VkVertexInputBindingDescription, N>& bindings)
+		{
+			for (size_t i = 0; i < N; i++)
+			{
+				for (size_t j = i + 1; j < N; j++)
+				{
+					if (bindings[i].binding == bindings[j].binding)
+						return false;
+				}
+			}
+
+			return true;
+		}
+
+		template<typename... Layouts>
+		constexpr std::array<VkVertexInputAttributeDescription, (Layouts::AttributeCount + ...)> ConcatAttributes()
+		{
+			std::array<VkVertexInputAttributeDescription, (Layouts::AttributeCount + ...)> attributes{};
+			size_t count = 0;
+			(AppendAttributes(attributes.data(), count, Layouts::AttributeDescriptions), ...);
+			return attributes;
+		}
+
+	}
+
+	// Combines the layouts bound by a pipeline, GetCreateInfo only points at the static tables
+	template<typename... Layouts>
+	struct VertexInputState
+	{
+		static constexpr std::array<VkVertexInputBindingDescription, sizeof...(Layouts)> Bindings = { { Layouts::BindingDescription... } };
+		static constexpr auto Attributes = Detail::ConcatAttributes<Layouts...>();
+
+		static_assert(Detail::HasUniqueBindings(Bindings), "Two layouts share a binding");
+		static_assert(Detail::HasUniqueLocations(Attributes), "Two attributes share a location");
+
+		static VkPipelineVertexInputStateCreateInfo GetCreateInfo()
+		{
+			VkPipelineVertexInputStateCreateInfo createInfo{};
+			createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+			createInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(Bindings.size());
+			createInfo.pVertexBindingDescriptions = Bindings.data();
+			createInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(Attributes.size());
+			createInfo.pVertexAttributeDescriptions = Attributes.data();
+
+			return createInfo;
+		}
+	};
+
+}
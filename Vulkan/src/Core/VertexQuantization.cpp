@@ -0,0 +1,243 @@
+#include "VertexQuantization.h"
+
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#if VERTEX_QUANTIZATION_SSE2
+	#include <emmintrin.h>
+#endif
+
+namespace Vulkan {
+
+	const char* GetVertexEncodingName(VertexEncoding encoding)
+	{
+		switch (encoding)
+		{
+		case VertexEncoding::Float:	return "float";
+		case VertexEncoding::Half:	return "half";
+		case VertexEncoding::Snorm:	return "snorm";
+		}
+
+		return "unknown";
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Scalar Encoders
+	//////////////////////////////////////////////////////////////////////////////////
+
+	uint16_t FloatToHalf(float value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+
+		uint32_t sign = bits & 0x80000000u;
+		bits ^= sign;
+
+		uint16_t result;
+		if (bits >= (143u << 23))
+		{
+			// Too large for a half, or already infinity / NaN
+			result = bits > (255u << 23) ? 0x7e00 : 0x7c00;
+		}
+		else if (bits < (113u << 23))
+		{
+			// Denormal, adding the magic value makes the FPU round the mantissa into place
+			const uint32_t denormMagicBits = ((127 - 15) + (23 - 10) + 1) << 23;
+			float denormMagic, absValue;
+			std::memcpy(&denormMagic, &denormMagicBits, sizeof(denormMagic));
+			std::memcpy(&absValue, &bits, sizeof(absValue));
+
+			absValue += denormMagic;
+			std::memcpy(&bits, &absValue, sizeof(bits));
+			result = static_cast<uint16_t>(bits - denormMagicBits);
+		}
+		else
+		{
+			// Rebias the exponent and round the mantissa to nearest even
+			uint32_t mantissaOdd = (bits >> 13) & 1;
+			bits += ((15u - 127u) << 23) + 0xfff;
+			bits += mantissaOdd;
+			result = static_cast<uint16_t>(bits >> 13);
+		}
+
+		return result | static_cast<uint16_t>(sign >> 16);
+	}
+
+	static int16_t FloatToSnorm16(float value)
+	{
+		return static_cast<int16_t>(std::nearbyint(std::min(std::max(value, -1.0f), 1.0f) * 32767.0f));
+	}
+
+	static uint8_t FloatToUnorm8(float value)
+	{
+		return static_cast<uint8_t>(std::nearbyint(std::min(std::max(value, 0.0f), 1.0f) * 255.0f));
+	}
+
+	static int8_t FloatToSnorm8(float value)
+	{
+		return static_cast<int8_t>(std::nearbyint(std::min(std::max(value, -1.0f), 1.0f) * 127.0f));
+	}
+
+	static void EncodeOctahedral(const float* normal, int8_t* out)
+	{
+		float length = std::abs(normal[0]) + std::abs(normal[1]) + std::abs(normal[2]);
+		float x = length > 0.0f ? normal[0] / length : 0.0f;
+		float y = length > 0.0f ? normal[1] / length : 0.0f;
+
+		// The lower hemisphere is folded over the diagonals
+		if (normal[2] < 0.0f)
+		{
+			float foldedX = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+			float foldedY = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+			x = foldedX;
+			y = foldedY;
+		}
+
+		out[0] = FloatToSnorm8(x);
+		out[1] = FloatToSnorm8(y);
+	}
+
+	void QuantizeVerticesScalar(VertexEncoding encoding, const VertexStreams& streams, size_t count, QuantizedVertex* out)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			const float* position = reinterpret_cast<const float*>(reinterpret_cast<const char*>(streams.Positions) + i * streams.Stride);
+			const float* color = reinterpret_cast<const float*>(reinterpret_cast<const char*>(streams.Colors) + i * streams.Stride);
+			const float* normal = reinterpret_cast<const float*>(reinterpret_cast<const char*>(streams.Normals) + i * streams.Stride);
+
+			QuantizedVertex& vertex = out[i];
+
+			for (int c = 0; c < 3; c++)
+				vertex.Position[c] = encoding == VertexEncoding::Half ? FloatToHalf(position[c]) : static_cast<uint16_t>(FloatToSnorm16(position[c]));
+			vertex.Position[3] = 0;
+
+			for (int c = 0; c < 3; c++)
+				vertex.Color[c] = FloatToUnorm8(color[c]);
+			vertex.Color[3] = 255;
+
+			EncodeOctahedral(normal, vertex.Normal);
+			vertex.Padding = 0;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// SSE2 Encoders
+	//////////////////////////////////////////////////////////////////////////////////
+
+#if VERTEX_QUANTIZATION_SSE2
+
+	// Loads exactly three floats, so the last vertex never reads past its attribute
+	static inline __m128 Load3(const float* data)
+	{
+		__m128 xy = _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(data)));
+		return _mm_movelh_ps(xy, _mm_load_ss(data + 2));
+	}
+
+	static inline __m128i Select(__m128i mask, __m128i a, __m128i b)
+	{
+		return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+	}
+
+	// Same rounding as FloatToHalf, four lanes at a time. Results are in the low 16 bits of each lane
+	static inline __m128i FloatToHalf4(__m128 value)
+	{
+		const __m128i denormMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+
+		__m128i bits = _mm_castps_si128(value);
+		__m128i sign = _mm_and_si128(bits, _mm_set1_epi32(0x80000000));
+		__m128i absBits = _mm_xor_si128(bits, sign);
+
+		__m128i denormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(absBits), _mm_castsi128_ps(denormMagic))), denormMagic);
+
+		__m128i mantissaOdd = _mm_and_si128(_mm_srli_epi32(absBits, 13), _mm_set1_epi32(1));
+		__m128i normal = _mm_add_epi32(_mm_add_epi32(absBits, _mm_set1_epi32(static_cast<int>(((15u - 127u) << 23) + 0xfff))), mantissaOdd);
+		normal = _mm_srli_epi32(normal, 13);
+
+		__m128i isNan = _mm_cmpgt_epi32(absBits, _mm_set1_epi32(255 << 23));
+		__m128i infOrNan = _mm_or_si128(_mm_set1_epi32(0x7c00), _mm_and_si128(isNan, _mm_set1_epi32(0x200)));
+
+		__m128i isDenormal = _mm_cmplt_epi32(absBits, _mm_set1_epi32(113 << 23));
+		__m128i isOverflow = _mm_cmpgt_epi32(absBits, _mm_set1_epi32((143 << 23) - 1));
+
+		__m128i result = Select(isDenormal, denormal, normal);
+		result = Select(isOverflow, infOrNan, result);
+
+		return _mm_or_si128(result, _mm_srli_epi32(sign, 16));
+	}
+
+	// Packs the low 16 bits of each lane without saturating
+	static inline __m128i Pack16(__m128i value)
+	{
+		value = _mm_srai_epi32(_mm_slli_epi32(value, 16), 16);
+		return _mm_packs_epi32(value, value);
+	}
+
+	static inline __m128 Clamp(__m128 value, float minValue, float maxValue)
+	{
+		return _mm_min_ps(_mm_max_ps(value, _mm_set1_ps(minValue)), _mm_set1_ps(maxValue));
+	}
+
+	void QuantizeVertices(VertexEncoding encoding, const VertexStreams& streams, size_t count, QuantizedVertex* out)
+	{
+		const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+		const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+		// Opaque alpha for the color, w stays 0 for the position
+		const __m128 alpha = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			const float* position = reinterpret_cast<const float*>(reinterpret_cast<const char*>(streams.Positions) + i * streams.Stride);
+			const float* color = reinterpret_cast<const float*>(reinterpret_cast<const char*>(streams.Colors) + i * streams.Stride);
+			const float* normal = reinterpret_cast<const float*>(reinterpret_cast<const char*>(streams.Normals) + i * streams.Stride);
+
+			QuantizedVertex& vertex = out[i];
+
+			// Position
+			__m128 p = Load3(position);
+			__m128i packedPosition;
+			if (encoding == VertexEncoding::Half)
+				packedPosition = Pack16(FloatToHalf4(p));
+			else
+				packedPosition = _mm_packs_epi32(_mm_cvtps_epi32(_mm_mul_ps(Clamp(p, -1.0f, 1.0f), _mm_set1_ps(32767.0f))), _mm_setzero_si128());
+
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(vertex.Position), packedPosition);
+
+			// Color
+			__m128 c = _mm_or_ps(Load3(color), alpha);
+			__m128i colorWords = _mm_packs_epi32(_mm_cvtps_epi32(_mm_mul_ps(Clamp(c, 0.0f, 1.0f), _mm_set1_ps(255.0f))), _mm_setzero_si128());
+			int32_t packedColor = _mm_cvtsi128_si32(_mm_packus_epi16(colorWords, colorWords));
+			std::memcpy(vertex.Color, &packedColor, sizeof(packedColor));
+
+			// Normal, projected onto the octahedron and folded when facing down
+			__m128 n = Load3(normal);
+			__m128 absN = _mm_and_ps(n, absMask);
+			__m128 length = _mm_add_ps(absN, _mm_shuffle_ps(absN, absN, _MM_SHUFFLE(2, 3, 0, 1)));
+			length = _mm_add_ps(length, _mm_shuffle_ps(length, length, _MM_SHUFFLE(1, 0, 3, 2)));
+
+			__m128 o = _mm_div_ps(n, _mm_max_ps(length, _mm_set1_ps(1e-20f)));
+			__m128 swapped = _mm_and_ps(_mm_shuffle_ps(o, o, _MM_SHUFFLE(3, 2, 0, 1)), absMask);
+			__m128 folded = _mm_or_ps(_mm_sub_ps(_mm_set1_ps(1.0f), swapped), _mm_and_ps(o, signMask));
+
+			__m128 facingDown = _mm_cmplt_ps(_mm_shuffle_ps(n, n, _MM_SHUFFLE(2, 2, 2, 2)), _mm_setzero_ps());
+			o = _mm_or_ps(_mm_and_ps(facingDown, folded), _mm_andnot_ps(facingDown, o));
+
+			__m128i normalWords = _mm_packs_epi32(_mm_cvtps_epi32(_mm_mul_ps(Clamp(o, -1.0f, 1.0f), _mm_set1_ps(127.0f))), _mm_setzero_si128());
+			int32_t packedNormal = _mm_cvtsi128_si32(_mm_packs_epi16(normalWords, normalWords));
+
+			vertex.Normal[0] = static_cast<int8_t>(packedNormal & 0xff);
+			vertex.Normal[1] = static_cast<int8_t>((packedNormal >> 8) & 0xff);
+			vertex.Padding = 0;
+		}
+	}
+
+#else
+
+	void QuantizeVertices(VertexEncoding encoding, const VertexStreams& streams, size_t count, QuantizedVertex* out)
+	{
+		QuantizeVerticesScalar(encoding, streams, count, out);
+	}
+
+#endif
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define VERTEX_QUANTIZATION_SSE2 1
+#else
+	#define VERTEX_QUANTIZATION_SSE2 0
+#endif
+
+namespace Vulkan {
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Vertex Quantization
+	//////////////////////////////////////////////////////////////////////////////////
+
+	enum class VertexEncoding
+	{
+		// 32-bit floats for every attribute
+		Float = 0,
+		// Half float positions
+		Half,
+		// SNORM16 positions, the mesh has to fit into [-1, 1]
+		Snorm
+	};
+
+	const char* GetVertexEncodingName(VertexEncoding encoding);
+
+	// Layout shared by the quantized encodings, colors are UNORM8 and normals octahedral SNORM8
+	struct QuantizedVertex
+	{
+		// Half floats or SNORM16, w is 0
+		uint16_t Position[4];
+		uint8_t Color[4];
+		int8_t Normal[2];
+		uint16_t Padding;
+	};
+
+	static_assert(sizeof(QuantizedVertex) == 16, "QuantizedVertex has to stay 16 bytes");
+
+	// Interleaved float source, three floats per attribute
+	struct VertexStreams
+	{
+		const float* Positions;
+		const float* Colors;
+		const float* Normals;
+		size_t Stride;
+	};
+
+	// SSE2 when the target has it, falls back to QuantizeVerticesScalar otherwise
+	void QuantizeVertices(VertexEncoding encoding, const VertexStreams& streams, size_t count, QuantizedVertex* out);
+	void QuantizeVerticesScalar(VertexEncoding encoding, const VertexStreams& streams, size_t count, QuantizedVertex* out);
+
+	// Round to nearest even, overflow becomes infinity
+	uint16_t FloatToHalf(float value);
+
+}
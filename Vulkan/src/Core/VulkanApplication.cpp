@@ -6,6 +6,11 @@
 #include <set>
 #include <algorithm>
 #include <fstream>
+#include <cstring>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <filesystem>
 
 #include "glm/glm.hpp"
 
@@ -42,10 +47,200 @@ namespace Vulkan {
 	//////////////////////////////////////////////////////////////////////////////////
 
 	VulkanApplication::VulkanApplication(const WindowProps& props)
-		: m_Properties(props)
+		: m_Properties(props), m_FramesInFlight(std::min(std::max(props.FramesInFlight, 1u), (uint32_t)MAX_FRAMES_IN_FLIGHT)),
+		m_FramePacer(props.TargetFrameRate), m_InstanceCount(std::max(props.InstanceCount, 1u))
 	{
-		CreateApplicationWindow();
+		m_StartupGraph = std::make_unique<StartupGraph>();
 
+		if (m_Properties.Headless)
+			m_DeviceExtensions.clear();
+
+		// Initialization runs as a graph on the recording threads, only the instance and device
+		// chain is strictly sequential. Asset I/O, uploads and pipeline compiles overlap it
+		m_ThreadPool = std::make_unique<ThreadPool>(m_Properties.RecordingThreads);
+		StartupGraph& graph = *m_StartupGraph;
+
+		// GLFW has to be initialized and create its window on the main thread
+		StartupTask window = graph.AddTask("Window", {}, [this]()
+			{
+				if (!m_Properties.Headless)
+					CreateApplicationWindow();
+			}, true);
+
+		StartupTask instance = graph.AddTask("Instance", { window }, [this]() { CreateInstance(); });
+
+		StartupTask device = graph.AddTask("Device", { instance }, [this]()
+			{
+				// Physical Devices
+				PickPhysicalDevice();
+
+				// The depth benchmark reports fragment shader invocations
+				if (m_Properties.Benchmark == "depth")
+					m_Properties.PipelineStatistics = true;
+
+				// Logical Device
+				CreateLogicalDevice();
+
+				// Device Memory
+				m_Allocator = std::make_unique<MemoryAllocator>(m_PhysicalDevice, m_Device);
+
+				// Queue Timelines
+				const QueueFamilyIndicies& indices = m_QueueFamilies;
+
+				m_GraphicsTimeline = std::make_unique<QueueTimeline>(m_Device, m_GraphicsQueue);
+				if (indices.TransferFamily != indices.GraphicsFamily)
+					m_TransferTimeline = std::make_unique<QueueTimeline>(m_Device, m_TransferQueue);
+
+				// Uploads
+				QueueTimeline& transferTimeline = m_TransferTimeline ? *m_TransferTimeline : *m_GraphicsTimeline;
+				m_UploadManager = std::make_unique<UploadManager>(m_PhysicalDevice, m_Device, *m_Allocator, transferTimeline, indices.TransferFamily.value(), *m_GraphicsTimeline, indices.GraphicsFamily.value());
+
+				// Bindless Resources, set 0 of the scene pipeline
+				m_Bindless = std::make_unique<BindlessHeap>(m_PhysicalDevice, m_Device, *m_GraphicsTimeline);
+
+				// Uniform Ring, set 1 of the scene pipeline
+				m_UniformRing = std::make_unique<UniformRing>(m_PhysicalDevice, m_Device, *m_Allocator, m_FramesInFlight);
+			});
+
+		// Asset Pack
+		StartupTask assets = graph.AddTask("Asset pack", {}, [this]()
+			{
+				if (m_Properties.AssetPackPath.empty())
+					return;
+
+				m_AssetPack = std::make_unique<AssetPack>(m_Properties.AssetPackPath);
+				if (m_AssetPack->IsOpen())
+					std::cout << "Asset pack " << m_Properties.AssetPackPath << ": " << m_AssetPack->GetAssetCount() << " assets, " << m_AssetPack->GetSize() / 1024 << " KiB mapped" << std::endl;
+				else
+					m_AssetPack.reset();
+			});
+
+		// Mesh, parsed and optimized while the device is created
+		StartupTask mesh = graph.AddTask("Mesh", { assets }, [this]()
+			{
+				LoadMesh();
+
+				for (uint32_t i = 0; i < m_Mesh.VertexCount; i++)
+					m_MeshRadius = std::max(m_MeshRadius, glm::length(m_Mesh.Vertices[i].Position));
+			});
+
+		StartupTask pipelines = graph.AddTask("Pipeline cache", { device, assets }, [this]()
+			{
+				// Pipeline Cache
+				m_PipelineCache = std::make_unique<PipelineCache>(m_PhysicalDevice, m_Device, m_Properties.PipelineCachePath);
+
+				// Hot reload watches the loose shaders, so packed ones would shadow every edit
+				m_PipelineCompiler = std::make_unique<PipelineCompiler>(m_Device, m_PipelineCache->GetHandle(), m_Properties.HotReload ? nullptr : m_AssetPack.get());
+
+				// Profiler
+				if (!m_Properties.ProfileOutput.empty())
+					m_Profiler = std::make_unique<Profiler>(m_PhysicalDevice, m_Device, m_QueueFamilies.GraphicsFamily.value(), m_FramesInFlight, m_Properties.PipelineStatistics);
+			});
+
+		// The swapchain extent comes from glfwGetFramebufferSize, which is main thread only as well
+		StartupTask swapchain = graph.AddTask("Swapchain", { device }, [this]()
+			{
+				// Swapchain
+				if (m_Properties.Headless)
+					CreateOffscreenTargets();
+				else
+					CreateSwapchain();
+
+				// Image Views
+				CreateImageViews();
+			}, true);
+
+		StartupTask renderTargets = graph.AddTask("Render targets", { swapchain, pipelines }, [this]()
+			{
+				// Render Targets
+				m_RenderGraph = std::make_unique<RenderGraph>(m_Device, *m_Allocator);
+				m_DepthFormat = FindDepthFormat();
+				m_SampleCount = ChooseSampleCount(m_Properties.MsaaSamples);
+				if (m_SampleCount != m_Properties.MsaaSamples)
+					std::cout << m_Properties.MsaaSamples << "x MSAA is not supported, using " << m_SampleCount << "x" << std::endl;
+				CreateRenderTargets();
+
+				// Render pass
+				CreateRenderPass();
+
+				// Pipeline, compiled on the pipeline compiler while the scene loads. Frames skip their
+				// draws until it is collected
+				SubmitScenePipeline();
+
+				// Framebuffers
+				CreateFrambuffer();
+			});
+
+		graph.AddTask("Frame resources", { device }, [this]()
+			{
+				// Command Pools
+				CreateFrameResources();
+
+				// Semaphores and Fences
+				CreateSyncObjects();
+			});
+
+		StartupTask geometry = graph.AddTask("Geometry", { device, mesh }, [this]()
+			{
+				// Vertex Buffer
+				UploadTicket vertexTicket = CreateVertexBuffer();
+				UploadTicket indexTicket = CreateIndexBuffer();
+				m_GeometryTicket = std::max(vertexTicket, indexTicket);
+			});
+
+		StartupTask textures = graph.AddTask("Textures", { device, assets }, [this]()
+			{
+				// Textures, only the mip tail is uploaded here and the rest streams in once the scene is drawn
+				VkDeviceSize textureBudget = VkDeviceSize(m_Properties.TextureBudgetMB) * 1024 * 1024;
+				if (textureBudget == 0)
+					textureBudget = m_DeviceProfile.DeviceLocalBytes / 2;
+
+				m_TextureStreamer = std::make_unique<TextureStreamer>(m_PhysicalDevice, m_Device, *m_Allocator, *m_UploadManager, *m_GraphicsTimeline, *m_Bindless, textureBudget);
+
+				// Materials
+				TextureHandle sceneTexture = m_TextureStreamer->GetDefaultTexture();
+				if (!m_Properties.TexturePath.empty())
+				{
+					TextureHandle texture = m_TextureStreamer->Load(m_AssetPack.get(), m_Properties.TexturePath);
+					if (texture != INVALID_TEXTURE_HANDLE)
+						sceneTexture = texture;
+				}
+
+				m_Materials.push_back({ glm::vec4(1.0f), sceneTexture });
+			});
+
+		StartupTask culler = graph.AddTask("GPU culler", { pipelines }, [this]() { CreateGpuCuller(); });
+
+		// The render graph is declared with m_GpuDriven, so the scene is only set up after it
+		graph.AddTask("Scene", { renderTargets, geometry, textures, culler }, [this]()
+			{
+				m_View = glm::vec4(0.0f, 0.0f, m_Properties.Zoom > 0.0f ? m_Properties.Zoom : 1.0f, 0.0f);
+
+				if (m_Properties.GpuCulling && !m_GpuCuller)
+					std::cout << "GPU culling needs drawIndirectCount and drawIndirectFirstInstance, drawing from the CPU instead" << std::endl;
+				m_GpuDriven = m_Properties.GpuCulling && m_GpuCuller;
+
+				for (uint32_t i = 0; i < m_Properties.DrawCount; i++)
+					m_DrawCommands.push_back({ m_VertexBuffer, m_Mesh.IndexCount, 0, 0, m_InstanceCount, 0 });
+			});
+
+		graph.AddTask("Shader watcher", {}, [this]()
+			{
+				if (!m_Properties.HotReload)
+					return;
+
+				m_ShaderWatcher = std::make_unique<ShaderWatcher>(SHADER_DIRECTORY, [this](const std::vector<std::string>& files) { OnShadersChanged(files); });
+				if (m_ShaderWatcher->IsWatching())
+					std::cout << "Watching " << SHADER_DIRECTORY << " for shader changes" << std::endl;
+			});
+
+		graph.Run(*m_ThreadPool);
+
+		UpdatePipelines();
+	}
+
+	void VulkanApplication::CreateInstance()
+	{
 		// Validation
 		if (ENABLE_VALIDATION_LAYERS && !CheckValidationLayerSupport())
 			std::cout << "Validation layers are requested, but they're not available!" << std::endl;
@@ -90,69 +285,61 @@ namespace Vulkan {
 		SetupDebugMessenger();
 
 		// Vulkan Context
-		if (glfwCreateWindowSurface(m_Instance, m_Window, nullptr, &m_Surface) != VK_SUCCESS)
+		if (!m_Properties.Headless && glfwCreateWindowSurface(m_Instance, m_Window, nullptr, &m_Surface) != VK_SUCCESS)
 			std::cout << "Failed to create window surface!" << std::endl;
-
-		// Physical Devices
-		PickPhysicalDevice();
-
-		// Logical Device
-		CreateLogicalDevice();
-
-		// Swapchain
-		CreateSwapchain();
-
-		// Image Views
-		CreateImageViews();
-
-		// Render pass
-		CreateRenderPass();
-
-		// Pipeline
-		CreateGraphicsPipeline();
-
-		// Framebuffers
-		CreateFrambuffer();
-
-		// Command Pools
-		CreateCommandPool();
-
-		// Vertex Buffer
-		CreateVertexBuffer();
-		
-		// Command Buffers
-		CreateCommandBuffers();
-
-		// Semaphores and Fences
-		CreateSyncObjects();
 	}
 
 	VulkanApplication::~VulkanApplication()
 	{
+		// No compile may be in flight while the render pass goes away
+		m_ShaderWatcher.reset();
+		m_PipelineCompiler.reset();
+
 		CleanupSwapchain();
+		CleanupPipeline();
+
+		if (m_Properties.Headless)
+			CleanupOffscreenTargets();
+		else
+			vkDestroySwapchainKHR(m_Device, m_Swapchain, nullptr);
 
-		vkDestroyBuffer(m_Device, m_VertexBuffer, nullptr);
-		vkFreeMemory(m_Device, m_VertexBufferMemory, nullptr);
+		m_Allocator->DestroyBuffer(m_VertexBuffer, m_VertexBufferAllocation);
+		m_Allocator->DestroyBuffer(m_IndexBuffer, m_IndexBufferAllocation);
 
-		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		for (uint32_t i = 0; i < m_FramesInFlight; i++)
 		{
 			vkDestroySemaphore(m_Device, m_RenderFinishedSemaphore[i], nullptr);
 			vkDestroySemaphore(m_Device, m_ImageAvailableSemaphore[i], nullptr);
-			vkDestroyFence(m_Device, m_InFlightFences[i], nullptr);
 		}
 
-		vkDestroyCommandPool(m_Device, m_CommandPool, nullptr);
+		CleanupFrameResources();
+
+		m_GpuCuller.reset();
+		m_RenderGraph.reset();
+		m_TextureStreamer.reset();
+		m_UniformRing.reset();
+		m_Bindless.reset();
+		m_Profiler.reset();
+		m_PipelineCache.reset();
+		m_UploadManager.reset();
+		m_TransferTimeline.reset();
+		m_GraphicsTimeline.reset();
+		m_Allocator.reset();
 
 		vkDestroyDevice(m_Device, nullptr);
 
 		if (ENABLE_VALIDATION_LAYERS)
 			DestroyDebugUtilsMessengerEXT(m_Instance, m_DebugMessenger, nullptr);
 
-		vkDestroySurfaceKHR(m_Instance, m_Surface, nullptr);
+		if (m_Surface != VK_NULL_HANDLE)
+			vkDestroySurfaceKHR(m_Instance, m_Surface, nullptr);
 		vkDestroyInstance(m_Instance, nullptr);
 
-		glfwDestroyWindow(m_Window);
-		glfwTerminate();
+		if (m_Window)
+		{
+			glfwDestroyWindow(m_Window);
+			glfwTerminate();
+		}
 	}
 
 	void VulkanApplication::CreateApplicationWindow()
@@ -205,10 +392,15 @@ namespace Vulkan {
 
 	std::vector<const char*> VulkanApplication::GetRequiredExtensions()
 	{
-		uint32_t glfwGetExtensionCount = 0;
-		const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwGetExtensionCount);
+		std::vector<const char*> extensions;
 
-		std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwGetExtensionCount);
+		// Headless rendering doesn't need any surface extensions
+		if (!m_Properties.Headless)
+		{
+			uint32_t glfwGetExtensionCount = 0;
+			const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwGetExtensionCount);
+			extensions.assign(glfwExtensions, glfwExtensions + glfwGetExtensionCount);
+		}
 
 		if (ENABLE_VALIDATION_LAYERS)
 			extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -248,91 +440,22 @@ namespace Vulkan {
 
 	void VulkanApplication::PickPhysicalDevice()
 	{
-		uint32_t deviceCount = 0;
-		vkEnumeratePhysicalDevices(m_Instance, &deviceCount, nullptr);
-
-		if (deviceCount == 0)
-			std::cout << "Failed to find GPUs with Vulkan support!" << std::endl;
-
-		std::vector<VkPhysicalDevice> devices(deviceCount);
-		vkEnumeratePhysicalDevices(m_Instance, &deviceCount, devices.data());
+		DeviceSelector selector(m_Instance, m_DeviceExtensions, m_Properties.DeviceCachePath);
 
-		// Use an ordered map to automatically sort candidates by increasing score
-		std::multimap<int, VkPhysicalDevice> candidates;
+		uint32_t presentFamily = INVALID_QUEUE_FAMILY;
+		m_PhysicalDevice = selector.Select(m_Properties.Headless ? VK_NULL_HANDLE : m_Surface, m_DeviceProfile, presentFamily);
 
-		for (const auto& device : devices)
+		if (m_PhysicalDevice == VK_NULL_HANDLE)
 		{
-			int score = RateDeviceSuitability(device);
-
-			if (CheckDeviceExtensionSupport(device))
-				candidates.insert(std::make_pair(score, device));
-			else
-				std::cout << "Extensions not supported on this device!" << std::endl;
-		}
-
-		// Check if the best candidate is suitable at all
-		if (candidates.rbegin()->first > 0)
-			m_PhysicalDevice = candidates.rbegin()->second;
-		else
 			std::cout << "Failed to find a suitable GPU!" << std::endl;
-	}
-
-	int VulkanApplication::RateDeviceSuitability(VkPhysicalDevice device)
-	{
-		VkPhysicalDeviceProperties deviceProperties;
-		vkGetPhysicalDeviceProperties(device, &deviceProperties);
-
-		VkPhysicalDeviceFeatures deviceFeatures;
-		vkGetPhysicalDeviceFeatures(device, &deviceFeatures);
-		
-		int score = 0;
-
-		// Discrete GPUs have a significant performance advantage
-		if (deviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
-			score += 1000;
-
-		// Maximum possible size of textures affects graphics quality
-		score += deviceProperties.limits.maxImageDimension2D;
-
-		// Application can't function without geometry shaders
-		if (!deviceFeatures.geometryShader)
-			return 0;
-
-		return score;
-	}
-
-	//////////////////////////////////////////////////////////////////////////////////
-	// Queue Families
-	//////////////////////////////////////////////////////////////////////////////////
-
-	QueueFamilyIndicies VulkanApplication::FindQueueFamilies(VkPhysicalDevice device)
-	{
-		QueueFamilyIndicies indicies;
-
-		uint32_t queueFamilyCount = 0;
-		vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
-		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
-		vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
-
-		int i = 0;
-		for (const auto& queueFamily : queueFamilies)
-		{
-			if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
-				indicies.GraphicsFamily = i;
-
-			VkBool32 presentSupport = false;
-			vkGetPhysicalDeviceSurfaceSupportKHR(m_PhysicalDevice, i, m_Surface, &presentSupport);
-
-			if (presentSupport)
-				indicies.PresentFamily = i;
-
-			if (indicies.IsComplete())
-				break;
-
-			i++;
+			return;
 		}
 
-		return indicies;
+		m_QueueFamilies.GraphicsFamily = m_DeviceProfile.GraphicsFamily;
+		m_QueueFamilies.PresentFamily = presentFamily;
+
+		// Without a copy engine uploads go through the graphics queue
+		m_QueueFamilies.TransferFamily = m_DeviceProfile.TransferFamily != INVALID_QUEUE_FAMILY ? m_DeviceProfile.TransferFamily : m_DeviceProfile.GraphicsFamily;
 	}
 
 	//////////////////////////////////////////////////////////////////////////////////
@@ -341,23 +464,38 @@ namespace Vulkan {
 
 	void VulkanApplication::CreateLogicalDevice()
 	{
-		QueueFamilyIndicies indices = FindQueueFamilies(m_PhysicalDevice);
+		const QueueFamilyIndicies& indices = m_QueueFamilies;
 
 		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-		std::set<uint32_t> uniqueQueueFamilies = { indices.GraphicsFamily.value(), indices.PresentFamily.value() };
+		std::set<uint32_t> uniqueQueueFamilies = { indices.GraphicsFamily.value(), indices.PresentFamily.value(), indices.TransferFamily.value() };
 
 		float queuePriority = 1.0f;
-		for (uint32_t qqueueFamily : uniqueQueueFamilies)
+		for (uint32_t queueFamily : uniqueQueueFamilies)
 		{
 			VkDeviceQueueCreateInfo queueCreateInfo{};
 			queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-			queueCreateInfo.queueFamilyIndex = indices.GraphicsFamily.value();
+			queueCreateInfo.queueFamilyIndex = queueFamily;
 			queueCreateInfo.queueCount = 1;
 			queueCreateInfo.pQueuePriorities = &queuePriority;
 			queueCreateInfos.push_back(queueCreateInfo);
 		}
 
 		VkPhysicalDeviceFeatures deviceFeatures{};
+
+		// The render pass contents are secondary command buffers, so statistics also need inherited queries
+		if (m_Properties.PipelineStatistics)
+		{
+			if (m_DeviceProfile.PipelineStatistics)
+			{
+				deviceFeatures.pipelineStatisticsQuery = VK_TRUE;
+				deviceFeatures.inheritedQueries = VK_TRUE;
+			}
+			else
+			{
+				std::cout << "Pipeline statistics queries are not supported on this device" << std::endl;
+				m_Properties.PipelineStatistics = false;
+			}
+		}
 		
 		VkDeviceCreateInfo createInfo{};
 		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -366,6 +504,25 @@ namespace Vulkan {
 
 		createInfo.pEnabledFeatures = &deviceFeatures;
 
+		// The culler writes each object's index as its draw's firstInstance
+		m_DrawIndirectCount = m_DeviceProfile.DrawIndirectCount && m_DeviceProfile.DrawIndirectFirstInstance;
+		deviceFeatures.drawIndirectFirstInstance = m_DrawIndirectCount;
+
+		// BC blocks are sampled as is, textures in other formats load without it
+		deviceFeatures.textureCompressionBC = m_DeviceProfile.TextureCompressionBC;
+
+		VkPhysicalDeviceVulkan12Features features12{};
+		features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		features12.timelineSemaphore = VK_TRUE;
+		features12.drawIndirectCount = m_DrawIndirectCount;
+		features12.runtimeDescriptorArray = VK_TRUE;
+		features12.descriptorBindingPartiallyBound = VK_TRUE;
+		features12.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+		features12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		features12.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+		features12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+		createInfo.pNext = &features12;
+
 		createInfo.enabledExtensionCount = static_cast<uint32_t>(m_DeviceExtensions.size());
 		createInfo.ppEnabledExtensionNames = m_DeviceExtensions.data();
 
@@ -384,25 +541,7 @@ namespace Vulkan {
 
 		vkGetDeviceQueue(m_Device, indices.GraphicsFamily.value(), 0, &m_GraphicsQueue);
 		vkGetDeviceQueue(m_Device, indices.PresentFamily.value(), 0, &m_PresentQueue);
-	}
-
-	//////////////////////////////////////////////////////////////////////////////////
-	// Extensions
-	//////////////////////////////////////////////////////////////////////////////////
-
-	bool VulkanApplication::CheckDeviceExtensionSupport(VkPhysicalDevice device)
-	{
-		uint32_t extensionCount;
-
-		vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
-		std::vector<VkExtensionProperties> availableExtensions(extensionCount);
-		vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
-
-		std::set<std::string> requiredExtensions(m_DeviceExtensions.begin(), m_DeviceExtensions.end());
-		for (const auto& extension : availableExtensions)
-			requiredExtensions.erase(extension.extensionName);
-
-		return requiredExtensions.empty();
+		vkGetDeviceQueue(m_Device, indices.TransferFamily.value(), 0, &m_TransferQueue);
 	}
 
 	//////////////////////////////////////////////////////////////////////////////////
@@ -450,13 +589,7 @@ namespace Vulkan {
 
 	VkPresentModeKHR VulkanApplication::ChooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes)
 	{
-		for (const auto& availablePresentMode : availablePresentModes)
-		{
-			if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
-				return availablePresentMode;
-		}
-
-		return VK_PRESENT_MODE_FIFO_KHR;
+		return ChoosePresentMode(m_Properties.PresentPolicy, availablePresentModes);
 	}
 
 	VkExtent2D VulkanApplication::ChooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities)
@@ -488,7 +621,11 @@ namespace Vulkan {
 		VkPresentModeKHR presentMode = ChooseSwapPresentMode(swapchainSupport.PresentModes);
 		VkExtent2D extent = ChooseSwapExtent(swapchainSupport.Capabilities);
 
-		uint32_t imageCount = swapchainSupport.Capabilities.minImageCount + 1;
+		// The extra image keeps MAILBOX and IMMEDIATE from waiting on the presentation engine,
+		// under FIFO it would only queue another frame of latency
+		uint32_t imageCount = swapchainSupport.Capabilities.minImageCount;
+		if (presentMode != VK_PRESENT_MODE_FIFO_KHR && presentMode != VK_PRESENT_MODE_FIFO_RELAXED_KHR)
+			imageCount++;
 		if (swapchainSupport.Capabilities.maxImageCount > 0 && imageCount > swapchainSupport.Capabilities.maxImageCount)
 			imageCount = swapchainSupport.Capabilities.maxImageCount;
 
@@ -503,7 +640,7 @@ namespace Vulkan {
 		createInfo.imageArrayLayers = 1;
 		createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
 
-		QueueFamilyIndicies indices = FindQueueFamilies(m_PhysicalDevice);
+		const QueueFamilyIndicies& indices = m_QueueFamilies;
 		uint32_t queueFamilyIndices[] = { indices.GraphicsFamily.value(), indices.PresentFamily.value() };
 
 		if (indices.GraphicsFamily != indices.PresentFamily)
@@ -523,11 +660,16 @@ namespace Vulkan {
 		createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
 		createInfo.presentMode = presentMode;
 		createInfo.clipped = VK_TRUE;
-		createInfo.oldSwapchain = VK_NULL_HANDLE;
+		// Handing over the old swapchain lets the presentation engine reuse its resources
+		VkSwapchainKHR oldSwapchain = m_Swapchain;
+		createInfo.oldSwapchain = oldSwapchain;
 
 		if (vkCreateSwapchainKHR(m_Device, &createInfo, nullptr, &m_Swapchain) != VK_SUCCESS)
 			std::cout << "Failed to create swapchain!" << std::endl;
 
+		if (oldSwapchain != VK_NULL_HANDLE)
+			vkDestroySwapchainKHR(m_Device, oldSwapchain, nullptr);
+
 		// Retrieving Swapchain Images
 		vkGetSwapchainImagesKHR(m_Device, m_Swapchain, &imageCount, nullptr);
 		m_SwapchainImages.resize(imageCount);
@@ -547,16 +689,29 @@ namespace Vulkan {
 			glfwWaitEvents();
 		}
 		
-		vkDeviceWaitIdle(m_Device);
+		// Only the frames in flight still reference the old framebuffers
+		m_GraphicsTimeline->WaitIdle();
 
 		CleanupSwapchain();
 
+		VkFormat previousFormat = m_SwapchainImageFormat;
+
 		CreateSwapchain();
 		CreateImageViews();
-		CreateRenderPass();
-		CreateGraphicsPipeline();
+		CreateRenderTargets();
+
+		// Viewport and scissor are dynamic, so the pipeline only depends on the surface format
+		if (m_SwapchainImageFormat != previousFormat)
+		{
+			CancelScenePipelines();
+			m_PipelineCompiler->WaitIdle();
+
+			CleanupPipeline();
+			CreateRenderPass();
+			SubmitScenePipeline();
+		}
+
 		CreateFrambuffer();
-		CreateCommandBuffers();
 	}
 
 	void VulkanApplication::CleanupSwapchain()
@@ -564,16 +719,22 @@ namespace Vulkan {
 		for (auto framebuffer : m_SwapchainFramebuffers)
 			vkDestroyFramebuffer(m_Device, framebuffer, nullptr);
 
-		vkFreeCommandBuffers(m_Device, m_CommandPool, static_cast<uint32_t>(m_CommandBuffers.size()), m_CommandBuffers.data());
-
-		vkDestroyPipeline(m_Device, m_GraphicsPipeline, nullptr);
-		vkDestroyPipelineLayout(m_Device, m_PiplineLayout, nullptr);
-		vkDestroyRenderPass(m_Device, m_RenderPass, nullptr);
-
 		for (auto imageView : m_SwapchainImageViews)
 			vkDestroyImageView(m_Device, imageView, nullptr);
 
-		vkDestroySwapchainKHR(m_Device, m_Swapchain, nullptr);
+		CleanupRenderTargets();
+	}
+
+	void VulkanApplication::CleanupPipeline()
+	{
+		DestroyCompiledPipeline(m_Device, m_ScenePipeline);
+		DestroyCompiledPipeline(m_Device, m_DepthPipeline);
+
+		for (auto& retired : m_RetiredPipelines)
+			DestroyCompiledPipeline(m_Device, retired);
+		m_RetiredPipelines.clear();
+
+		vkDestroyRenderPass(m_Device, m_RenderPass, nullptr);
 	}
 
 	//////////////////////////////////////////////////////////////////////////////////
@@ -610,236 +771,324 @@ namespace Vulkan {
 	}
 
 	//////////////////////////////////////////////////////////////////////////////////
-	// Graphics Pipeline Helpers
+	// Render Targets
 	//////////////////////////////////////////////////////////////////////////////////
 
-	static std::vector<char> ReadFile(const std::string& filepath)
+	VkFormat VulkanApplication::FindDepthFormat()
+	{
+		// Most precise first, the scene has no use for stencil
+		const VkFormat candidates[] = { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_X8_D24_UNORM_PACK32, VK_FORMAT_D24_UNORM_S8_UINT, VK_FORMAT_D16_UNORM };
+
+		for (VkFormat format : candidates)
+		{
+			VkFormatProperties properties;
+			vkGetPhysicalDeviceFormatProperties(m_PhysicalDevice, format, &properties);
+
+			if (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT)
+				return format;
+		}
+
+		// D16_UNORM support is required, so this is never reached on a conformant device
+		std::cout << "Failed to find a depth format!" << std::endl;
+		return VK_FORMAT_D16_UNORM;
+	}
+
+	VkSampleCountFlagBits VulkanApplication::ChooseSampleCount(uint32_t requested)
 	{
-		std::ifstream file(filepath, std::ios::ate | std::ios::binary);
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(m_PhysicalDevice, &properties);
 
-		if (!file.is_open())
+		// Color and depth share the subpass, so both have to support the count
+		VkSampleCountFlags supported = properties.limits.framebufferColorSampleCounts & properties.limits.framebufferDepthSampleCounts;
+
+		// Sample count bits are the counts themselves, the highest supported one at or below the request wins
+		for (uint32_t samples = VK_SAMPLE_COUNT_64_BIT; samples > VK_SAMPLE_COUNT_1_BIT; samples >>= 1)
 		{
-			std::cout << "Failed to open file: " << filepath << std::endl;
-			__debugbreak();
+			if (samples <= requested && (supported & samples))
+				return static_cast<VkSampleCountFlagBits>(samples);
 		}
 
-		size_t fileSize = (size_t)file.tellg();
-		std::vector<char> buffer(fileSize);
+		return VK_SAMPLE_COUNT_1_BIT;
+	}
+
+	void VulkanApplication::CreateRenderTargets()
+	{
+		// Every frame declares the same transient images, so the ones the framebuffers are built from stay in use
+		BuildRenderGraph(0);
+	}
 
-		file.seekg(0);
-		file.read(buffer.data(), fileSize);
-		file.close();
+	void VulkanApplication::CleanupRenderTargets()
+	{
+		m_RenderGraph->Reset();
+		m_RenderGraph->ReleaseTransients();
 
-		return buffer;
+		m_DepthTarget = INVALID_RENDER_RESOURCE;
+		m_ColorTarget = INVALID_RENDER_RESOURCE;
 	}
 
 	//////////////////////////////////////////////////////////////////////////////////
 	// Graphics Pipeline
 	//////////////////////////////////////////////////////////////////////////////////
 
-	VkShaderModule VulkanApplication::CreateShaderModule(const std::vector<char>& source)
+	GraphicsPipelineDesc VulkanApplication::GetScenePipelineDesc(VertexEncoding format) const
 	{
-		VkShaderModuleCreateInfo createInfo{};
-		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		createInfo.codeSize = source.size();
-		createInfo.pCode = reinterpret_cast<const uint32_t*>(source.data());
+		GraphicsPipelineDesc desc;
+		desc.VertexShader = SHADER_DIRECTORY "/" SCENE_VERTEX_SHADER;
+		desc.FragmentShader = SHADER_DIRECTORY "/" SCENE_FRAGMENT_SHADER;
+		desc.VertexSource = SHADER_DIRECTORY "/" SCENE_VERTEX_SOURCE;
+		desc.FragmentSource = SHADER_DIRECTORY "/" SCENE_FRAGMENT_SOURCE;
+		desc.PushConstantSize = sizeof(DrawConstants);
+
+		switch (format)
+		{
+		case VertexEncoding::Half:	desc.VertexInput = HalfVertexInput::GetCreateInfo(); break;
+		case VertexEncoding::Snorm:	desc.VertexInput = SnormVertexInput::GetCreateInfo(); break;
+		default:					desc.VertexInput = FloatVertexInput::GetCreateInfo(); break;
+		}
 
-		VkShaderModule shaderModule;
-		if (vkCreateShaderModule(m_Device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
-			std::cout << "Failed to create shader module!" << std::endl;
+		// Quantized encodings decode octahedral normals
+		desc.Specialization = { format != VertexEncoding::Float };
+		desc.SharedSetLayouts = { m_Bindless->GetSetLayout(), m_UniformRing->GetSetLayout() };
+		desc.Samples = m_SampleCount;
+		desc.RenderPass = m_RenderPass;
 
-		return shaderModule;
+		// After a pre-pass the depth buffer already holds the nearest surface, only it is shaded
+		desc.DepthTest = true;
+		desc.DepthWrite = !m_Properties.DepthPrepass;
+		desc.DepthCompareOp = m_Properties.DepthPrepass ? VK_COMPARE_OP_EQUAL : VK_COMPARE_OP_LESS_OR_EQUAL;
+
+		return desc;
 	}
 
-	void VulkanApplication::CreateGraphicsPipeline()
+	GraphicsPipelineDesc VulkanApplication::GetDepthPipelineDesc(VertexEncoding format) const
 	{
-		// Shader Modules
-		auto vertexShader = ReadFile("assets/shaders/vert.spv");
-		auto fragmentShader = ReadFile("assets/shaders/frag.spv");
+		// Same vertex shader and layout as the scene, gl_Position is invariant so both produce identical depth
+		GraphicsPipelineDesc desc = GetScenePipelineDesc(format);
+		desc.FragmentShader.clear();
+		desc.BlendEnable = false;
+		desc.ColorWriteMask = 0;
+		desc.DepthWrite = true;
+		desc.DepthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+		return desc;
+	}
 
-		VkShaderModule vertexShaderModule = CreateShaderModule(vertexShader);
-		VkShaderModule fragmentShaderModule = CreateShaderModule(fragmentShader);
+	void VulkanApplication::SubmitScenePipeline()
+	{
+		// Only the newest description matters, an older compile is thrown away
+		if (m_PendingScenePipeline != INVALID_PIPELINE_HANDLE)
+			m_PipelineCompiler->Cancel(m_PendingScenePipeline);
 
-		VkPipelineShaderStageCreateInfo vertexShaderStageInfo{};
-		vertexShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		vertexShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-		vertexShaderStageInfo.module = vertexShaderModule;
-		vertexShaderStageInfo.pName = "main";
+		m_PendingScenePipeline = m_PipelineCompiler->Submit(GetScenePipelineDesc(m_Properties.VertexFormat));
 
-		VkPipelineShaderStageCreateInfo fragmentShaderStageInfo{};
-		fragmentShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		fragmentShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-		fragmentShaderStageInfo.module = fragmentShaderModule;
-		fragmentShaderStageInfo.pName = "main";
+		if (m_PendingDepthPipeline != INVALID_PIPELINE_HANDLE)
+			m_PipelineCompiler->Cancel(m_PendingDepthPipeline);
+		m_PendingDepthPipeline = INVALID_PIPELINE_HANDLE;
 
-		VkPipelineShaderStageCreateInfo shaderStages[] = { vertexShaderStageInfo, fragmentShaderStageInfo };
+		if (m_Properties.DepthPrepass)
+			m_PendingDepthPipeline = m_PipelineCompiler->Submit(GetDepthPipelineDesc(m_Properties.VertexFormat));
+	}
 
+	void VulkanApplication::CancelScenePipelines()
+	{
+		for (PipelineHandle* pending : { &m_PendingScenePipeline, &m_PendingDepthPipeline })
+		{
+			if (*pending != INVALID_PIPELINE_HANDLE)
+				m_PipelineCompiler->Cancel(*pending);
+			*pending = INVALID_PIPELINE_HANDLE;
+		}
+	}
 
-		// Vertex Input
-		auto bindingDescription = Vertex::GetBindingDescription();
-		auto attributeDescription = Vertex::GetAttributeDescriptions();
+	void VulkanApplication::WaitForScenePipeline()
+	{
+		if (m_PendingScenePipeline != INVALID_PIPELINE_HANDLE)
+			m_PipelineCompiler->Wait(m_PendingScenePipeline);
+		if (m_PendingDepthPipeline != INVALID_PIPELINE_HANDLE)
+			m_PipelineCompiler->Wait(m_PendingDepthPipeline);
 
-		VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
-		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-		vertexInputInfo.vertexBindingDescriptionCount = 1;
-		vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescription.size());
-		vertexInputInfo.pVertexAttributeDescriptions = attributeDescription.data();
+		UpdatePipelines();
+	}
 
-		// Input Assembly
-		VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
-		inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-		inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-		inputAssembly.primitiveRestartEnable = VK_FALSE;
+	bool VulkanApplication::IsSceneReady()
+	{
+		// A complete ticket's acquire is already on the graphics queue, ahead of the frame
+		if (!m_UploadManager->IsComplete(m_GeometryTicket))
+			return false;
 
-		// Viewports and Scissors
-		VkViewport viewport{};
-		viewport.x = 0.0f;
-		viewport.y = 0.0f;
-		viewport.width = (float)m_SwapchainExtent.width;
-		viewport.height = (float)m_SwapchainExtent.height;
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
+		return m_ScenePipeline.Pipeline && (!m_Properties.DepthPrepass || m_DepthPipeline.Pipeline);
+	}
 
-		VkRect2D scissor{};
-		scissor.offset = { 0, 0 };
-		scissor.extent = m_SwapchainExtent;
+	void VulkanApplication::UpdatePipelines()
+	{
+		// Pipelines are retired with the last submitted value, every frame recorded with them is done past it
+		uint64_t completedValue = m_GraphicsTimeline->GetCompletedValue();
+		for (auto it = m_RetiredPipelines.begin(); it != m_RetiredPipelines.end();)
+		{
+			if (it->RetireValue <= completedValue)
+			{
+				DestroyCompiledPipeline(m_Device, *it);
+				it = m_RetiredPipelines.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
 
-		VkPipelineViewportStateCreateInfo viewportState{};
-		viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-		viewportState.viewportCount = 1;
-		viewportState.pViewports = &viewport;
-		viewportState.scissorCount = 1;
-		viewportState.pScissors = &scissor;
-
-		// Rasterizer
-		VkPipelineRasterizationStateCreateInfo rasterizer{};
-		rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-		rasterizer.depthClampEnable = VK_FALSE;
-		rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-		rasterizer.lineWidth = 1.0f;
-		rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-		rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
-		rasterizer.depthBiasEnable = VK_FALSE;
-
-		// Multisampling
-		VkPipelineMultisampleStateCreateInfo multisampling{};
-		multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-		multisampling.sampleShadingEnable = VK_FALSE;
-		multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-		multisampling.minSampleShading = 1.0f;
-		multisampling.pSampleMask = nullptr;
-		multisampling.alphaToCoverageEnable = VK_FALSE;
-		multisampling.alphaToOneEnable = VK_FALSE;
-
-		// Color blending
-		VkPipelineColorBlendAttachmentState colorBlendAttachment{};
-		colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-		colorBlendAttachment.blendEnable = VK_TRUE;
-		colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-		colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-		colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
-		colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-		colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-		colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
-
-		VkPipelineColorBlendStateCreateInfo colorBlending{};
-		colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-		colorBlending.logicOpEnable = VK_FALSE;
-		colorBlending.logicOp = VK_LOGIC_OP_COPY;
-		colorBlending.attachmentCount = 1;
-		colorBlending.pAttachments = &colorBlendAttachment;
-
-		// Dynamic States
-		VkDynamicState dynamicStates[] = {
-			VK_DYNAMIC_STATE_VIEWPORT,
-			VK_DYNAMIC_STATE_LINE_WIDTH
-		};
+		if (m_ShaderReloadRequested.exchange(false))
+			SubmitScenePipeline();
 
-		VkPipelineDynamicStateCreateInfo dynamicState{};
-		dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-		dynamicState.dynamicStateCount = 2;
-		dynamicState.pDynamicStates = dynamicStates;
-
-		// Pipeline Layout
-		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutInfo.setLayoutCount = 0;
-		pipelineLayoutInfo.pSetLayouts = nullptr;
-		pipelineLayoutInfo.pushConstantRangeCount = 0;
-		pipelineLayoutInfo.pPushConstantRanges = nullptr;
-
-		if (vkCreatePipelineLayout(m_Device, &pipelineLayoutInfo, nullptr, &m_PiplineLayout) != VK_SUCCESS)
-			std::cout << "Failed to create pipeline layout!" << std::endl;
-
-		// Pipeline
-		VkGraphicsPipelineCreateInfo pipelineInfo{};
-		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-		pipelineInfo.stageCount = 2;
-		pipelineInfo.pStages = shaderStages;
-		
-		pipelineInfo.pVertexInputState = &vertexInputInfo;
-		pipelineInfo.pInputAssemblyState = &inputAssembly;
-		pipelineInfo.pViewportState = &viewportState;
-		pipelineInfo.pRasterizationState = &rasterizer;
-		pipelineInfo.pMultisampleState = &multisampling;
-		pipelineInfo.pDepthStencilState = nullptr;
-		pipelineInfo.pColorBlendState = &colorBlending;
-		pipelineInfo.pDynamicState = nullptr;
+		if (!CollectScenePipelines())
+			return;
+
+		if (!m_StartupReported)
+		{
+			m_PipelineCache->ReportStartup();
+			m_StartupReported = true;
+		}
+	}
+
+	bool VulkanApplication::CollectScenePipelines()
+	{
+		if (m_PendingScenePipeline == INVALID_PIPELINE_HANDLE)
+			return false;
+
+		// The pre-pass and the scene pass have to agree on the depth they test, so neither is
+		// collected before the other one is done
+		bool hasDepth = m_PendingDepthPipeline != INVALID_PIPELINE_HANDLE;
+		if (m_PipelineCompiler->GetStatus(m_PendingScenePipeline) == PipelineStatus::Pending)
+			return false;
+		if (hasDepth && m_PipelineCompiler->GetStatus(m_PendingDepthPipeline) == PipelineStatus::Pending)
+			return false;
+
+		CompiledPipeline scene;
+		CompiledPipeline depth;
+		bool sceneReady = m_PipelineCompiler->Collect(m_PendingScenePipeline, scene) == PipelineStatus::Ready;
+		bool depthReady = !hasDepth || m_PipelineCompiler->Collect(m_PendingDepthPipeline, depth) == PipelineStatus::Ready;
+
+		m_PendingScenePipeline = INVALID_PIPELINE_HANDLE;
+		m_PendingDepthPipeline = INVALID_PIPELINE_HANDLE;
+
+		if (!sceneReady || !depthReady)
+		{
+			// Draws stay skipped until the pipelines exist, a broken reload keeps the working pair
+			const char* name = sceneReady ? "depth" : "scene";
+			if (m_ScenePipeline.Pipeline)
+				std::cout << "Shader reload failed for the " << name << " pipeline, keeping the current pipelines" << std::endl;
+			else
+				std::cout << "Failed to create " << name << " pipeline!" << std::endl;
+
+			DestroyCompiledPipeline(m_Device, scene);
+			DestroyCompiledPipeline(m_Device, depth);
+			return false;
+		}
+
+		if (hasDepth)
+			SwapPipeline("depth", m_DepthPipeline, depth);
+		SwapPipeline("scene", m_ScenePipeline, scene);
+
+		return true;
+	}
+
+	void VulkanApplication::SwapPipeline(const char* name, CompiledPipeline& current, CompiledPipeline& pipeline)
+	{
+		if (current.Pipeline)
+		{
+			std::cout << "Reloaded " << name << " pipeline in " << pipeline.CreationMs << " ms" << std::endl;
+
+			current.RetireValue = m_GraphicsTimeline->GetSubmittedValue();
+			m_RetiredPipelines.push_back(std::move(current));
+		}
 
-		pipelineInfo.layout = m_PiplineLayout;
-		pipelineInfo.renderPass = m_RenderPass;
-		pipelineInfo.subpass = 0;
+		m_PipelineCache->RecordCreation(pipeline.CreationMs);
+		current = std::move(pipeline);
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Shader Hot Reload
+	//////////////////////////////////////////////////////////////////////////////////
 
-		if (vkCreateGraphicsPipelines(m_Device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_GraphicsPipeline) != VK_SUCCESS)
-			std::cout << "Failed to create graphics pipeline!" << std::endl;
+	void VulkanApplication::OnShadersChanged(const std::vector<std::string>& files)
+	{
+		bool sceneShaderChanged = false;
+		for (const auto& file : files)
+			sceneShaderChanged |= file == SCENE_VERTEX_SHADER || file == SCENE_FRAGMENT_SHADER;
 
-		// Cleanup
-		vkDestroyShaderModule(m_Device, vertexShaderModule, nullptr);
-		vkDestroyShaderModule(m_Device, fragmentShaderModule, nullptr);
+		// Compiled on the pipeline compiler, the render loop submits it so handles stay on one thread
+		if (sceneShaderChanged)
+			m_ShaderReloadRequested = true;
 	}
 
 	void VulkanApplication::CreateRenderPass()
 	{
-		// Attachment Descriptions
+		bool multisampled = m_SampleCount != VK_SAMPLE_COUNT_1_BIT;
+
+		// Attachment Descriptions. Attachments stay in their attachment layouts, the render graph transitions
+		// and synchronizes them around the pass. Multisampled color is resolved at the end of the subpass and never stored
 		VkAttachmentDescription colorAttachment{};
 		colorAttachment.format = m_SwapchainImageFormat;
-		colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		colorAttachment.samples = m_SampleCount;
 		colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		colorAttachment.storeOp = multisampled ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
 		colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 		colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		colorAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+		// Cleared every frame and never read after the pass
+		VkAttachmentDescription depthAttachment{};
+		depthAttachment.format = m_DepthFormat;
+		depthAttachment.samples = m_SampleCount;
+		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		// The swapchain image, only written by the resolve
+		VkAttachmentDescription resolveAttachment{};
+		resolveAttachment.format = m_SwapchainImageFormat;
+		resolveAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		resolveAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		resolveAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		resolveAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		resolveAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		resolveAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		resolveAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
 		// Sub pass and attachment references
 		VkAttachmentReference colorAttachmentRef{};
 		colorAttachmentRef.attachment = 0;
 		colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
+		VkAttachmentReference depthAttachmentRef{};
+		depthAttachmentRef.attachment = 1;
+		depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		VkAttachmentReference resolveAttachmentRef{};
+		resolveAttachmentRef.attachment = 2;
+		resolveAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
 		VkSubpassDescription subpass{};
 		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
 		subpass.colorAttachmentCount = 1;
 		subpass.pColorAttachments = &colorAttachmentRef;
-
-		VkSubpassDependency dependency{};
-		dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-		dependency.dstSubpass = 0;
-		dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		dependency.srcAccessMask = 0;
-		dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		subpass.pResolveAttachments = multisampled ? &resolveAttachmentRef : nullptr;
+		subpass.pDepthStencilAttachment = &depthAttachmentRef;
 
 		// Render pass
 		VkRenderPassCreateInfo renderPassInfo{};
 		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-		renderPassInfo.attachmentCount = 1;
-		renderPassInfo.pAttachments = &colorAttachment;
+		VkAttachmentDescription attachments[] = { colorAttachment, depthAttachment, resolveAttachment };
+
+		renderPassInfo.attachmentCount = multisampled ? 3 : 2;
+		renderPassInfo.pAttachments = attachments;
 		renderPassInfo.subpassCount = 1;
 		renderPassInfo.pSubpasses = &subpass;
 
-		renderPassInfo.dependencyCount = 1;
-		renderPassInfo.pDependencies = &dependency;
+		renderPassInfo.dependencyCount = 0;
+		renderPassInfo.pDependencies = nullptr;
 
 		if (vkCreateRenderPass(m_Device, &renderPassInfo, nullptr, &m_RenderPass) != VK_SUCCESS)
 			std::cout << "Failed to create render pass!" << std::endl;
@@ -855,15 +1104,19 @@ namespace Vulkan {
 
 		for (size_t i = 0; i < m_SwapchainImageViews.size(); i++)
 		{
+			// Multisampled frames render into the shared color image and resolve into the swapchain image
+			bool multisampled = m_SampleCount != VK_SAMPLE_COUNT_1_BIT;
 			VkImageView attachments[] =
 			{
+				multisampled ? m_RenderGraph->GetImageView(m_ColorTarget) : m_SwapchainImageViews[i],
+				m_RenderGraph->GetImageView(m_DepthTarget),
 				m_SwapchainImageViews[i]
 			};
 
 			VkFramebufferCreateInfo framebufferInfo{};
 			framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
 			framebufferInfo.renderPass = m_RenderPass;
-			framebufferInfo.attachmentCount = 1;
+			framebufferInfo.attachmentCount = multisampled ? 3 : 2;
 			framebufferInfo.pAttachments = attachments;
 			framebufferInfo.width = m_SwapchainExtent.width;
 			framebufferInfo.height = m_SwapchainExtent.height;
@@ -878,230 +1131,1724 @@ namespace Vulkan {
 	// Command Buffers
 	//////////////////////////////////////////////////////////////////////////////////
 
-	void VulkanApplication::CreateCommandPool()
+	void VulkanApplication::CreateFrameResources()
 	{
-		QueueFamilyIndicies queueFamilyIndices = FindQueueFamilies(m_PhysicalDevice);
-
 		VkCommandPoolCreateInfo poolInfo{};
 		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-		poolInfo.queueFamilyIndex = queueFamilyIndices.GraphicsFamily.value();
-		poolInfo.flags = 0;
+		poolInfo.queueFamilyIndex = m_QueueFamilies.GraphicsFamily.value();
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
 
-		if (vkCreateCommandPool(m_Device, &poolInfo, nullptr, &m_CommandPool) != VK_SUCCESS)
-			std::cout << "Failed to create command pool!" << std::endl;
-	}
+		m_Frames.resize(m_FramesInFlight);
+		for (auto& frame : m_Frames)
+		{
+			if (vkCreateCommandPool(m_Device, &poolInfo, nullptr, &frame.PrimaryPool) != VK_SUCCESS)
+				std::cout << "Failed to create command pool!" << std::endl;
 
-	void VulkanApplication::CreateCommandBuffers()
-	{
-		m_CommandBuffers.resize(m_SwapchainFramebuffers.size());
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = frame.PrimaryPool;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandBufferCount = 1;
 
-		VkCommandBufferAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		allocInfo.commandPool = m_CommandPool;
-		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		allocInfo.commandBufferCount = (uint32_t)m_CommandBuffers.size();
+			if (vkAllocateCommandBuffers(m_Device, &allocInfo, &frame.PrimaryBuffer) != VK_SUCCESS)
+				std::cout << "Failed to allocate command buffers!" << std::endl;
 
-		if (vkAllocateCommandBuffers(m_Device, &allocInfo, m_CommandBuffers.data()) != VK_SUCCESS)
-			std::cout << "Failed to allocate command buffers!" << std::endl;
+			frame.ThreadPools.resize(m_ThreadPool->GetThreadCount());
+			for (auto& threadPool : frame.ThreadPools)
+			{
+				if (vkCreateCommandPool(m_Device, &poolInfo, nullptr, &threadPool.Pool) != VK_SUCCESS)
+					std::cout << "Failed to create command pool!" << std::endl;
+			}
+		}
+	}
 
-		for (size_t i = 0; i < m_CommandBuffers.size(); i++)
+	void VulkanApplication::CleanupFrameResources()
+	{
+		// Destroying a pool frees every buffer allocated from it
+		for (auto& frame : m_Frames)
 		{
-			VkCommandBufferBeginInfo beginInfo{};
-			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-
-			if (vkBeginCommandBuffer(m_CommandBuffers[i], &beginInfo) != VK_SUCCESS)
-				std::cout << "Failed to begin recording command!" << std::endl;
+			vkDestroyCommandPool(m_Device, frame.PrimaryPool, nullptr);
 
-			VkRenderPassBeginInfo renderPassInfo{};
-			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-			renderPassInfo.renderPass = m_RenderPass;
-			renderPassInfo.framebuffer = m_SwapchainFramebuffers[i];
-			renderPassInfo.renderArea.offset = { 0, 0 };
-			renderPassInfo.renderArea.extent = m_SwapchainExtent;
+			for (auto& threadPool : frame.ThreadPools)
+				vkDestroyCommandPool(m_Device, threadPool.Pool, nullptr);
 
-			VkClearValue clearColor = { 0.0f, 0.0f, 0.0f, 1.0f };
-			renderPassInfo.clearValueCount = 1;
-			renderPassInfo.pClearValues = &clearColor;
+			if (frame.InstanceBuffer != VK_NULL_HANDLE)
+				m_Allocator->DestroyBuffer(frame.InstanceBuffer, frame.InstanceAllocation);
 
-			// Draw Call
-			vkCmdBeginRenderPass(m_CommandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-			vkCmdBindPipeline(m_CommandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, m_GraphicsPipeline);
+			if (frame.MaterialBuffer != VK_NULL_HANDLE)
+			{
+				m_Bindless->RemoveBuffer(frame.MaterialBufferIndex);
+				m_Allocator->DestroyBuffer(frame.MaterialBuffer, frame.MaterialAllocation);
+			}
+		}
 
-			VkBuffer vertexBuffers[] = {m_VertexBuffer};
-			VkDeviceSize offsets[] = { 0 };
-			vkCmdBindVertexBuffers(m_CommandBuffers[i], 0, 1, vertexBuffers, offsets);
+		m_Frames.clear();
+		m_ThreadPool.reset();
+	}
 
-			vkCmdDraw(m_CommandBuffers[i], static_cast<uint32_t>(m_Verticies.size()), 1, 0, 0);
+	VkCommandBuffer VulkanApplication::GetSecondaryBuffer(ThreadCommandPool& threadPool)
+	{
+		// Buffers survive the pool reset, so they are only allocated the first time a frame needs that many
+		if (threadPool.UsedBuffers == threadPool.SecondaryBuffers.size())
+		{
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = threadPool.Pool;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocInfo.commandBufferCount = 1;
+
+			VkCommandBuffer commandBuffer;
+			if (vkAllocateCommandBuffers(m_Device, &allocInfo, &commandBuffer) != VK_SUCCESS)
+				std::cout << "Failed to allocate secondary command buffer!" << std::endl;
+
+			threadPool.SecondaryBuffers.push_back(commandBuffer);
+		}
+
+		return threadPool.SecondaryBuffers[threadPool.UsedBuffers++];
+	}
+
+	void VulkanApplication::RecordFrame(uint32_t imageIndex)
+	{
+		ProfileScope scope(m_Profiler.get(), "Record");
+		auto start = std::chrono::high_resolution_clock::now();
+
+		FrameResources& frame = m_Frames[m_CurrentFrame];
+
+		// The frame's timeline value was reached, nothing recorded from these pools is still pending
+		vkResetCommandPool(m_Device, frame.PrimaryPool, 0);
+		for (auto& threadPool : frame.ThreadPools)
+		{
+			vkResetCommandPool(m_Device, threadPool.Pool, 0);
+			threadPool.UsedBuffers = 0;
+		}
+
+		// Decided once, every job of the frame has to agree
+		m_DrawScene = IsSceneReady();
+
+		// Secondary Command Buffers, a GPU-driven frame records its single indirect draw in one job
+		uint32_t drawCount = m_GpuDriven ? 0 : static_cast<uint32_t>(m_DrawCommands.size());
+		uint32_t passJobCount = std::max((drawCount + DRAWS_PER_RECORDING_JOB - 1) / DRAWS_PER_RECORDING_JOB, 1u);
+
+		// The pre-pass jobs come first, executed in order they lay down all depth before any color is shaded
+		uint32_t passCount = m_Properties.DepthPrepass ? 2 : 1;
+		uint32_t jobCount = passJobCount * passCount;
+		frame.JobBuffers.resize(jobCount);
 
-			vkCmdEndRenderPass(m_CommandBuffers[i]);
+		m_ThreadPool->Dispatch(jobCount, [&](uint32_t job, uint32_t thread)
+		{
+			ProfileScope jobScope(m_Profiler.get(), "RecordJob");
+
+			VkCommandBuffer commandBuffer = GetSecondaryBuffer(frame.ThreadPools[thread]);
+
+			VkCommandBufferInheritanceInfo inheritanceInfo{};
+			inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+			inheritanceInfo.renderPass = m_RenderPass;
+			inheritanceInfo.subpass = 0;
+			inheritanceInfo.framebuffer = m_SwapchainFramebuffers[imageIndex];
+			inheritanceInfo.pipelineStatistics = m_Profiler ? m_Profiler->GetStatisticFlags() : 0;
+
+			VkCommandBufferBeginInfo beginInfo{};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+			beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+			if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+				std::cout << "Failed to begin recording command!" << std::endl;
 
-			if (vkEndCommandBuffer(m_CommandBuffers[i]) != VK_SUCCESS)
+			const CompiledPipeline& pipeline = job < passJobCount && passCount == 2 ? m_DepthPipeline : m_ScenePipeline;
+
+			uint32_t firstDraw = (job % passJobCount) * DRAWS_PER_RECORDING_JOB;
+			RecordDrawCommands(commandBuffer, pipeline, firstDraw, std::min(drawCount - std::min(firstDraw, drawCount), (uint32_t)DRAWS_PER_RECORDING_JOB));
+
+			if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
 				std::cout << "Failed to record command buffer!" << std::endl;
+
+			frame.JobBuffers[job] = commandBuffer;
+		});
+
+		// Primary Command Buffer
+		VkCommandBuffer commandBuffer = frame.PrimaryBuffer;
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+			std::cout << "Failed to begin recording command!" << std::endl;
+
+		if (m_Profiler)
+			m_Profiler->CmdResetQueries(commandBuffer);
+
+		// Cull, scene and readback, with the barriers between them
+		BuildRenderGraph(imageIndex);
+		m_RenderGraph->Execute(commandBuffer);
+
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+			std::cout << "Failed to record command buffer!" << std::endl;
+
+		m_RecordingMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	void VulkanApplication::BuildRenderGraph(uint32_t imageIndex)
+	{
+		bool multisampled = m_SampleCount != VK_SAMPLE_COUNT_1_BIT;
+
+		m_RenderGraph->Reset();
+
+		// Swapchain images are presented, headless targets are only read back and reused once consumed
+		RenderResource target = m_Properties.Headless
+			? m_RenderGraph->ImportImage("Target", m_SwapchainImages[imageIndex], m_SwapchainImageFormat, ResourceUsage::None, ResourceUsage::None)
+			: m_RenderGraph->ImportImage("Target", m_SwapchainImages[imageIndex], m_SwapchainImageFormat, ResourceUsage::Acquire, ResourceUsage::Present);
+
+		m_DepthTarget = m_RenderGraph->CreateImage("Depth", { m_DepthFormat, m_SwapchainExtent, m_SampleCount });
+		m_ColorTarget = multisampled ? m_RenderGraph->CreateImage("Color", { m_SwapchainImageFormat, m_SwapchainExtent, m_SampleCount }) : INVALID_RENDER_RESOURCE;
+
+		// Cull, the visible count is read on the host once the frame completed
+		RenderResource draws = INVALID_RENDER_RESOURCE;
+		if (m_GpuDriven)
+		{
+			draws = m_RenderGraph->ImportBuffer("Draws", ResourceUsage::None, ResourceUsage::HostRead);
+
+			uint32_t cullPass = m_RenderGraph->AddPass("Cull", [this](VkCommandBuffer commandBuffer)
+			{
+				uint32_t cullScope = m_Profiler ? m_Profiler->CmdBeginGpuScope(commandBuffer, "Cull") : UINT32_MAX;
+
+				m_GpuCuller->CmdCull(commandBuffer, m_CurrentFrame, GetCullParams());
+
+				if (m_Profiler)
+					m_Profiler->CmdEndGpuScope(commandBuffer, cullScope);
+			});
+
+			m_RenderGraph->Write(cullPass, draws, ResourceUsage::ComputeWrite);
+		}
+
+		// Scene, the recording jobs' secondary command buffers
+		uint32_t scenePass = m_RenderGraph->AddPass("Scene", [this, imageIndex](VkCommandBuffer commandBuffer)
+		{
+			FrameResources& frame = m_Frames[m_CurrentFrame];
+
+			VkRenderPassBeginInfo renderPassInfo{};
+			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+			renderPassInfo.renderPass = m_RenderPass;
+			renderPassInfo.framebuffer = m_SwapchainFramebuffers[imageIndex];
+			renderPassInfo.renderArea.offset = { 0, 0 };
+			renderPassInfo.renderArea.extent = m_SwapchainExtent;
+
+			// The resolve attachment isn't cleared, its value is ignored
+			VkClearValue clearValues[3]{};
+			clearValues[0].color = { 0.0f, 0.0f, 0.0f, 1.0f };
+			clearValues[1].depthStencil = { 1.0f, 0 };
+			renderPassInfo.clearValueCount = m_SampleCount != VK_SAMPLE_COUNT_1_BIT ? 3 : 2;
+			renderPassInfo.pClearValues = clearValues;
+
+			uint32_t renderScope = UINT32_MAX;
+			if (m_Profiler)
+			{
+				m_Profiler->CmdBeginStatistics(commandBuffer);
+				renderScope = m_Profiler->CmdBeginGpuScope(commandBuffer, "RenderPass");
+			}
+
+			vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+			vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(frame.JobBuffers.size()), frame.JobBuffers.data());
+			vkCmdEndRenderPass(commandBuffer);
+
+			if (m_Profiler)
+			{
+				m_Profiler->CmdEndGpuScope(commandBuffer, renderScope);
+				m_Profiler->CmdEndStatistics(commandBuffer);
+			}
+		});
+
+		// Multisampled color is resolved into the target by the same subpass
+		m_RenderGraph->Write(scenePass, multisampled ? m_ColorTarget : target, ResourceUsage::ColorAttachment);
+		m_RenderGraph->Write(scenePass, m_DepthTarget, ResourceUsage::DepthAttachment);
+		if (multisampled)
+			m_RenderGraph->Write(scenePass, target, ResourceUsage::ColorAttachment);
+		if (draws != INVALID_RENDER_RESOURCE)
+			m_RenderGraph->Read(scenePass, draws, ResourceUsage::IndirectRead);
+
+		// Readback
+		if (m_Properties.Headless)
+		{
+			RenderResource readback = m_RenderGraph->ImportBuffer("Readback", ResourceUsage::None, ResourceUsage::HostRead);
+
+			uint32_t readbackPass = m_RenderGraph->AddPass("Readback", [this, imageIndex](VkCommandBuffer commandBuffer)
+			{
+				uint32_t readbackScope = m_Profiler ? m_Profiler->CmdBeginGpuScope(commandBuffer, "Readback") : UINT32_MAX;
+
+				VkBufferImageCopy region{};
+				region.bufferOffset = 0;
+				region.bufferRowLength = 0;
+				region.bufferImageHeight = 0;
+				region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				region.imageSubresource.mipLevel = 0;
+				region.imageSubresource.baseArrayLayer = 0;
+				region.imageSubresource.layerCount = 1;
+				region.imageOffset = { 0, 0, 0 };
+				region.imageExtent = { m_SwapchainExtent.width, m_SwapchainExtent.height, 1 };
+
+				vkCmdCopyImageToBuffer(commandBuffer, m_OffscreenTargets[imageIndex].Image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_OffscreenTargets[imageIndex].ReadbackBuffer, 1, &region);
+
+				if (m_Profiler)
+					m_Profiler->CmdEndGpuScope(commandBuffer, readbackScope);
+			});
+
+			m_RenderGraph->Read(readbackPass, target, ResourceUsage::TransferRead);
+			m_RenderGraph->Write(readbackPass, readback, ResourceUsage::TransferWrite);
+		}
+
+		m_RenderGraph->Compile();
+	}
+
+	void VulkanApplication::RecordDrawCommands(VkCommandBuffer commandBuffer, const CompiledPipeline& pipeline, uint32_t firstDraw, uint32_t drawCount)
+	{
+		// Still compiling or uploading, the frame is cleared and presented without the scene. The scene alone would fail its EQUAL test
+		if (!m_DrawScene)
+			return;
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.Pipeline);
+
+		VkViewport viewport{};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = (float)m_SwapchainExtent.width;
+		viewport.height = (float)m_SwapchainExtent.height;
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+		VkRect2D scissor{};
+		scissor.offset = { 0, 0 };
+		scissor.extent = m_SwapchainExtent;
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+		// Textures and materials are indexed in the shaders, nothing is bound per draw
+		m_Bindless->CmdBind(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.Layout);
+		m_UniformRing->CmdBind(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.Layout, m_Frames[m_CurrentFrame].ConstantsOffset);
+
+		VkDeviceSize instanceOffset = 0;
+		vkCmdBindVertexBuffers(commandBuffer, 1, 1, &m_Frames[m_CurrentFrame].InstanceBuffer, &instanceOffset);
+
+		// The cull pass already wrote this frame's draws
+		if (m_GpuDriven)
+		{
+			VkDeviceSize vertexOffset = 0;
+			vkCmdBindVertexBuffers(commandBuffer, 0, 1, &m_VertexBuffer, &vertexOffset);
+			vkCmdBindIndexBuffer(commandBuffer, m_IndexBuffer, 0, m_IndexType);
+
+			DrawConstants constants = { glm::vec4(0.0f, 0.0f, 1.0f, 0.0f) };
+			vkCmdPushConstants(commandBuffer, pipeline.Layout, pipeline.PushConstantStages, 0, sizeof(constants), &constants);
+
+			m_GpuCuller->CmdDraw(commandBuffer, m_CurrentFrame);
+			return;
+		}
+
+		vkCmdBindIndexBuffer(commandBuffer, m_IndexBuffer, 0, m_IndexType);
+
+		// Draw Calls
+		VkBuffer boundBuffer = VK_NULL_HANDLE;
+		for (uint32_t i = firstDraw; i < firstDraw + drawCount; i++)
+		{
+			const DrawCommand& draw = m_DrawCommands[i];
+
+			if (draw.VertexBuffer != boundBuffer)
+			{
+				VkDeviceSize offset = 0;
+				vkCmdBindVertexBuffers(commandBuffer, 0, 1, &draw.VertexBuffer, &offset);
+				boundBuffer = draw.VertexBuffer;
+			}
+
+			DrawConstants constants = { draw.Transform };
+			vkCmdPushConstants(commandBuffer, pipeline.Layout, pipeline.PushConstantStages, 0, sizeof(constants), &constants);
+
+			vkCmdDrawIndexed(commandBuffer, draw.IndexCount, draw.InstanceCount, draw.FirstIndex, draw.VertexOffset, draw.FirstInstance);
 		}
 	}
 
 	//////////////////////////////////////////////////////////////////////////////////
-	// Vertex Buffers
+	// Instances
 	//////////////////////////////////////////////////////////////////////////////////
 
-	void VulkanApplication::CreateVertexBuffer()
+	void VulkanApplication::UpdateInstances(FrameResources& frame)
 	{
-		VkBufferCreateInfo bufferInfo{};
-		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-		bufferInfo.size = sizeof(m_Verticies[0]) * m_Verticies.size();
-		bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		ProfileScope scope(m_Profiler.get(), "Instances");
 
-		if (vkCreateBuffer(m_Device, &bufferInfo, nullptr, &m_VertexBuffer) != VK_SUCCESS)
-			std::cout << "Failed to create vertex buffer!" << std::endl;
+		// The frame's previous submission has completed, so its stream can be replaced
+		if (frame.InstanceCapacity < m_InstanceCount)
+		{
+			if (frame.InstanceBuffer != VK_NULL_HANDLE)
+				m_Allocator->DestroyBuffer(frame.InstanceBuffer, frame.InstanceAllocation);
+
+			VkBufferCreateInfo bufferInfo{};
+			bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			bufferInfo.size = sizeof(InstanceData) * m_InstanceCount;
+			bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+			bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-		VkMemoryRequirements memReq;
-		vkGetBufferMemoryRequirements(m_Device, m_VertexBuffer, &memReq);
+			// Device local when the device exposes host visible VRAM, read once per frame either way
+			if (!m_Allocator->CreateBuffer(bufferInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frame.InstanceBuffer, frame.InstanceAllocation))
+				std::cout << "Failed to create instance buffer!" << std::endl;
 
-		VkMemoryAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memReq.size;
-		allocInfo.memoryTypeIndex = FindMemoryType(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			frame.InstanceCapacity = m_InstanceCount;
+		}
+
+		InstanceData* instances = static_cast<InstanceData*>(frame.InstanceAllocation.MappedData);
+		ObjectBounds* bounds = m_GpuDriven ? m_GpuCuller->MapBounds(m_CurrentFrame, m_InstanceCount) : nullptr;
+
+		// Square grid over clip space, one cell per instance
+		uint32_t gridSize = static_cast<uint32_t>(std::ceil(std::sqrt((double)m_InstanceCount)));
+		float cellSize = 2.0f / gridSize;
+		float time = m_AnimationFrame * 0.02f;
+		uint32_t materialCount = static_cast<uint32_t>(m_Materials.size());
+
+		uint32_t jobCount = (m_InstanceCount + INSTANCES_PER_UPDATE_JOB - 1) / INSTANCES_PER_UPDATE_JOB;
+		m_ThreadPool->Dispatch(jobCount, [&](uint32_t job, uint32_t)
+		{
+			uint32_t first = job * INSTANCES_PER_UPDATE_JOB;
+			uint32_t last = std::min(first + INSTANCES_PER_UPDATE_JOB, m_InstanceCount);
+
+			for (uint32_t i = first; i < last; i++)
+			{
+				float x = -1.0f + cellSize * ((i % gridSize) + 0.5f);
+				float y = -1.0f + cellSize * ((i / gridSize) + 0.5f);
+
+				// Cheap integer hash so neighbouring instances get distinct colors
+				uint32_t hash = i * 2654435761u;
 
-		if (vkAllocateMemory(m_Device, &allocInfo, nullptr, &m_VertexBufferMemory) != VK_SUCCESS)
-			std::cout << "Failed to allocate vertex buffer memory!" << std::endl;
+				InstanceData& instance = instances[i];
+				instance.Transform = glm::vec4(x, y, 1.0f / gridSize, time + i * 0.001f);
+				instance.Color = glm::vec4(0.5f + (hash & 0xFF) / 510.0f, 0.5f + ((hash >> 8) & 0xFF) / 510.0f, 0.5f + ((hash >> 16) & 0xFF) / 510.0f, 1.0f);
+				instance.MaterialID = i % materialCount;
 
-		vkBindBufferMemory(m_Device, m_VertexBuffer, m_VertexBufferMemory, 0);
+				if (bounds)
+					bounds[i] = ObjectBounds(x, y, 0.0f, m_MeshRadius / gridSize);
+			}
+		});
 
-		void* data;
-		vkMapMemory(m_Device, m_VertexBufferMemory, 0, bufferInfo.size, 0, &data);
-		memcpy(data, m_Verticies.data(), (size_t)bufferInfo.size);
-		vkUnmapMemory(m_Device, m_VertexBufferMemory);
+		m_Allocator->FlushAllocation(frame.InstanceAllocation, 0, sizeof(InstanceData) * m_InstanceCount);
+		m_AnimationFrame++;
 	}
 
-	uint32_t VulkanApplication::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
+	//////////////////////////////////////////////////////////////////////////////////
+	// Materials
+	//////////////////////////////////////////////////////////////////////////////////
+
+	void VulkanApplication::UpdateMaterials(FrameResources& frame)
 	{
-		VkPhysicalDeviceMemoryProperties memProp;
-		vkGetPhysicalDeviceMemoryProperties(m_PhysicalDevice, &memProp);
+		uint32_t materialCount = static_cast<uint32_t>(m_Materials.size());
+
+		// The frame's previous submission has completed, its old slot is retired for the frames after it
+		if (frame.MaterialCapacity < materialCount)
+		{
+			if (frame.MaterialBuffer != VK_NULL_HANDLE)
+			{
+				m_Bindless->RemoveBuffer(frame.MaterialBufferIndex);
+				m_Allocator->DestroyBuffer(frame.MaterialBuffer, frame.MaterialAllocation);
+			}
 
-		for (uint32_t i = 0; i < memProp.memoryTypeCount; i++)
+			VkBufferCreateInfo bufferInfo{};
+			bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			bufferInfo.size = sizeof(MaterialData) * materialCount;
+			bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+			bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+			if (!m_Allocator->CreateBuffer(bufferInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frame.MaterialBuffer, frame.MaterialAllocation))
+				std::cout << "Failed to create material buffer!" << std::endl;
+
+			frame.MaterialBufferIndex = m_Bindless->AddBuffer(frame.MaterialBuffer, 0, bufferInfo.size);
+			frame.MaterialCapacity = materialCount;
+		}
+
+		MaterialData* materials = static_cast<MaterialData*>(frame.MaterialAllocation.MappedData);
+		for (uint32_t i = 0; i < materialCount; i++)
 		{
-			if (typeFilter & (1 << i) && (memProp.memoryTypes[i].propertyFlags & properties) == properties)
-				return i;
+			materials[i].Color = m_Materials[i].Color;
+			materials[i].TextureIndex = m_TextureStreamer->GetDescriptorIndex(m_Materials[i].Texture);
 		}
 
-		std::cout << "Failed to find suitable memory type!" << std::endl;
-		return 0;
+		m_Allocator->FlushAllocation(frame.MaterialAllocation, 0, sizeof(MaterialData) * materialCount);
+	}
+
+	void VulkanApplication::UpdateFrameConstants(FrameResources& frame)
+	{
+		// The slice's previous frame has completed, the same wait that freed the frame's command pools
+		m_UniformRing->BeginFrame(m_CurrentFrame);
+
+		FrameConstants constants{};
+		constants.View = m_View;
+		constants.MaterialBuffer = frame.MaterialBufferIndex;
+		constants.DepthScale = m_MeshRadius > 0.0f ? 1.0f / m_MeshRadius : 0.0f;
+
+		if (!m_UniformRing->Push(constants, frame.ConstantsOffset))
+			std::cout << "Failed to allocate frame constants!" << std::endl;
+
+		m_UniformRing->Flush();
 	}
 
 	//////////////////////////////////////////////////////////////////////////////////
-	// Rendering
+	// GPU Culling
 	//////////////////////////////////////////////////////////////////////////////////
 
-	void VulkanApplication::CreateSyncObjects()
+	void VulkanApplication::CreateGpuCuller()
 	{
-		m_ImageAvailableSemaphore.resize(MAX_FRAMES_IN_FLIGHT);
-		m_RenderFinishedSemaphore.resize(MAX_FRAMES_IN_FLIGHT);
-		m_InFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-		m_ImagesInFlight.resize(m_SwapchainImages.size(), VK_NULL_HANDLE);
+		if (!m_DrawIndirectCount)
+			return;
 
-		VkSemaphoreCreateInfo semaphoreInfo{};
-		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		auto start = std::chrono::high_resolution_clock::now();
 
-		VkFenceCreateInfo fenceInfo{};
-		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+		AssetData cullShader;
+		if (!LoadAsset(m_AssetPack.get(), SHADER_DIRECTORY "/" CULL_SHADER, AssetType::Shader, cullShader))
+			return;
 
-		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		if (!cullShader.Storage.empty() && IsOlderThanSource(SHADER_DIRECTORY "/" CULL_SHADER, SHADER_DIRECTORY "/" CULL_SOURCE))
 		{
-			if (vkCreateSemaphore(m_Device, &semaphoreInfo, nullptr, &m_ImageAvailableSemaphore[i]) != VK_SUCCESS
-				|| vkCreateSemaphore(m_Device, &semaphoreInfo, nullptr, &m_RenderFinishedSemaphore[i]) != VK_SUCCESS
-				|| vkCreateFence(m_Device, &fenceInfo, nullptr, &m_InFlightFences[i]) != VK_SUCCESS)
-				std::cout << "Failed to create synchronization objects for a frame!" << std::endl;
+			std::cout << SHADER_DIRECTORY "/" CULL_SHADER " is older than " SHADER_DIRECTORY "/" CULL_SOURCE ", rebuild the shaders!" << std::endl;
+			return;
 		}
+
+		m_GpuCuller = std::make_unique<GpuCuller>(m_Device, *m_Allocator, m_PipelineCache->GetHandle(), cullShader.Data, cullShader.Size, m_FramesInFlight);
+
+		m_PipelineCache->RecordCreation(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
 	}
 
-	void VulkanApplication::Present()
+	CullParams VulkanApplication::GetCullParams() const
 	{
-		vkWaitForFences(m_Device, 1, &m_InFlightFences[m_CurrentFrame], VK_TRUE, UINT64_MAX);
+		// World space rectangle the view maps onto clip space
+		float halfExtent = 1.0f / m_View.z;
+		float left = m_View.x - halfExtent, right = m_View.x + halfExtent;
+		float bottom = m_View.y - halfExtent, top = m_View.y + halfExtent;
+
+		CullParams params{};
+		params.FrustumPlanes[0] = glm::vec4( 1.0f,  0.0f, 0.0f, -left);
+		params.FrustumPlanes[1] = glm::vec4(-1.0f,  0.0f, 0.0f,  right);
+		params.FrustumPlanes[2] = glm::vec4( 0.0f,  1.0f, 0.0f, -bottom);
+		params.FrustumPlanes[3] = glm::vec4( 0.0f, -1.0f, 0.0f,  top);
+		params.ObjectCount = m_InstanceCount;
+		params.IndexCount = m_Mesh.IndexCount;
+		params.FirstIndex = 0;
+		params.VertexOffset = 0;
+
+		return params;
+	}
 
-		// Rendering
-		uint32_t imageIndex;
-		VkResult result = vkAcquireNextImageKHR(m_Device, m_Swapchain, UINT64_MAX, m_ImageAvailableSemaphore[m_CurrentFrame], VK_NULL_HANDLE, &imageIndex);
+	//////////////////////////////////////////////////////////////////////////////////
+	// Vertex Buffers
+	//////////////////////////////////////////////////////////////////////////////////
 
-		if (result == VK_ERROR_OUT_OF_DATE_KHR)
+	bool VulkanApplication::BuildMesh(const std::string& path, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		std::vector<ObjVertex> objVertices;
+		if (!LoadObj(path, objVertices))
+			return false;
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		// Fit into the same unit box as the built-in triangle, so the instance grid still tiles
+		glm::vec3 minBounds = objVertices[0].Position, maxBounds = objVertices[0].Position;
+		for (const auto& vertex : objVertices)
 		{
-			RecreateSwapchain();
-			return;
+			minBounds = glm::min(minBounds, vertex.Position);
+			maxBounds = glm::max(maxBounds, vertex.Position);
 		}
-		else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+
+		glm::vec3 extent = maxBounds - minBounds;
+		float scale = 1.0f / std::max(std::max(extent.x, extent.y), std::max(extent.z, 1e-6f));
+		glm::vec3 center = (minBounds + maxBounds) * 0.5f;
+
+		vertices.resize(objVertices.size());
+		for (size_t i = 0; i < objVertices.size(); i++)
 		{
-			std::cout << "Failed to acquire swapchain image!" << std::endl;
+			// OBJ is y-up, clip space is y-down
+			glm::vec3 position = (objVertices[i].Position - center) * scale;
+			vertices[i].Position = glm::vec3(position.x, -position.y, position.z);
+			vertices[i].Color = objVertices[i].Normal * 0.5f + 0.5f;
+			vertices[i].Normal = glm::vec3(objVertices[i].Normal.x, -objVertices[i].Normal.y, objVertices[i].Normal.z);
 		}
 
-		if (m_ImagesInFlight[imageIndex] != VK_NULL_HANDLE)
-			vkWaitForFences(m_Device, 1, &m_ImagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
-		m_ImagesInFlight[imageIndex] = m_InFlightFences[m_CurrentFrame];
+		size_t soupCount = vertices.size();
+		indices = DeduplicateVertices(vertices);
+		VertexCacheStats before = AnalyzeVertexCache(indices, vertices.size());
 
-		VkSubmitInfo submitInfo{};
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		OptimizeVertexCache(indices, vertices.size());
+		OptimizeOverdraw(indices, &vertices[0].Position, vertices.size(), sizeof(Vertex));
+		OptimizeVertexFetch(vertices, indices);
 
-		VkSemaphore waitSemaphore[] = { m_ImageAvailableSemaphore[m_CurrentFrame] };
-		VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+		VertexCacheStats after = AnalyzeVertexCache(indices, vertices.size());
 
-		submitInfo.waitSemaphoreCount = 1;
-		submitInfo.pWaitSemaphores = waitSemaphore;
-		submitInfo.pWaitDstStageMask = waitStages;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &m_CommandBuffers[imageIndex];
+		double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
 
-		VkSemaphore signalSemaphores[] = { m_RenderFinishedSemaphore[m_CurrentFrame] };
-		submitInfo.signalSemaphoreCount = 1;
-		submitInfo.pSignalSemaphores = signalSemaphores;
+		std::cout << "Mesh " << path << " (" << indices.size() / 3 << " triangles, " << soupCount << " -> " << vertices.size() << " vertices, "
+			<< (vertices.size() <= 65536 ? 16 : 32) << "-bit indices, optimized in " << milliseconds << " ms)" << std::endl;
+		std::cout << "  Before: ACMR " << before.ACMR << ", ATVR " << before.ATVR << std::endl;
+		std::cout << "  After:  ACMR " << after.ACMR << ", ATVR " << after.ATVR << " (FIFO " << VERTEX_CACHE_ANALYSIS_SIZE << ")" << std::endl;
 
-		vkResetFences(m_Device, 1, &m_InFlightFences[m_CurrentFrame]);
+		return true;
+	}
 
-		if (vkQueueSubmit(m_GraphicsQueue, 1, &submitInfo, m_InFlightFences[m_CurrentFrame]) != VK_SUCCESS)
-			std::cout << "failed to submit draw command buffer!" << std::endl;
+	void VulkanApplication::LoadMesh()
+	{
+		MeshAssetView packed;
 
-		// Presentation
-		VkSwapchainKHR swapChains[] = { m_Swapchain };
+		if (!m_Properties.MeshPath.empty())
+		{
+			std::vector<Vertex> vertices;
+			std::vector<uint32_t> indices;
 
-		VkPresentInfoKHR presentInfo{};
-		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+			if (BuildMesh(m_Properties.MeshPath, vertices, indices))
+			{
+				m_Verticies.swap(vertices);
+				m_Indicies.swap(indices);
+			}
+			else
+			{
+				std::cout << "Falling back to the built-in triangle" << std::endl;
+			}
+		}
+		else if (m_AssetPack && m_AssetPack->FindMesh(SCENE_MESH_ASSET, packed))
+		{
+			// Baked already conditioned, the buffers are filled straight from the mapping
+			if (packed.VertexStride == sizeof(Vertex))
+			{
+				m_Mesh.Vertices = static_cast<const Vertex*>(packed.Vertices);
+				m_Mesh.VertexCount = packed.VertexCount;
+				m_Mesh.Indices = packed.Indices;
+				m_Mesh.IndexCount = packed.IndexCount;
+				m_Mesh.IndexType = packed.IndexSize == sizeof(uint16_t) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+
+				std::cout << "Mesh " << SCENE_MESH_ASSET << " mapped from " << m_Properties.AssetPackPath << " (" << m_Mesh.IndexCount / 3 << " triangles, " << m_Mesh.VertexCount << " vertices)" << std::endl;
+				return;
+			}
 
-		presentInfo.waitSemaphoreCount = 1;
-		presentInfo.pWaitSemaphores = signalSemaphores;
+			std::cout << "Packed mesh has " << packed.VertexStride << " byte vertices instead of " << sizeof(Vertex) << ", falling back to the built-in triangle" << std::endl;
+		}
 
-		presentInfo.swapchainCount = 1;
-		presentInfo.pSwapchains = swapChains;
-		presentInfo.pImageIndices = &imageIndex;
-		presentInfo.pResults = nullptr;
+		m_Mesh.Vertices = m_Verticies.data();
+		m_Mesh.VertexCount = static_cast<uint32_t>(m_Verticies.size());
+		m_Mesh.Indices = m_Indicies.data();
+		m_Mesh.IndexCount = static_cast<uint32_t>(m_Indicies.size());
+		m_Mesh.IndexType = VK_INDEX_TYPE_UINT32;
+	}
 
-		result = vkQueuePresentKHR(m_PresentQueue, &presentInfo);
+	UploadTicket VulkanApplication::CreateVertexBuffer()
+	{
+		const void* vertexData = m_Mesh.Vertices;
+		VkDeviceSize vertexSize = sizeof(Vertex);
 
-		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || framebufferResized)
+		m_QuantizedVertices.clear();
+		if (m_Properties.VertexFormat != VertexEncoding::Float)
 		{
-			framebufferResized = false;
-			RecreateSwapchain();
+			m_QuantizedVertices.resize(m_Mesh.VertexCount);
+
+			VertexStreams streams = { &m_Mesh.Vertices[0].Position.x, &m_Mesh.Vertices[0].Color.x, &m_Mesh.Vertices[0].Normal.x, sizeof(Vertex) };
+			QuantizeVertices(m_Properties.VertexFormat, streams, m_Mesh.VertexCount, m_QuantizedVertices.data());
+
+			vertexData = m_QuantizedVertices.data();
+			vertexSize = sizeof(QuantizedVertex);
 		}
-		else if (result != VK_SUCCESS)
+
+		VkBufferCreateInfo bufferInfo{};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = vertexSize * m_Mesh.VertexCount;
+		bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		if (!m_Allocator->CreateBuffer(bufferInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, m_VertexBuffer, m_VertexBufferAllocation))
+			std::cout << "Failed to create vertex buffer!" << std::endl;
+
+		return m_UploadManager->UploadBuffer(m_VertexBuffer, 0, vertexData, bufferInfo.size, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+	}
+
+	UploadTicket VulkanApplication::CreateIndexBuffer()
+	{
+		// 16-bit indices halve index fetch whenever the mesh fits, baked meshes are narrowed already
+		const void* indexData = m_Mesh.Indices;
+		m_IndexType = m_Mesh.IndexType;
+
+		m_ShortIndices.clear();
+		if (m_IndexType == VK_INDEX_TYPE_UINT32 && m_Mesh.VertexCount <= 65536)
 		{
-			std::cout << "Failed to present swapchain image!" << std::endl;
+			const uint32_t* indices = static_cast<const uint32_t*>(m_Mesh.Indices);
+			m_ShortIndices.assign(indices, indices + m_Mesh.IndexCount);
+			indexData = m_ShortIndices.data();
+			m_IndexType = VK_INDEX_TYPE_UINT16;
 		}
 
-		m_CurrentFrame = (m_CurrentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+		VkDeviceSize indexSize = m_IndexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+
+		VkBufferCreateInfo bufferInfo{};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = indexSize * m_Mesh.IndexCount;
+		bufferInfo.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		if (!m_Allocator->CreateBuffer(bufferInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, m_IndexBuffer, m_IndexBufferAllocation))
+			std::cout << "Failed to create index buffer!" << std::endl;
+
+		return m_UploadManager->UploadBuffer(m_IndexBuffer, 0, indexData, bufferInfo.size, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT);
 	}
 
 	//////////////////////////////////////////////////////////////////////////////////
-	// Application Runtime
+	// Asset Baking
 	//////////////////////////////////////////////////////////////////////////////////
 
-	void VulkanApplication::Run()
+	bool VulkanApplication::BakeAssetPack(const WindowProps& props)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+
+		AssetPackWriter writer;
+		if (!writer.AddFile(SHADER_DIRECTORY "/" SCENE_VERTEX_SHADER, AssetType::Shader) || !writer.AddFile(SHADER_DIRECTORY "/" SCENE_FRAGMENT_SHADER, AssetType::Shader))
+			return false;
+
+		// Only compiled when the culling shader is, the app draws from the CPU without it
+		if (std::filesystem::exists(SHADER_DIRECTORY "/" CULL_SHADER))
+			writer.AddFile(SHADER_DIRECTORY "/" CULL_SHADER, AssetType::Shader);
+
+		// Mip levels stay as they are in the KTX2 file, the streamer uploads them straight from the pack
+		if (!props.TexturePath.empty() && !writer.AddFile(props.TexturePath, AssetType::Texture))
+			return false;
+
+		// Baked in the layout the index buffer is created with, so loading is a plain copy
+		if (!props.MeshPath.empty())
+		{
+			std::vector<Vertex> vertices;
+			std::vector<uint32_t> indices;
+			if (!BuildMesh(props.MeshPath, vertices, indices))
+				return false;
+
+			if (vertices.size() <= 65536)
+			{
+				std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+				writer.AddMesh(SCENE_MESH_ASSET, vertices.data(), static_cast<uint32_t>(vertices.size()), sizeof(Vertex), shortIndices.data(), static_cast<uint32_t>(shortIndices.size()), sizeof(uint16_t));
+			}
+			else
+			{
+				writer.AddMesh(SCENE_MESH_ASSET, vertices.data(), static_cast<uint32_t>(vertices.size()), sizeof(Vertex), indices.data(), static_cast<uint32_t>(indices.size()), sizeof(uint32_t));
+			}
+		}
+
+		if (!writer.Write(props.BakePath))
+			return false;
+
+		double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		std::cout << "Baked " << writer.GetAssetCount() << " assets into " << props.BakePath << " in " << milliseconds << " ms" << std::endl;
+
+		return true;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Headless Targets
+	//////////////////////////////////////////////////////////////////////////////////
+
+	void VulkanApplication::CreateOffscreenTargets()
 	{
-		while (!glfwWindowShouldClose(m_Window))
+		m_SwapchainImageFormat = VK_FORMAT_R8G8B8A8_UNORM;
+		m_SwapchainExtent = { m_Properties.Width, m_Properties.Height };
+
+		VkDeviceSize readbackSize = (VkDeviceSize)m_SwapchainExtent.width * m_SwapchainExtent.height * 4;
+
+		// One more target than frames in flight, so readback of the oldest never blocks rendering
+		m_OffscreenTargets.resize(m_FramesInFlight + 1);
+		m_SwapchainImages.resize(m_FramesInFlight + 1);
+
+		for (size_t i = 0; i < m_OffscreenTargets.size(); i++)
 		{
-			glfwPollEvents();
+			OffscreenTarget& target = m_OffscreenTargets[i];
+
+			// Render Target
+			VkImageCreateInfo imageInfo{};
+			imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			imageInfo.imageType = VK_IMAGE_TYPE_2D;
+			imageInfo.format = m_SwapchainImageFormat;
+			imageInfo.extent = { m_SwapchainExtent.width, m_SwapchainExtent.height, 1 };
+			imageInfo.mipLevels = 1;
+			imageInfo.arrayLayers = 1;
+			imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+			imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+			imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+			if (!m_Allocator->CreateImage(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, target.Image, target.ImageAllocation))
+				std::cout << "Failed to create offscreen image! [" << i << "]" << std::endl;
+
+			// Readback Buffer
+			VkBufferCreateInfo bufferInfo{};
+			bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			bufferInfo.size = readbackSize;
+			bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+			bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+			// Cached memory makes host reads fast, coherent memory saves the invalidate
+			if (!m_Allocator->CreateBuffer(bufferInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, target.ReadbackBuffer, target.ReadbackAllocation))
+				std::cout << "Failed to create readback buffer! [" << i << "]" << std::endl;
+
+			target.Pending = false;
+			m_SwapchainImages[i] = target.Image;
+		}
+
+		m_HostFrame.resize((size_t)readbackSize);
+	}
 
-			Present();
+	void VulkanApplication::CleanupOffscreenTargets()
+	{
+		for (auto& target : m_OffscreenTargets)
+		{
+			m_Allocator->DestroyBuffer(target.ReadbackBuffer, target.ReadbackAllocation);
+			m_Allocator->DestroyImage(target.Image, target.ImageAllocation);
 		}
 
-		vkDeviceWaitIdle(m_Device);
+		m_OffscreenTargets.clear();
 	}
 
-}
\ No newline at end of file
+	void VulkanApplication::ConsumeReadback(OffscreenTarget& target)
+	{
+		if (!target.Pending)
+			return;
+
+		size_t size = m_HostFrame.size();
+
+		m_Allocator->InvalidateAllocation(target.ReadbackAllocation, 0, size);
+
+		if (m_ReadbackCallback)
+			m_ReadbackCallback(target.FrameIndex, target.ReadbackAllocation.MappedData, size);
+		else
+			memcpy(m_HostFrame.data(), target.ReadbackAllocation.MappedData, size);
+
+		m_ReadbackBytes += size;
+		m_ReadbackFrames++;
+		target.Pending = false;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Rendering
+	//////////////////////////////////////////////////////////////////////////////////
+
+	void VulkanApplication::CreateSyncObjects()
+	{
+		// Frame completion is tracked on the graphics timeline, the binary semaphores are only for the swapchain
+		m_ImageAvailableSemaphore.resize(m_FramesInFlight);
+		m_RenderFinishedSemaphore.resize(m_FramesInFlight);
+
+		VkSemaphoreCreateInfo semaphoreInfo{};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+		for (uint32_t i = 0; i < m_FramesInFlight; i++)
+		{
+			if (vkCreateSemaphore(m_Device, &semaphoreInfo, nullptr, &m_ImageAvailableSemaphore[i]) != VK_SUCCESS
+				|| vkCreateSemaphore(m_Device, &semaphoreInfo, nullptr, &m_RenderFinishedSemaphore[i]) != VK_SUCCESS)
+				std::cout << "Failed to create synchronization objects for a frame!" << std::endl;
+		}
+	}
+
+	uint64_t VulkanApplication::SubmitFrame(VkSemaphore waitSemaphore, VkSemaphore signalSemaphore)
+	{
+		ProfileScope scope(m_Profiler.get(), "Submit");
+
+		FrameResources& frame = m_Frames[m_CurrentFrame];
+		frame.TimelineValue = m_GraphicsTimeline->NextValue();
+
+		// Binary semaphores ignore their entry in the value arrays
+		VkSemaphore signalSemaphores[] = { m_GraphicsTimeline->GetSemaphore(), signalSemaphore };
+		uint64_t signalValues[] = { frame.TimelineValue, 0 };
+		uint64_t waitValue = 0;
+		VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+		VkTimelineSemaphoreSubmitInfo timelineInfo{};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.waitSemaphoreValueCount = waitSemaphore ? 1 : 0;
+		timelineInfo.pWaitSemaphoreValues = &waitValue;
+		timelineInfo.signalSemaphoreValueCount = signalSemaphore ? 2 : 1;
+		timelineInfo.pSignalSemaphoreValues = signalValues;
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = &timelineInfo;
+		submitInfo.waitSemaphoreCount = waitSemaphore ? 1 : 0;
+		submitInfo.pWaitSemaphores = &waitSemaphore;
+		submitInfo.pWaitDstStageMask = &waitStage;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &frame.PrimaryBuffer;
+		submitInfo.signalSemaphoreCount = timelineInfo.signalSemaphoreValueCount;
+		submitInfo.pSignalSemaphores = signalSemaphores;
+
+		if (m_Profiler)
+			m_Profiler->MarkSubmit();
+
+		if (vkQueueSubmit(m_GraphicsQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+			std::cout << "failed to submit draw command buffer!" << std::endl;
+
+		// Startup ends with the first frame that draws the scene
+		if (m_StartupGraph && m_DrawScene)
+		{
+			m_StartupGraph->Mark("first frame");
+			m_StartupGraph->Report();
+			if (!m_Properties.StartupTracePath.empty())
+				m_StartupGraph->Export(m_Properties.StartupTracePath);
+			m_StartupGraph.reset();
+		}
+
+		return frame.TimelineValue;
+	}
+
+	void VulkanApplication::Present()
+	{
+		// Waits for the frame that last used this slot, all older frames are complete as well
+		{
+			ProfileScope scope(m_Profiler.get(), "WaitForFrame");
+			m_GraphicsTimeline->Wait(m_Frames[m_CurrentFrame].TimelineValue);
+		}
+
+		if (m_Profiler)
+			m_Profiler->BeginFrame(static_cast<uint32_t>(m_CurrentFrame));
+
+		{
+			ProfileScope scope(m_Profiler.get(), "Uploads");
+			for (const auto& material : m_Materials)
+				m_TextureStreamer->Touch(material.Texture);
+
+			m_TextureStreamer->Update();
+			m_UploadManager->Update();
+			m_Bindless->Update();
+		}
+
+		UpdatePipelines();
+
+		// Rendering
+		uint32_t imageIndex;
+		VkResult result;
+		{
+			ProfileScope scope(m_Profiler.get(), "Acquire");
+			result = vkAcquireNextImageKHR(m_Device, m_Swapchain, UINT64_MAX, m_ImageAvailableSemaphore[m_CurrentFrame], VK_NULL_HANDLE, &imageIndex);
+		}
+
+		if (result == VK_ERROR_OUT_OF_DATE_KHR)
+		{
+			RecreateSwapchain();
+			return;
+		}
+		else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+		{
+			std::cout << "Failed to acquire swapchain image!" << std::endl;
+		}
+
+		UpdateInstances(m_Frames[m_CurrentFrame]);
+		UpdateMaterials(m_Frames[m_CurrentFrame]);
+		UpdateFrameConstants(m_Frames[m_CurrentFrame]);
+		RecordFrame(imageIndex);
+		SubmitFrame(m_ImageAvailableSemaphore[m_CurrentFrame], m_RenderFinishedSemaphore[m_CurrentFrame]);
+
+		// Presentation
+		VkSwapchainKHR swapChains[] = { m_Swapchain };
+
+		VkPresentInfoKHR presentInfo{};
+		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+
+		presentInfo.waitSemaphoreCount = 1;
+		presentInfo.pWaitSemaphores = &m_RenderFinishedSemaphore[m_CurrentFrame];
+
+		presentInfo.swapchainCount = 1;
+		presentInfo.pSwapchains = swapChains;
+		presentInfo.pImageIndices = &imageIndex;
+		presentInfo.pResults = nullptr;
+
+		{
+			ProfileScope scope(m_Profiler.get(), "Present");
+			result = vkQueuePresentKHR(m_PresentQueue, &presentInfo);
+		}
+
+		m_FramePacer.OnPresent();
+
+		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || framebufferResized)
+		{
+			framebufferResized = false;
+			RecreateSwapchain();
+		}
+		else if (result != VK_SUCCESS)
+		{
+			std::cout << "Failed to present swapchain image!" << std::endl;
+		}
+
+		m_CurrentFrame = (m_CurrentFrame + 1) % m_FramesInFlight;
+	}
+
+	void VulkanApplication::PresentHeadless()
+	{
+		// Waits for the frame that last used this slot, all older frames are complete as well
+		{
+			ProfileScope scope(m_Profiler.get(), "WaitForFrame");
+			m_GraphicsTimeline->Wait(m_Frames[m_CurrentFrame].TimelineValue);
+		}
+
+		if (m_Profiler)
+			m_Profiler->BeginFrame(static_cast<uint32_t>(m_CurrentFrame));
+
+		{
+			ProfileScope scope(m_Profiler.get(), "Uploads");
+			for (const auto& material : m_Materials)
+				m_TextureStreamer->Touch(material.Texture);
+
+			m_TextureStreamer->Update();
+			m_UploadManager->Update();
+			m_Bindless->Update();
+		}
+
+		UpdatePipelines();
+
+		uint32_t imageIndex = static_cast<uint32_t>(m_HeadlessFrameIndex % m_OffscreenTargets.size());
+		{
+			ProfileScope scope(m_Profiler.get(), "Readback");
+
+			uint64_t completedValue = m_GraphicsTimeline->GetCompletedValue();
+			for (auto& target : m_OffscreenTargets)
+			{
+				if (target.Pending && target.TimelineValue <= completedValue)
+					ConsumeReadback(target);
+			}
+
+			// A target is only reused after its previous contents were consumed
+			m_GraphicsTimeline->Wait(m_OffscreenTargets[imageIndex].TimelineValue);
+			ConsumeReadback(m_OffscreenTargets[imageIndex]);
+		}
+
+		UpdateInstances(m_Frames[m_CurrentFrame]);
+		UpdateMaterials(m_Frames[m_CurrentFrame]);
+		UpdateFrameConstants(m_Frames[m_CurrentFrame]);
+		RecordFrame(imageIndex);
+		uint64_t timelineValue = SubmitFrame(VK_NULL_HANDLE, VK_NULL_HANDLE);
+
+		m_OffscreenTargets[imageIndex].Pending = true;
+		m_OffscreenTargets[imageIndex].FrameIndex = m_HeadlessFrameIndex;
+		m_OffscreenTargets[imageIndex].TimelineValue = timelineValue;
+
+		m_FramePacer.OnPresent();
+
+		m_HeadlessFrameIndex++;
+		m_CurrentFrame = (m_CurrentFrame + 1) % m_FramesInFlight;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Application Runtime
+	//////////////////////////////////////////////////////////////////////////////////
+
+	void VulkanApplication::Run()
+	{
+		// Measured runs need the scene in every frame, a window starts drawing it once it is ready
+		if (m_Properties.Headless || !m_Properties.Benchmark.empty())
+		{
+			WaitForScenePipeline();
+			m_UploadManager->Wait(m_GeometryTicket);
+		}
+
+		if (m_Properties.Benchmark == "allocator")
+		{
+			RunAllocatorBenchmark();
+			return;
+		}
+		else if (m_Properties.Benchmark == "instancing")
+		{
+			RunInstancingBenchmark();
+			return;
+		}
+		else if (m_Properties.Benchmark == "vertex-formats")
+		{
+			RunVertexFormatBenchmark();
+			return;
+		}
+		else if (m_Properties.Benchmark == "pipelines")
+		{
+			RunPipelineBenchmark();
+			return;
+		}
+		else if (m_Properties.Benchmark == "textures")
+		{
+			RunTextureBenchmark();
+			return;
+		}
+		else if (m_Properties.Benchmark == "depth")
+		{
+			RunDepthBenchmark();
+			return;
+		}
+		else if (!m_Properties.Benchmark.empty())
+		{
+			std::cout << "Unknown benchmark: " << m_Properties.Benchmark << std::endl;
+			return;
+		}
+
+		if (m_Properties.Headless)
+		{
+			RunHeadless();
+		}
+		else
+		{
+			while (!glfwWindowShouldClose(m_Window))
+			{
+				ProfileScope scope(m_Profiler.get(), "Frame");
+
+				// Input is sampled after the limiter so a capped frame starts with fresh input
+				{
+					ProfileScope limiterScope(m_Profiler.get(), "FrameLimiter");
+					m_FramePacer.WaitForNextFrame();
+				}
+
+				glfwPollEvents();
+
+				Present();
+			}
+
+			vkDeviceWaitIdle(m_Device);
+			m_FramePacer.PrintStats();
+		}
+
+		if (m_Profiler)
+		{
+			m_Profiler->Flush();
+			m_Profiler->Export(m_Properties.ProfileOutput);
+		}
+	}
+
+	void VulkanApplication::RunHeadless()
+	{
+		m_ReadbackBytes = 0;
+		m_ReadbackFrames = 0;
+		m_RecordingMs = 0.0;
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		for (uint32_t i = 0; i < m_Properties.HeadlessFrames; i++)
+		{
+			ProfileScope scope(m_Profiler.get(), "Frame");
+
+			{
+				ProfileScope limiterScope(m_Profiler.get(), "FrameLimiter");
+				m_FramePacer.WaitForNextFrame();
+			}
+
+			PresentHeadless();
+		}
+
+		// Drain the frames still in flight
+		vkDeviceWaitIdle(m_Device);
+		for (auto& target : m_OffscreenTargets)
+			ConsumeReadback(target);
+
+		auto end = std::chrono::high_resolution_clock::now();
+		double seconds = std::chrono::duration<double>(end - start).count();
+
+		VkPhysicalDeviceProperties deviceProperties;
+		vkGetPhysicalDeviceProperties(m_PhysicalDevice, &deviceProperties);
+
+		double megabytes = (double)m_ReadbackBytes / (1024.0 * 1024.0);
+
+		std::cout << "Headless benchmark (" << deviceProperties.deviceName << ", " << m_SwapchainExtent.width << "x" << m_SwapchainExtent.height << ", " << m_FramesInFlight << " frames in flight)" << std::endl;
+		std::cout << "  Frames:   " << m_ReadbackFrames << " in " << seconds * 1000.0 << " ms" << std::endl;
+		std::cout << "  Rate:     " << (seconds > 0.0 ? m_ReadbackFrames / seconds : 0.0) << " frames/s" << std::endl;
+		std::cout << "  Readback: " << megabytes << " MB, " << (seconds > 0.0 ? megabytes / seconds : 0.0) << " MB/s" << std::endl;
+		std::cout << "  Recording: " << (m_Properties.HeadlessFrames > 0 ? m_RecordingMs / m_Properties.HeadlessFrames : 0.0) << " ms/frame ("
+			<< (m_GpuDriven ? std::string("1 indirect") : std::to_string(m_DrawCommands.size())) << " draws, " << m_ThreadPool->GetThreadCount() << " threads)" << std::endl;
+
+		if (m_GpuDriven)
+		{
+			uint32_t lastFrame = (m_CurrentFrame + m_FramesInFlight - 1) % m_FramesInFlight;
+			std::cout << "  Culling:  " << m_GpuCuller->GetVisibleCount(lastFrame) << " of " << m_InstanceCount << " objects visible" << std::endl;
+		}
+
+		const RenderGraphStats& graphStats = m_RenderGraph->GetStats();
+		std::cout << "  Graph:    " << graphStats.PassCount - graphStats.CulledPasses << " of " << graphStats.PassCount << " passes, " << graphStats.Barriers << " barriers in "
+			<< graphStats.BarrierBatches << " batches, " << graphStats.TransientImages << " transient images in " << graphStats.TransientBytes / 1024 << " KiB ("
+			<< graphStats.UnaliasedBytes / 1024 << " KiB unaliased)" << std::endl;
+
+		m_FramePacer.PrintStats();
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Benchmarks
+	//////////////////////////////////////////////////////////////////////////////////
+
+	static void ReportLatency(const char* name, std::vector<double>& samples)
+	{
+		if (samples.empty())
+			return;
+
+		std::sort(samples.begin(), samples.end());
+
+		double total = 0.0;
+		for (double sample : samples)
+			total += sample;
+
+		std::cout << "  " << name << ": avg " << total / samples.size() << " ns, p50 " << samples[samples.size() / 2]
+			<< " ns, p99 " << samples[samples.size() * 99 / 100] << " ns (" << samples.size() << " ops)" << std::endl;
+	}
+
+	void VulkanApplication::RunAllocatorBenchmark()
+	{
+		const uint32_t operations = 200000;
+		const uint32_t maxLive = 4096;
+
+		std::mt19937 rng(1337);
+
+		// Log-uniform sizes between 256 B and 256 KB
+		auto randomRequirements = [&rng]()
+		{
+			VkMemoryRequirements requirements{};
+			VkDeviceSize base = VkDeviceSize(256) << (rng() % 10);
+			requirements.size = base + rng() % base;
+			requirements.alignment = VkDeviceSize(256) << (rng() % 4);
+			requirements.memoryTypeBits = UINT32_MAX;
+			return requirements;
+		};
+
+		using Clock = std::chrono::high_resolution_clock;
+
+		// Sub-allocator under churn
+		std::vector<Allocation> live;
+		std::vector<double> allocSamples, freeSamples;
+		live.reserve(maxLive);
+
+		for (uint32_t i = 0; i < operations; i++)
+		{
+			if (live.empty() || (live.size() < maxLive && (rng() & 1)))
+			{
+				VkMemoryRequirements requirements = randomRequirements();
+
+				auto start = Clock::now();
+				Allocation allocation = m_Allocator->Allocate(requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+				allocSamples.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+
+				live.push_back(allocation);
+			}
+			else
+			{
+				size_t index = rng() % live.size();
+				std::swap(live[index], live.back());
+
+				auto start = Clock::now();
+				m_Allocator->Free(live.back());
+				freeSamples.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+
+				live.pop_back();
+			}
+		}
+
+		std::cout << "Allocator benchmark (" << operations << " operations, up to " << maxLive << " live)" << std::endl;
+		m_Allocator->PrintStats();
+
+		for (auto& allocation : live)
+			m_Allocator->Free(allocation);
+
+		std::cout << "Sub-allocation" << std::endl;
+		ReportLatency("Allocate", allocSamples);
+		ReportLatency("Free    ", freeSamples);
+
+		// Driver baseline, kept small to stay clear of maxMemoryAllocationCount
+		const uint32_t driverOperations = 2000;
+		const uint32_t driverMaxLive = 64;
+
+		uint32_t memoryType = m_Allocator->FindMemoryType(UINT32_MAX, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		std::vector<VkDeviceMemory> driverLive;
+		std::vector<double> driverAllocSamples, driverFreeSamples;
+
+		for (uint32_t i = 0; i < driverOperations && memoryType != UINT32_MAX; i++)
+		{
+			if (driverLive.empty() || (driverLive.size() < driverMaxLive && (rng() & 1)))
+			{
+				VkMemoryAllocateInfo allocInfo{};
+				allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+				allocInfo.allocationSize = randomRequirements().size;
+				allocInfo.memoryTypeIndex = memoryType;
+
+				VkDeviceMemory memory;
+
+				auto start = Clock::now();
+				VkResult result = vkAllocateMemory(m_Device, &allocInfo, nullptr, &memory);
+				driverAllocSamples.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+
+				if (result == VK_SUCCESS)
+					driverLive.push_back(memory);
+			}
+			else
+			{
+				size_t index = rng() % driverLive.size();
+				std::swap(driverLive[index], driverLive.back());
+
+				auto start = Clock::now();
+				vkFreeMemory(m_Device, driverLive.back(), nullptr);
+				driverFreeSamples.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+
+				driverLive.pop_back();
+			}
+		}
+
+		for (auto memory : driverLive)
+			vkFreeMemory(m_Device, memory, nullptr);
+
+		std::cout << "vkAllocateMemory / vkFreeMemory" << std::endl;
+		ReportLatency("Allocate", driverAllocSamples);
+		ReportLatency("Free    ", driverFreeSamples);
+	}
+
+	void VulkanApplication::RunInstancingBenchmark()
+	{
+		std::vector<DrawCommand> sceneDraws = m_DrawCommands;
+		uint32_t sceneInstances = m_InstanceCount;
+		bool sceneGpuDriven = m_GpuDriven;
+		uint32_t indexCount = m_Mesh.IndexCount;
+
+		VkPhysicalDeviceProperties deviceProperties;
+		vkGetPhysicalDeviceProperties(m_PhysicalDevice, &deviceProperties);
+
+		std::cout << "Instancing benchmark (" << deviceProperties.deviceName << ", " << INSTANCING_BENCH_FRAMES << " frames per run, "
+			<< m_ThreadPool->GetThreadCount() << " recording threads)" << std::endl;
+
+		enum class DrawMode { Instanced, Separate, Indirect };
+		const char* modeNames[] = { " instanced draw:  ", " separate draws:  ", " culled indirect: " };
+
+		// Same instances every way, only the way they are drawn changes
+		for (uint32_t count = 1000; count <= INSTANCING_BENCH_MAX_INSTANCES; count *= 10)
+		{
+			for (DrawMode mode : { DrawMode::Instanced, DrawMode::Separate, DrawMode::Indirect })
+			{
+				// Needs drawIndirectCount
+				if (mode == DrawMode::Indirect && !m_GpuCuller)
+					continue;
+
+				m_InstanceCount = count;
+				m_GpuDriven = mode == DrawMode::Indirect;
+				m_DrawCommands.clear();
+
+				if (mode == DrawMode::Separate)
+				{
+					for (uint32_t i = 0; i < count; i++)
+						m_DrawCommands.push_back({ m_VertexBuffer, indexCount, 0, 0, 1, i });
+				}
+				else if (mode == DrawMode::Instanced)
+				{
+					m_DrawCommands.push_back({ m_VertexBuffer, indexCount, 0, 0, count, 0 });
+				}
+
+				vkDeviceWaitIdle(m_Device);
+				m_RecordingMs = 0.0;
+
+				auto start = std::chrono::high_resolution_clock::now();
+
+				for (uint32_t i = 0; i < INSTANCING_BENCH_FRAMES; i++)
+				{
+					if (m_Properties.Headless)
+					{
+						PresentHeadless();
+					}
+					else
+					{
+						glfwPollEvents();
+						Present();
+					}
+				}
+
+				vkDeviceWaitIdle(m_Device);
+
+				double frameMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / INSTANCING_BENCH_FRAMES;
+
+				std::cout << "  " << count << " instances," << modeNames[(int)mode] << frameMs << " ms/frame, recording "
+					<< m_RecordingMs / INSTANCING_BENCH_FRAMES << " ms/frame" << std::endl;
+			}
+		}
+
+		if (m_Properties.Headless)
+		{
+			for (auto& target : m_OffscreenTargets)
+				ConsumeReadback(target);
+		}
+
+		m_DrawCommands = sceneDraws;
+		m_InstanceCount = sceneInstances;
+		m_GpuDriven = sceneGpuDriven;
+	}
+
+	void VulkanApplication::RunVertexFormatBenchmark()
+	{
+		VertexEncoding sceneFormat = m_Properties.VertexFormat;
+		size_t vertexCount = m_Mesh.VertexCount;
+		uint64_t drawnVertices = static_cast<uint64_t>(m_Mesh.IndexCount) * m_InstanceCount * std::max<size_t>(m_DrawCommands.size(), 1);
+
+		VkPhysicalDeviceProperties deviceProperties;
+		vkGetPhysicalDeviceProperties(m_PhysicalDevice, &deviceProperties);
+
+		std::cout << "Vertex format benchmark (" << deviceProperties.deviceName << ", " << vertexCount << " vertices, "
+			<< drawnVertices << " indices drawn per frame, " << VERTEX_BENCH_FRAMES << " frames per run)" << std::endl;
+
+		// Encode enough vertices for the timing to mean something on small meshes
+		size_t encodeRepeats = std::max<size_t>(1, 4000000 / vertexCount);
+		std::vector<QuantizedVertex> quantized(vertexCount);
+		VertexStreams streams = { &m_Mesh.Vertices[0].Position.x, &m_Mesh.Vertices[0].Color.x, &m_Mesh.Vertices[0].Normal.x, sizeof(Vertex) };
+
+		auto encodeRate = [&](void (*quantize)(VertexEncoding, const VertexStreams&, size_t, QuantizedVertex*), VertexEncoding encoding)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			for (size_t i = 0; i < encodeRepeats; i++)
+				quantize(encoding, streams, vertexCount, quantized.data());
+			double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+			return static_cast<double>(vertexCount * encodeRepeats) / seconds / 1e6;
+		};
+
+		// Only the scene pipeline is swapped per encoding, so the runs go without the depth pre-pass
+		bool scenePrepass = m_Properties.DepthPrepass;
+		m_Properties.DepthPrepass = false;
+
+		// Every encoding's pipeline compiles in parallel up front instead of between runs
+		const VertexEncoding encodings[] = { VertexEncoding::Float, VertexEncoding::Half, VertexEncoding::Snorm };
+
+		PipelineHandle handles[3];
+		for (int i = 0; i < 3; i++)
+			handles[i] = m_PipelineCompiler->Submit(GetScenePipelineDesc(encodings[i]));
+
+		CompiledPipeline pipelines[3];
+		for (int i = 0; i < 3; i++)
+		{
+			m_PipelineCompiler->Wait(handles[i]);
+			if (m_PipelineCompiler->Collect(handles[i], pipelines[i]) != PipelineStatus::Ready)
+				std::cout << "Failed to create graphics pipeline!" << std::endl;
+		}
+
+		CompiledPipeline scenePipeline = std::move(m_ScenePipeline);
+
+		// Swaps the vertex buffer and the pipeline over to another encoding, the pipelines stay owned by this function
+		auto switchFormat = [&](VertexEncoding encoding, const CompiledPipeline& pipeline)
+		{
+			vkDeviceWaitIdle(m_Device);
+
+			m_Properties.VertexFormat = encoding;
+
+			m_Allocator->DestroyBuffer(m_VertexBuffer, m_VertexBufferAllocation);
+			m_UploadManager->Wait(CreateVertexBuffer());
+
+			for (auto& draw : m_DrawCommands)
+				draw.VertexBuffer = m_VertexBuffer;
+
+			m_ScenePipeline = pipeline;
+		};
+
+		for (int f = 0; f < 3; f++)
+		{
+			VertexEncoding encoding = encodings[f];
+			switchFormat(encoding, pipelines[f]);
+
+			size_t stride = encoding == VertexEncoding::Float ? sizeof(Vertex) : sizeof(QuantizedVertex);
+
+			auto start = std::chrono::high_resolution_clock::now();
+
+			for (uint32_t i = 0; i < VERTEX_BENCH_FRAMES; i++)
+			{
+				if (m_Properties.Headless)
+				{
+					PresentHeadless();
+				}
+				else
+				{
+					glfwPollEvents();
+					Present();
+				}
+			}
+
+			vkDeviceWaitIdle(m_Device);
+
+			double frameMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / VERTEX_BENCH_FRAMES;
+
+			std::cout << "  " << GetVertexEncodingName(encoding) << ": " << stride << " bytes/vertex, " << stride * vertexCount / 1024.0 << " KiB, "
+				<< frameMs << " ms/frame, " << drawnVertices / (frameMs * 1e3) << " M indices/s";
+
+			if (encoding != VertexEncoding::Float)
+				std::cout << ", encode " << encodeRate(QuantizeVertices, encoding) << " M vertices/s SIMD, " << encodeRate(QuantizeVerticesScalar, encoding) << " M vertices/s scalar";
+
+			std::cout << std::endl;
+		}
+
+		if (m_Properties.Headless)
+		{
+			for (auto& target : m_OffscreenTargets)
+				ConsumeReadback(target);
+		}
+
+		switchFormat(sceneFormat, scenePipeline);
+		m_Properties.DepthPrepass = scenePrepass;
+
+		for (auto& pipeline : pipelines)
+			DestroyCompiledPipeline(m_Device, pipeline);
+	}
+
+	void VulkanApplication::RunPipelineBenchmark()
+	{
+		// Every combination is a distinct pipeline as far as the driver is concerned
+		const VertexEncoding encodings[] = { VertexEncoding::Float, VertexEncoding::Half, VertexEncoding::Snorm };
+		const VkCullModeFlags cullModes[] = { VK_CULL_MODE_NONE, VK_CULL_MODE_BACK_BIT, VK_CULL_MODE_FRONT_BIT };
+		const VkPrimitiveTopology topologies[] = { VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP, VK_PRIMITIVE_TOPOLOGY_LINE_LIST, VK_PRIMITIVE_TOPOLOGY_LINE_STRIP };
+
+		std::vector<GraphicsPipelineDesc> descs;
+		for (VertexEncoding encoding : encodings)
+		{
+			for (VkCullModeFlags cullMode : cullModes)
+			{
+				for (bool blendEnable : { true, false })
+				{
+					for (VkPrimitiveTopology topology : topologies)
+					{
+						GraphicsPipelineDesc desc = GetScenePipelineDesc(encoding);
+						desc.CullMode = cullMode;
+						desc.BlendEnable = blendEnable;
+						desc.Topology = topology;
+						descs.push_back(desc);
+					}
+				}
+			}
+		}
+
+		VkPhysicalDeviceProperties deviceProperties;
+		vkGetPhysicalDeviceProperties(m_PhysicalDevice, &deviceProperties);
+
+		std::cout << "Pipeline compile benchmark (" << deviceProperties.deviceName << ", " << descs.size() << " pipelines)" << std::endl;
+
+		auto compileAll = [&](uint32_t threadCount)
+		{
+			// An empty cache per run, otherwise the second run only reads back the first one's binaries
+			VkPipelineCacheCreateInfo cacheInfo{};
+			cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+			VkPipelineCache cache;
+			if (vkCreatePipelineCache(m_Device, &cacheInfo, nullptr, &cache) != VK_SUCCESS)
+			{
+				std::cout << "Failed to create pipeline cache!" << std::endl;
+				return 0.0;
+			}
+
+			double milliseconds;
+			uint32_t failed = 0;
+			{
+				PipelineCompiler compiler(m_Device, cache, m_PipelineCompiler->GetAssetPack(), threadCount);
+
+				auto start = std::chrono::high_resolution_clock::now();
+
+				std::vector<PipelineHandle> handles;
+				for (const auto& desc : descs)
+					handles.push_back(compiler.Submit(desc));
+
+				compiler.WaitIdle();
+
+				milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+				for (PipelineHandle handle : handles)
+				{
+					CompiledPipeline pipeline;
+					if (compiler.Collect(handle, pipeline) == PipelineStatus::Ready)
+						DestroyCompiledPipeline(m_Device, pipeline);
+					else
+						failed++;
+				}
+			}
+
+			vkDestroyPipelineCache(m_Device, cache, nullptr);
+
+			std::cout << "  " << threadCount << " thread(s): " << milliseconds << " ms, " << milliseconds / descs.size() << " ms/pipeline";
+			if (failed)
+				std::cout << ", " << failed << " failed";
+			std::cout << std::endl;
+
+			return milliseconds;
+		};
+
+		double serialMs = compileAll(1);
+		double parallelMs = compileAll(m_PipelineCompiler->GetThreadCount());
+
+		if (parallelMs > 0.0)
+			std::cout << "  Speedup:  " << serialMs / parallelMs << "x" << std::endl;
+	}
+
+	void VulkanApplication::RunTextureBenchmark()
+	{
+		if (m_Properties.TexturePath.empty())
+		{
+			std::cout << "The texture benchmark needs a KTX2 texture, pass one with --texture" << std::endl;
+			return;
+		}
+
+		TextureStats before = m_TextureStreamer->GetStats();
+
+		// Copies of one texture stand in for a scene's materials, only a window of them is visible at a time
+		auto start = std::chrono::high_resolution_clock::now();
+
+		std::vector<TextureHandle> textures;
+		for (uint32_t i = 0; i < TEXTURE_BENCH_COUNT; i++)
+		{
+			TextureHandle texture = m_TextureStreamer->Load(m_AssetPack.get(), m_Properties.TexturePath);
+			if (texture == INVALID_TEXTURE_HANDLE)
+				return;
+
+			textures.push_back(texture);
+		}
+
+		double loadMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		TextureStats loaded = m_TextureStreamer->GetStats();
+		VkDeviceSize textureBytes = (loaded.FullBytes - before.FullBytes) / TEXTURE_BENCH_COUNT;
+
+		// Without an explicit budget the visible window just fits at full resolution next to one chain being replaced,
+		// so moving it has to evict
+		if (m_Properties.TextureBudgetMB == 0)
+			m_TextureStreamer->SetBudget(loaded.ResidentBytes + textureBytes * (TEXTURE_BENCH_VISIBLE + 1));
+
+		const double mebibyte = 1024.0 * 1024.0;
+		std::cout << "Texture streaming benchmark (" << TEXTURE_BENCH_COUNT << " textures, " << TEXTURE_BENCH_VISIBLE << " visible, "
+			<< textureBytes / mebibyte << " MiB each at full resolution, " << m_TextureStreamer->GetStats().Budget / mebibyte << " MiB budget)" << std::endl;
+		std::cout << "  Load:     " << loadMs << " ms, " << (loaded.ResidentBytes - before.ResidentBytes) / 1024.0 << " KiB of mip tails" << std::endl;
+
+		// One material per visible texture, instances cycle through them
+		std::vector<Material> sceneMaterials = m_Materials;
+		m_Materials.assign(TEXTURE_BENCH_VISIBLE, { glm::vec4(1.0f), m_TextureStreamer->GetDefaultTexture() });
+
+		const uint32_t phaseFrames = TEXTURE_BENCH_FRAMES / 8;
+		uint32_t sharpFrame = UINT32_MAX;
+
+		for (uint32_t i = 0; i < TEXTURE_BENCH_FRAMES; i++)
+		{
+			uint32_t first = (i / phaseFrames) * (TEXTURE_BENCH_VISIBLE / 2);
+			for (uint32_t t = 0; t < TEXTURE_BENCH_VISIBLE; t++)
+				m_Materials[t].Texture = textures[(first + t) % TEXTURE_BENCH_COUNT];
+
+			if (m_Properties.Headless)
+			{
+				PresentHeadless();
+			}
+			else
+			{
+				glfwPollEvents();
+				Present();
+			}
+
+			// Frames until the whole window is at full resolution
+			uint32_t residentMips = 0;
+			for (uint32_t t = 0; t < TEXTURE_BENCH_VISIBLE; t++)
+				residentMips += m_TextureStreamer->GetResidentMip(textures[(first + t) % TEXTURE_BENCH_COUNT]);
+
+			if (residentMips == 0 && sharpFrame == UINT32_MAX)
+				sharpFrame = i % phaseFrames;
+
+			if ((i + 1) % phaseFrames != 0)
+				continue;
+
+			TextureStats stats = m_TextureStreamer->GetStats();
+			std::cout << "  Window " << first << ": " << stats.ResidentBytes / mebibyte << " MiB resident, visible at mip " << (double)residentMips / TEXTURE_BENCH_VISIBLE << ", ";
+			if (sharpFrame != UINT32_MAX)
+				std::cout << "sharp after " << sharpFrame << " frames, ";
+			std::cout << stats.StreamedLevels << " levels streamed, " << stats.EvictedLevels << " evicted" << std::endl;
+
+			sharpFrame = UINT32_MAX;
+		}
+
+		vkDeviceWaitIdle(m_Device);
+
+		if (m_Properties.Headless)
+		{
+			for (auto& target : m_OffscreenTargets)
+				ConsumeReadback(target);
+		}
+
+		TextureStats stats = m_TextureStreamer->GetStats();
+		std::cout << "  Peak:     " << stats.PeakBytes / mebibyte << " MiB resident of " << stats.FullBytes / mebibyte << " MiB fully resident" << std::endl;
+
+		m_Materials = sceneMaterials;
+	}
+
+	void VulkanApplication::RunDepthBenchmark()
+	{
+		std::vector<DrawCommand> sceneDraws = m_DrawCommands;
+		bool scenePrepass = m_Properties.DepthPrepass;
+
+		// Layers of the scene drawn back to front, the worst order without a pre-pass. Each is
+		// shifted a little so the nearer ones don't hide the rest entirely
+		m_DrawCommands.clear();
+		for (uint32_t i = 0; i < DEPTH_BENCH_LAYERS; i++)
+		{
+			float t = DEPTH_BENCH_LAYERS > 1 ? (float)i / (DEPTH_BENCH_LAYERS - 1) : 0.0f;
+
+			DrawCommand draw = { m_VertexBuffer, m_Mesh.IndexCount, 0, 0, m_InstanceCount, 0 };
+			draw.Transform = glm::vec4(0.05f * t, -0.05f * t, 1.0f, 0.24f - 0.48f * t);
+			m_DrawCommands.push_back(draw);
+		}
+
+		// Statistics queries were enabled on the device for this benchmark, a profiler only exists with --profile
+		bool ownsProfiler = !m_Profiler;
+		if (ownsProfiler)
+			m_Profiler = std::make_unique<Profiler>(m_PhysicalDevice, m_Device, m_QueueFamilies.GraphicsFamily.value(), m_FramesInFlight, m_Properties.PipelineStatistics);
+
+		VkPhysicalDeviceProperties deviceProperties;
+		vkGetPhysicalDeviceProperties(m_PhysicalDevice, &deviceProperties);
+
+		std::cout << "Depth pre-pass benchmark (" << deviceProperties.deviceName << ", " << m_SwapchainExtent.width << "x" << m_SwapchainExtent.height << ", "
+			<< DEPTH_BENCH_LAYERS << " layers of " << m_InstanceCount << " instances, " << DEPTH_BENCH_FRAMES << " frames per run)" << std::endl;
+
+		uint64_t baseInvocations = 0;
+		for (bool prepass : { false, true })
+		{
+			m_Properties.DepthPrepass = prepass;
+			SubmitScenePipeline();
+			WaitForScenePipeline();
+
+			vkDeviceWaitIdle(m_Device);
+			m_Profiler->Flush();
+			m_Profiler->Clear();
+
+			auto start = std::chrono::high_resolution_clock::now();
+
+			for (uint32_t i = 0; i < DEPTH_BENCH_FRAMES; i++)
+			{
+				if (m_Properties.Headless)
+				{
+					PresentHeadless();
+				}
+				else
+				{
+					glfwPollEvents();
+					Present();
+				}
+			}
+
+			vkDeviceWaitIdle(m_Device);
+			m_Profiler->Flush();
+
+			double frameMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / DEPTH_BENCH_FRAMES;
+
+			std::cout << "  " << (prepass ? "pre-pass:    " : "no pre-pass: ") << frameMs << " ms/frame, render pass " << m_Profiler->GetAverageDuration("RenderPass", true) << " ms on the GPU";
+
+			PipelineStatistics statistics;
+			if (m_Profiler->GetAverageStatistics(statistics))
+			{
+				// Every fragment shader invocation past one per pixel is overdraw
+				double pixels = (double)m_SwapchainExtent.width * m_SwapchainExtent.height;
+				std::cout << ", " << statistics.FragmentShaderInvocations << " fragment invocations/frame (" << statistics.FragmentShaderInvocations / pixels << " per pixel)";
+
+				if (!prepass)
+					baseInvocations = statistics.FragmentShaderInvocations;
+				else if (statistics.FragmentShaderInvocations)
+					std::cout << ", " << (double)baseInvocations / statistics.FragmentShaderInvocations << "x fewer";
+			}
+
+			std::cout << std::endl;
+		}
+
+		if (m_Properties.Headless)
+		{
+			for (auto& target : m_OffscreenTargets)
+				ConsumeReadback(target);
+		}
+
+		if (ownsProfiler)
+			m_Profiler.reset();
+		else
+			m_Profiler->Clear();
+
+		m_DrawCommands = sceneDraws;
+		m_Properties.DepthPrepass = scenePrepass;
+		SubmitScenePipeline();
+		WaitForScenePipeline();
+	}
+
+}
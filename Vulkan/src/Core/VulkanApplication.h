@@ -1,19 +1,66 @@
 #pragma once
 
 #define GLFW_INCLUDE_VULKAN
-#define GLFW_EXPOSE_NATIVE_WIN32
 #include <GLFW/glfw3.h>
-#include <glfw/glfw3native.h>
+
+#ifdef _WIN32
+	#define GLFW_EXPOSE_NATIVE_WIN32
+	#include <GLFW/glfw3native.h>
+#endif
 
 #include <string>
 #include <vector>
 #include <array>
 #include <optional>
+#include <functional>
+#include <memory>
+#include <atomic>
 
 #include <glm/glm.hpp>
 
+#include "MemoryAllocator.h"
+#include "UploadManager.h"
+#include "PipelineCache.h"
+#include "DeviceSelector.h"
+#include "ThreadPool.h"
+#include "StartupGraph.h"
+#include "Profiler.h"
+#include "QueueTimeline.h"
+#include "FramePacer.h"
+#include "GpuCuller.h"
+#include "Mesh.h"
+#include "VertexQuantization.h"
+#include "VertexLayout.h"
+#include "ShaderReflection.h"
+#include "ShaderWatcher.h"
+#include "PipelineCompiler.h"
+#include "AssetPack.h"
+#include "BindlessHeap.h"
+#include "TextureStreamer.h"
+#include "UniformRing.h"
+#include "RenderGraph.h"
+
 #define ENABLE_VALIDATION_LAYERS true
-#define MAX_FRAMES_IN_FLIGHT 2
+#define MAX_FRAMES_IN_FLIGHT 4
+#define DRAWS_PER_RECORDING_JOB 512
+#define INSTANCES_PER_UPDATE_JOB 16384
+#define INSTANCING_BENCH_MAX_INSTANCES 1000000
+#define INSTANCING_BENCH_FRAMES 16
+#define VERTEX_BENCH_FRAMES 64
+#define TEXTURE_BENCH_COUNT 64
+#define TEXTURE_BENCH_VISIBLE 8
+#define TEXTURE_BENCH_FRAMES 480
+#define DEPTH_BENCH_LAYERS 8
+#define DEPTH_BENCH_FRAMES 240
+
+#define SHADER_DIRECTORY "assets/shaders"
+#define SCENE_VERTEX_SHADER "vert.spv"
+#define SCENE_FRAGMENT_SHADER "frag.spv"
+#define CULL_SHADER "cull.spv"
+#define SCENE_VERTEX_SOURCE "raw/base.vert"
+#define SCENE_FRAGMENT_SOURCE "raw/base.frag"
+#define CULL_SOURCE "raw/cull.comp"
+#define SCENE_MESH_ASSET "scene.mesh"
 
 namespace Vulkan {
 
@@ -21,39 +68,86 @@ namespace Vulkan {
 // Data Structures
 //////////////////////////////////////////////////////////////////////////////////
 
+	// Float source layout, uploaded as is or quantized into QuantizedVertex
 	struct Vertex
 	{
-		glm::vec2 Position;
+		glm::vec3 Position;
 		glm::vec3 Color;
+		glm::vec3 Normal;
+	};
 
-		static VkVertexInputBindingDescription GetBindingDescription()
-		{
-			VkVertexInputBindingDescription bindingDescription{};
-			bindingDescription.binding = 0;
-			bindingDescription.stride = sizeof(Vertex);
-			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-
-			return bindingDescription;
-		}
+	// Per-instance stream, rewritten every frame
+	struct InstanceData
+	{
+		// xy offset, z scale, w rotation in radians
+		glm::vec4 Transform;
+		glm::vec4 Color;
+		// Index into the frame's material buffer
+		uint32_t MaterialID;
+	};
 
-		static std::array<VkVertexInputAttributeDescription, 2> GetAttributeDescriptions()
-		{
-			std::array<VkVertexInputAttributeDescription, 2> attributeDescriptions{};
+	struct Material
+	{
+		glm::vec4 Color;
+		TextureHandle Texture;
+	};
 
-			attributeDescriptions[0].binding = 0;
-			attributeDescriptions[0].location = 0;
-			attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
-			attributeDescriptions[0].offset = offsetof(Vertex, Position);
+	// std430 layout of the shaders' Material, texture handles resolved to bindless slots
+	struct MaterialData
+	{
+		glm::vec4 Color;
+		uint32_t TextureIndex;
+		uint32_t Padding[3];
+	};
 
-			attributeDescriptions[1].binding = 0;
-			attributeDescriptions[1].location = 1;
-			attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-			attributeDescriptions[1].offset = offsetof(Vertex, Color);
+	// std140 layout of the shaders' Frame block, allocated from the uniform ring every frame
+	struct FrameConstants
+	{
+		// Pan and zoom, see m_View
+		glm::vec4 View;
+		// Bindless buffer slot of the frame's materials
+		uint32_t MaterialBuffer;
+		// Maps mesh z into the instance's depth layer, 1 / mesh radius
+		float DepthScale;
+		uint32_t Padding;
+	};
 
-			return attributeDescriptions;
-		}
+	// Scene push constant block, pushed per draw
+	struct DrawConstants
+	{
+		// xy offset, z scale, applied after the instance transform. w offsets depth, nearer when negative
+		glm::vec4 Transform;
 	};
 
+	// The smallest maxPushConstantsSize the spec allows
+	static_assert(sizeof(DrawConstants) <= 128, "Draw constants exceed the guaranteed push constant size");
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Vertex Layouts
+	//////////////////////////////////////////////////////////////////////////////////
+
+	using FloatVertexLayout = VertexLayout<Vertex, 0, VK_VERTEX_INPUT_RATE_VERTEX,
+		VERTEX_ATTRIBUTE(Vertex, Position, 0),
+		VERTEX_ATTRIBUTE(Vertex, Color, 1),
+		VERTEX_ATTRIBUTE(Vertex, Normal, 5)>;
+
+	// The shader reads floats either way, the input assembler expands the normalized formats
+	template<VkFormat PositionFormat>
+	using QuantizedVertexLayout = VertexLayout<QuantizedVertex, 0, VK_VERTEX_INPUT_RATE_VERTEX,
+		VERTEX_ATTRIBUTE_FORMAT(QuantizedVertex, Position, 0, PositionFormat),
+		VERTEX_ATTRIBUTE_FORMAT(QuantizedVertex, Color, 1, VK_FORMAT_R8G8B8A8_UNORM),
+		VERTEX_ATTRIBUTE_FORMAT(QuantizedVertex, Normal, 5, VK_FORMAT_R8G8_SNORM)>;
+
+	using InstanceLayout = VertexLayout<InstanceData, 1, VK_VERTEX_INPUT_RATE_INSTANCE,
+		VERTEX_ATTRIBUTE(InstanceData, Transform, 2),
+		VERTEX_ATTRIBUTE(InstanceData, Color, 3),
+		VERTEX_ATTRIBUTE(InstanceData, MaterialID, 4)>;
+
+	// Scene pipeline inputs per vertex encoding
+	using FloatVertexInput = VertexInputState<FloatVertexLayout, InstanceLayout>;
+	using HalfVertexInput = VertexInputState<QuantizedVertexLayout<VK_FORMAT_R16G16B16A16_SFLOAT>, InstanceLayout>;
+	using SnormVertexInput = VertexInputState<QuantizedVertexLayout<VK_FORMAT_R16G16B16A16_SNORM>, InstanceLayout>;
+
 	//////////////////////////////////////////////////////////////////////////////////
 	// Window Properties
 	//////////////////////////////////////////////////////////////////////////////////
@@ -63,8 +157,150 @@ namespace Vulkan {
 		std::string WindowTitle;
 		uint32_t Width, Height;
 
+		// Headless mode renders into offscreen targets and reads them back instead of presenting
+		bool Headless;
+		uint32_t HeadlessFrames;
+
+		// Name of a built-in benchmark to run instead of the render loop
+		std::string Benchmark;
+
+		// OBJ mesh drawn instead of the built-in triangle, optimized on load
+		std::string MeshPath;
+		// Vertex buffer layout, the quantized encodings are 16 bytes per vertex instead of 36
+		VertexEncoding VertexFormat;
+
+		// Baked asset pack, anything it doesn't contain is read from loose files. BakePath writes
+		// the shaders and the mesh into a pack and exits
+		std::string AssetPackPath;
+		std::string BakePath;
+
+		// KTX2 texture sampled by the scene, BC1-7 or RGBA8. TextureBudgetMB caps resident mip chains, 0 is half of device memory
+		std::string TexturePath;
+		uint32_t TextureBudgetMB;
+
+		// Draws the scene depth-only first, so the color pass shades each pixel once with an EQUAL depth test
+		bool DepthPrepass;
+		// Samples per pixel, lowered to what the device supports. Multisampled attachments are transient and resolved within the pass
+		uint32_t MsaaSamples;
+
+		// Pipeline cache file, empty keeps the cache in memory only
+		std::string PipelineCachePath;
+		// Probed device capabilities, empty probes every device on every start
+		std::string DeviceCachePath;
+		// Rebuilds the scene pipeline in the background whenever its SPIR-V changes
+		bool HotReload;
+
+		// Times the scene is drawn per frame and threads recording it, 0 threads uses every core
+		uint32_t DrawCount;
+		// Instances per draw, laid out on a grid covering the target
+		uint32_t InstanceCount;
+		// Culls the instances on the GPU and draws the survivors indirectly, Zoom magnifies the view so some get culled
+		bool GpuCulling;
+		float Zoom;
+		uint32_t RecordingThreads;
+
+		// Profile capture written on exit, .csv or Chrome trace JSON. Empty disables profiling
+		std::string ProfileOutput;
+		// Chrome trace JSON of the initialization tasks, written once the first frame is submitted
+		std::string StartupTracePath;
+		bool PipelineStatistics;
+
+		// Frames the CPU may run ahead of the GPU, 1 to MAX_FRAMES_IN_FLIGHT. Fewer lowers latency, more raises throughput
+		uint32_t FramesInFlight;
+
+		// Picks the present mode, see ChoosePresentMode. TargetFrameRate caps the CPU loop, 0 is unlimited
+		PresentGoal PresentPolicy;
+		double TargetFrameRate;
+
 		WindowProps()
-			: WindowTitle("Vulkan"), Width(1280), Height(720) {}
+			: WindowTitle("Vulkan"), Width(1280), Height(720), Headless(false), HeadlessFrames(600), VertexFormat(VertexEncoding::Float), TextureBudgetMB(0), DepthPrepass(false), MsaaSamples(1), PipelineCachePath("pipeline_cache.bin"), DeviceCachePath("device_profile.bin"), HotReload(false),
+			DrawCount(1), InstanceCount(1), GpuCulling(false), Zoom(1.0f), RecordingThreads(0), PipelineStatistics(false), FramesInFlight(2),
+			PresentPolicy(PresentGoal::Throughput), TargetFrameRate(0.0) {}
+	};
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Headless Targets
+	//////////////////////////////////////////////////////////////////////////////////
+
+	struct OffscreenTarget
+	{
+		VkImage Image = VK_NULL_HANDLE;
+		Allocation ImageAllocation;
+
+		VkBuffer ReadbackBuffer = VK_NULL_HANDLE;
+		Allocation ReadbackAllocation;
+
+		bool Pending = false;
+		uint64_t FrameIndex = 0;
+		uint64_t TimelineValue = 0;
+	};
+
+	using ReadbackCallback = std::function<void(uint64_t frameIndex, const void* data, size_t size)>;
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Frame Resources
+	//////////////////////////////////////////////////////////////////////////////////
+
+	// Command pools are externally synchronized, so every recording thread gets its own
+	struct ThreadCommandPool
+	{
+		VkCommandPool Pool = VK_NULL_HANDLE;
+		std::vector<VkCommandBuffer> SecondaryBuffers;
+		uint32_t UsedBuffers = 0;
+	};
+
+	// Transient pools per frame in flight, reset as a whole once the frame's timeline value is reached
+	struct FrameResources
+	{
+		VkCommandPool PrimaryPool = VK_NULL_HANDLE;
+		VkCommandBuffer PrimaryBuffer = VK_NULL_HANDLE;
+
+		std::vector<ThreadCommandPool> ThreadPools;
+		std::vector<VkCommandBuffer> JobBuffers;
+
+		// Host visible instance stream, only grows
+		VkBuffer InstanceBuffer = VK_NULL_HANDLE;
+		Allocation InstanceAllocation;
+		uint32_t InstanceCapacity = 0;
+
+		// Host visible material table, rewritten every frame since streaming moves textures between bindless slots
+		VkBuffer MaterialBuffer = VK_NULL_HANDLE;
+		Allocation MaterialAllocation;
+		uint32_t MaterialCapacity = 0;
+		uint32_t MaterialBufferIndex = INVALID_BINDLESS_INDEX;
+
+		// Dynamic offset of the frame's FrameConstants in the uniform ring
+		uint32_t ConstantsOffset = 0;
+
+		// Graphics timeline value signaled by the frame's last submission
+		uint64_t TimelineValue = 0;
+	};
+
+	// Geometry the vertex and index buffers are built from, in m_Verticies and m_Indicies or in the mapped asset pack
+	struct MeshView
+	{
+		const Vertex* Vertices = nullptr;
+		uint32_t VertexCount = 0;
+
+		const void* Indices = nullptr;
+		uint32_t IndexCount = 0;
+		VkIndexType IndexType = VK_INDEX_TYPE_UINT32;
+	};
+
+	// Indexed, every draw shares the mesh's index buffer
+	struct DrawCommand
+	{
+		VkBuffer VertexBuffer;
+		uint32_t IndexCount;
+		uint32_t FirstIndex;
+		int32_t VertexOffset;
+
+		// Range of the frame's instance stream
+		uint32_t InstanceCount;
+		uint32_t FirstInstance;
+
+		// Pushed as DrawConstants
+		glm::vec4 Transform = glm::vec4(0.0f, 0.0f, 1.0f, 0.0f);
 	};
 
 	//////////////////////////////////////////////////////////////////////////////////
@@ -75,6 +311,7 @@ namespace Vulkan {
 	{
 		std::optional<uint32_t> GraphicsFamily;
 		std::optional<uint32_t> PresentFamily;
+		std::optional<uint32_t> TransferFamily;
 
 		bool IsComplete()
 		{
@@ -105,10 +342,19 @@ namespace Vulkan {
 
 		void Run();
 
+		// Called with every frame read back in headless mode
+		void SetReadbackCallback(const ReadbackCallback& callback) { m_ReadbackCallback = callback; }
+
+		// Offline, writes props.BakePath without creating a window or a device
+		static bool BakeAssetPack(const WindowProps& props);
+
 	private:
 		// Window
 		void CreateApplicationWindow();
 
+		// Instance, debug messenger and surface
+		void CreateInstance();
+
 		// Validation Layers
 		bool CheckValidationLayerSupport();
 		std::vector<const char*> GetRequiredExtensions();
@@ -119,17 +365,10 @@ namespace Vulkan {
 
 		// Physical Devices
 		void PickPhysicalDevice();
-		int RateDeviceSuitability(VkPhysicalDevice device);
-
-		// Queue Families
-		QueueFamilyIndicies FindQueueFamilies(VkPhysicalDevice device);
 
 		// Logical Device
 		void CreateLogicalDevice();
 
-		// Extensions
-		bool CheckDeviceExtensionSupport(VkPhysicalDevice device);
-
 		// Swapchain
 		SwapChainSupportDetails QuerySwapChainSupport(VkPhysicalDevice device);
 		VkSurfaceFormatKHR ChooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
@@ -139,43 +378,105 @@ namespace Vulkan {
 		void CreateSwapchain();
 		void RecreateSwapchain();
 		void CleanupSwapchain();
+		void CleanupPipeline();
 
 		// Image Views
 		void CreateImageViews();
 
-		// Graphics Pipeline
-		VkShaderModule CreateShaderModule(const std::vector<char>& source);
+		// Render Targets
+		VkFormat FindDepthFormat();
+		VkSampleCountFlagBits ChooseSampleCount(uint32_t requested);
+		void CreateRenderTargets();
+		void CleanupRenderTargets();
+
+		// Render Graph, declared again every frame
+		void BuildRenderGraph(uint32_t imageIndex);
 
-		void CreateGraphicsPipeline();
+		// Graphics Pipeline
 		void CreateRenderPass();
 
+		GraphicsPipelineDesc GetScenePipelineDesc(VertexEncoding format) const;
+		GraphicsPipelineDesc GetDepthPipelineDesc(VertexEncoding format) const;
+		// Submits the depth pre-pass pipeline along with the scene pipeline when it is enabled
+		void SubmitScenePipeline();
+		void CancelScenePipelines();
+		void WaitForScenePipeline();
+		// Pipelines collected and geometry uploaded
+		bool IsSceneReady();
+		// Collects finished compiles and destroys retired pipelines, once per frame
+		void UpdatePipelines();
+		// True when new pipelines were swapped in, the depth and scene pipelines only ever change together
+		bool CollectScenePipelines();
+		void SwapPipeline(const char* name, CompiledPipeline& current, CompiledPipeline& pipeline);
+
+		// Shader Hot Reload
+		void OnShadersChanged(const std::vector<std::string>& files);
+
 		// Framebuffers
 		void CreateFrambuffer();
 
 		// Command Buffer
-		void CreateCommandPool();
-		void CreateCommandBuffers();
+		void CreateFrameResources();
+		void CleanupFrameResources();
+
+		void RecordFrame(uint32_t imageIndex);
+		void RecordDrawCommands(VkCommandBuffer commandBuffer, const CompiledPipeline& pipeline, uint32_t firstDraw, uint32_t drawCount);
+		VkCommandBuffer GetSecondaryBuffer(ThreadCommandPool& threadPool);
+
+		// Materials
+		void UpdateMaterials(FrameResources& frame);
+		void UpdateFrameConstants(FrameResources& frame);
+
+		// Instances
+		void UpdateInstances(FrameResources& frame);
+
+		// GPU Culling
+		void CreateGpuCuller();
+		CullParams GetCullParams() const;
 
 		// Vertex Buffers
-		void CreateVertexBuffer();
-		uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+		static bool BuildMesh(const std::string& path, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+		void LoadMesh();
+		// Nothing waits for the uploads, frames draw the scene once their tickets complete
+		UploadTicket CreateVertexBuffer();
+		UploadTicket CreateIndexBuffer();
+
+		// Headless
+		void CreateOffscreenTargets();
+		void CleanupOffscreenTargets();
+		void ConsumeReadback(OffscreenTarget& target);
 
 		// Rendering
 		void CreateSyncObjects();
 
+		// Signals the graphics timeline for the current frame and returns the value
+		uint64_t SubmitFrame(VkSemaphore waitSemaphore, VkSemaphore signalSemaphore);
+
 		void Present();
+		void PresentHeadless();
+
+		void RunHeadless();
+
+		// Benchmarks
+		void RunAllocatorBenchmark();
+		void RunInstancingBenchmark();
+		void RunVertexFormatBenchmark();
+		void RunPipelineBenchmark();
+		void RunTextureBenchmark();
+		void RunDepthBenchmark();
 
 	public:
 		bool framebufferResized = false;
 
 	private:
 		WindowProps m_Properties;
-		GLFWwindow* m_Window;
+		GLFWwindow* m_Window = nullptr;
 
-		size_t m_CurrentFrame = 0;
+		uint32_t m_FramesInFlight;
+		uint32_t m_CurrentFrame = 0;
 
 		const std::vector<const char*> m_ValidationLayers = { "VK_LAYER_KHRONOS_validation" };
-		const std::vector<const char*> m_DeviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+		std::vector<const char*> m_DeviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
 
 		// Vulkan Primitives
 		VkInstance m_Instance;
@@ -183,48 +484,134 @@ namespace Vulkan {
 		VkDebugUtilsMessengerEXT m_DebugMessenger;
 		
 		VkPhysicalDevice m_PhysicalDevice = VK_NULL_HANDLE;
+		DeviceProfile m_DeviceProfile{};
+		QueueFamilyIndicies m_QueueFamilies;
 		VkDevice m_Device;
 
 		VkQueue m_GraphicsQueue;
 		VkQueue m_PresentQueue;
+		VkQueue m_TransferQueue;
+
+		// One timeline per queue, the transfer timeline is only created for a separate transfer queue
+		std::unique_ptr<QueueTimeline> m_GraphicsTimeline;
+		std::unique_ptr<QueueTimeline> m_TransferTimeline;
+
+		std::unique_ptr<MemoryAllocator> m_Allocator;
+		std::unique_ptr<UploadManager> m_UploadManager;
+		std::unique_ptr<PipelineCache> m_PipelineCache;
+		std::unique_ptr<Profiler> m_Profiler;
+		FramePacer m_FramePacer;
 
 		// Vulkan Context
-		VkSurfaceKHR m_Surface;
+		VkSurfaceKHR m_Surface = VK_NULL_HANDLE;
 
-		VkSwapchainKHR m_Swapchain;
+		VkSwapchainKHR m_Swapchain = VK_NULL_HANDLE;
 		std::vector<VkImage> m_SwapchainImages;
 		VkFormat m_SwapchainImageFormat;
 		VkExtent2D m_SwapchainExtent;
 		
 		std::vector<VkImageView> m_SwapchainImageViews;
 
+		// Orders every pass of a frame. Depth and multisampled color are its transient images, shared
+		// by every framebuffer and never stored, so tilers can keep them in on-chip memory
+		std::unique_ptr<RenderGraph> m_RenderGraph;
+		VkFormat m_DepthFormat = VK_FORMAT_UNDEFINED;
+		RenderResource m_DepthTarget = INVALID_RENDER_RESOURCE;
+
+		// Multisampled color resolved into the swapchain image, only with more than one sample
+		VkSampleCountFlagBits m_SampleCount = VK_SAMPLE_COUNT_1_BIT;
+		RenderResource m_ColorTarget = INVALID_RENDER_RESOURCE;
+
 		// Vulkan Pipeline
-		VkPipelineLayout m_PiplineLayout;
-		VkPipeline m_GraphicsPipeline;
+		std::unique_ptr<PipelineCompiler> m_PipelineCompiler;
+		CompiledPipeline m_ScenePipeline;
 		VkRenderPass m_RenderPass;
 
+		// Swapped in between frames once compiled, the old pipeline is retired until its frames complete
+		PipelineHandle m_PendingScenePipeline = INVALID_PIPELINE_HANDLE;
+		// Depth-only pre-pass, only compiled with DepthPrepass
+		CompiledPipeline m_DepthPipeline;
+		PipelineHandle m_PendingDepthPipeline = INVALID_PIPELINE_HANDLE;
+		std::vector<CompiledPipeline> m_RetiredPipelines;
+		bool m_StartupReported = false;
+
+		// Set on the watcher thread, the render loop submits the rebuild
+		std::unique_ptr<ShaderWatcher> m_ShaderWatcher;
+		std::atomic<bool> m_ShaderReloadRequested{ false };
+
 		std::vector<VkFramebuffer> m_SwapchainFramebuffers;
 
-		VkCommandPool m_CommandPool;
-		std::vector<VkCommandBuffer> m_CommandBuffers;
+		std::vector<FrameResources> m_Frames;
+		std::unique_ptr<ThreadPool> m_ThreadPool;
+
+		// Traces initialization until the first frame that draws the scene
+		std::unique_ptr<StartupGraph> m_StartupGraph;
+
+		std::vector<DrawCommand> m_DrawCommands;
+		double m_RecordingMs = 0.0;
+
+		// Instances written to every frame's instance stream
+		uint32_t m_InstanceCount = 1;
+		uint64_t m_AnimationFrame = 0;
+
+		// xy pan and z zoom, clip = (world - pan) * zoom
+		glm::vec4 m_View;
+		float m_MeshRadius = 0.0f;
+
+		// GPU-driven draws replace m_DrawCommands while set, the culler needs drawIndirectCount and drawIndirectFirstInstance
+		std::unique_ptr<GpuCuller> m_GpuCuller;
+		bool m_DrawIndirectCount = false;
+		bool m_GpuDriven = false;
 		
 		// Vulkan Rendering
 		std::vector<VkSemaphore> m_ImageAvailableSemaphore;
 		std::vector<VkSemaphore> m_RenderFinishedSemaphore;
 
-		std::vector<VkFence> m_InFlightFences;
-		std::vector<VkFence> m_ImagesInFlight;
+		// Mapped for the whole run, m_Mesh may point into it
+		std::unique_ptr<AssetPack> m_AssetPack;
+		MeshView m_Mesh;
+
+		// Every texture and material buffer, bound once per command buffer
+		std::unique_ptr<BindlessHeap> m_Bindless;
+		// Per frame constants, set 1 of the scene pipeline
+		std::unique_ptr<UniformRing> m_UniformRing;
+		std::unique_ptr<TextureStreamer> m_TextureStreamer;
+
+		// Instances pick a material by index, each material's texture is touched every frame
+		std::vector<Material> m_Materials;
 
 		// Vulkan Vertex Buffer
 		VkBuffer m_VertexBuffer;
-		VkDeviceMemory m_VertexBufferMemory;
+		Allocation m_VertexBufferAllocation;
+
+		VkBuffer m_IndexBuffer;
+		Allocation m_IndexBufferAllocation;
+		VkIndexType m_IndexType = VK_INDEX_TYPE_UINT32;
+
+		// Upload sources when the mesh is re-encoded, they have to outlive the geometry ticket
+		std::vector<QuantizedVertex> m_QuantizedVertices;
+		std::vector<uint16_t> m_ShortIndices;
+		UploadTicket m_GeometryTicket = 0;
+		bool m_DrawScene = false;
+
+		// Headless Rendering
+		std::vector<OffscreenTarget> m_OffscreenTargets;
+		uint64_t m_HeadlessFrameIndex = 0;
+		uint64_t m_ReadbackBytes = 0;
+		uint64_t m_ReadbackFrames = 0;
+
+		std::vector<uint8_t> m_HostFrame;
+		ReadbackCallback m_ReadbackCallback;
 
 	private:
-		const std::vector<Vertex> m_Verticies = {
-			{ { 0.0f, -0.5f}, {1.0f, 0.0f, 0.0f} },
-			{ { 0.5f,  0.5f}, {0.0f, 1.0f, 0.0f} },
-			{ {-0.5f,  0.5f}, {0.0f, 0.0f, 1.0f} }
+		// Replaced by LoadMesh when an OBJ mesh is given
+		std::vector<Vertex> m_Verticies = {
+			{ { 0.0f, -0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 1.0f} },
+			{ { 0.5f,  0.5f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f} },
+			{ {-0.5f,  0.5f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, 1.0f} }
 		};
+
+		std::vector<uint32_t> m_Indicies = { 0, 1, 2 };
 	};
 
 }
\ No newline at end of file
@@ -1,11 +1,162 @@
 #include <iostream>
+#include <string>
+#include <stdexcept>
 #include "Core/VulkanApplication.h"
 
-int main()
+// Malformed or out of range values leave the setting at its default
+static void ParseValue(const std::string& arg, const std::string& value, uint32_t& result)
 {
-	Vulkan::VulkanApplication* app = new Vulkan::VulkanApplication();
+	try
+	{
+		size_t end;
+		unsigned long long parsed = std::stoull(value, &end);
+		if (end == value.size() && value.find('-') == std::string::npos && parsed <= UINT32_MAX)
+		{
+			result = static_cast<uint32_t>(parsed);
+			return;
+		}
+	}
+	catch (const std::invalid_argument&) {}
+	catch (const std::out_of_range&) {}
+
+	std::cout << "Invalid value for " << arg << ": " << value << std::endl;
+}
+
+static void ParseValue(const std::string& arg, const std::string& value, float& result)
+{
+	try
+	{
+		size_t end;
+		float parsed = std::stof(value, &end);
+		if (end == value.size())
+		{
+			result = parsed;
+			return;
+		}
+	}
+	catch (const std::invalid_argument&) {}
+	catch (const std::out_of_range&) {}
+
+	std::cout << "Invalid value for " << arg << ": " << value << std::endl;
+}
+
+static void ParseValue(const std::string& arg, const std::string& value, double& result)
+{
+	try
+	{
+		size_t end;
+		double parsed = std::stod(value, &end);
+		if (end == value.size())
+		{
+			result = parsed;
+			return;
+		}
+	}
+	catch (const std::invalid_argument&) {}
+	catch (const std::out_of_range&) {}
+
+	std::cout << "Invalid value for " << arg << ": " << value << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	Vulkan::WindowProps props;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+
+		if (arg == "--headless")
+			props.Headless = true;
+		else if (arg == "--frames" && i + 1 < argc)
+			ParseValue(arg, argv[++i], props.HeadlessFrames);
+		else if (arg == "--bench" && i + 1 < argc)
+			props.Benchmark = argv[++i];
+		else if (arg == "--mesh" && i + 1 < argc)
+			props.MeshPath = argv[++i];
+		else if (arg == "--vertex-format" && i + 1 < argc)
+		{
+			std::string format = argv[++i];
+			if (format == "float")
+				props.VertexFormat = Vulkan::VertexEncoding::Float;
+			else if (format == "half")
+				props.VertexFormat = Vulkan::VertexEncoding::Half;
+			else if (format == "snorm")
+				props.VertexFormat = Vulkan::VertexEncoding::Snorm;
+			else
+				std::cout << "Unknown vertex format: " << format << std::endl;
+		}
+		else if (arg == "--texture" && i + 1 < argc)
+			props.TexturePath = argv[++i];
+		else if (arg == "--texture-budget" && i + 1 < argc)
+			ParseValue(arg, argv[++i], props.TextureBudgetMB);
+		else if (arg == "--depth-prepass")
+			props.DepthPrepass = true;
+		else if (arg == "--msaa" && i + 1 < argc)
+			ParseValue(arg, argv[++i], props.MsaaSamples);
+		else if (arg == "--pack" && i + 1 < argc)
+			props.AssetPackPath = argv[++i];
+		else if (arg == "--bake" && i + 1 < argc)
+			props.BakePath = argv[++i];
+		else if (arg == "--pipeline-cache" && i + 1 < argc)
+			props.PipelineCachePath = argv[++i];
+		else if (arg == "--no-pipeline-cache")
+			props.PipelineCachePath.clear();
+		else if (arg == "--device-cache" && i + 1 < argc)
+			props.DeviceCachePath = argv[++i];
+		else if (arg == "--no-device-cache")
+			props.DeviceCachePath.clear();
+		else if (arg == "--hot-reload")
+			props.HotReload = true;
+		else if (arg == "--draws" && i + 1 < argc)
+			ParseValue(arg, argv[++i], props.DrawCount);
+		else if (arg == "--instances" && i + 1 < argc)
+			ParseValue(arg, argv[++i], props.InstanceCount);
+		else if (arg == "--gpu-culling")
+			props.GpuCulling = true;
+		else if (arg == "--zoom" && i + 1 < argc)
+			ParseValue(arg, argv[++i], props.Zoom);
+		else if (arg == "--threads" && i + 1 < argc)
+			ParseValue(arg, argv[++i], props.RecordingThreads);
+		else if (arg == "--profile" && i + 1 < argc)
+			props.ProfileOutput = argv[++i];
+		else if (arg == "--startup-trace" && i + 1 < argc)
+			props.StartupTracePath = argv[++i];
+		else if (arg == "--pipeline-stats")
+			props.PipelineStatistics = true;
+		else if (arg == "--frames-in-flight" && i + 1 < argc)
+			ParseValue(arg, argv[++i], props.FramesInFlight);
+		else if (arg == "--present" && i + 1 < argc)
+		{
+			std::string goal = argv[++i];
+			if (goal == "low-latency")
+				props.PresentPolicy = Vulkan::PresentGoal::LowLatency;
+			else if (goal == "throughput")
+				props.PresentPolicy = Vulkan::PresentGoal::Throughput;
+			else if (goal == "vsync")
+				props.PresentPolicy = Vulkan::PresentGoal::VSync;
+			else if (goal == "adaptive")
+				props.PresentPolicy = Vulkan::PresentGoal::AdaptiveVSync;
+			else
+				std::cout << "Unknown present goal: " << goal << std::endl;
+		}
+		else if (arg == "--fps" && i + 1 < argc)
+			ParseValue(arg, argv[++i], props.TargetFrameRate);
+		else if (arg == "--size" && i + 2 < argc)
+		{
+			ParseValue(arg, argv[++i], props.Width);
+			ParseValue(arg, argv[++i], props.Height);
+		}
+		else
+			std::cout << "Unknown argument: " << arg << std::endl;
+	}
+
+	if (!props.BakePath.empty())
+		return Vulkan::VulkanApplication::BakeAssetPack(props) ? 0 : 1;
+
+	Vulkan::VulkanApplication* app = new Vulkan::VulkanApplication(props);
 
 	app->Run();
 
 	delete app;
-}
\ No newline at end of file
+}
@@ -1,3 +1,4 @@
-C:/VulkanSDK/1.2.148.0/Bin32/glslc.exe ../Vulkan/assets/shaders/raw/base.vert -o ../Vulkan/assets/shaders/vert.spv
-C:/VulkanSDK/1.2.148.0/Bin32/glslc.exe ../Vulkan/assets/shaders/raw/base.frag -o ../Vulkan/assets/shaders/frag.spv
+C:/VulkanSDK/1.2.148.0/Bin32/glslc.exe --target-env=vulkan1.2 ../Vulkan/assets/shaders/raw/base.vert -o ../Vulkan/assets/shaders/vert.spv
+C:/VulkanSDK/1.2.148.0/Bin32/glslc.exe --target-env=vulkan1.2 ../Vulkan/assets/shaders/raw/base.frag -o ../Vulkan/assets/shaders/frag.spv
+C:/VulkanSDK/1.2.148.0/Bin32/glslc.exe --target-env=vulkan1.2 ../Vulkan/assets/shaders/raw/cull.comp -o ../Vulkan/assets/shaders/cull.spv
 pause
\ No newline at end of file